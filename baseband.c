@@ -0,0 +1,170 @@
+//*****************************************************************************
+//
+// baseband.c - Complex mixer and CIC decimator in front of the detectors
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <math.h>
+#include "baseband.h"
+#include "goertzel.h"
+#include "nco.h"
+
+//*****************************************************************************
+// Bits of CIC gain the 32 bit filter has room for above a 16 bit input
+//*****************************************************************************
+#define CIC_GAIN_BITS 16
+
+int baseband_init(struct baseband* bb, uint32_t centre_freq, uint32_t sample_rate, int decimation)
+{
+    uint32_t a = centre_freq, b = sample_rate, t;
+    int i = 0;
+
+    if (!sample_rate || 2 * centre_freq >= sample_rate || decimation < 1 || (decimation & (decimation - 1)))
+        return -1;
+
+    bb->shift = 0;
+    while ((1 << bb->shift) < decimation)
+        bb->shift++;
+    bb->shift *= BASEBAND_CIC_STAGES;
+    if (bb->shift > CIC_GAIN_BITS)
+        return -1;
+
+    // One period of the oscillator is sample_rate / gcd(centre, sample_rate)
+    while (b) {
+        t = a % b;
+        a = b;
+        b = t;
+    }
+    if (sample_rate / a > BASEBAND_LO_SIZE)
+        return -1;
+
+    bb->lo_size = (int)(sample_rate / a);
+    for (i = 0; i < bb->lo_size; i++) {
+        t = (uint32_t)((((uint64_t)i * centre_freq) << 32) / sample_rate);
+        bb->lo_cos[i] = (int16_t)nco_sin(t + 0x40000000u);
+        bb->lo_sin[i] = (int16_t)nco_sin(t);
+    }
+    bb->lo_index = 0;
+    bb->centre_freq = centre_freq;
+    bb->sample_rate = sample_rate;
+    bb->decimation = decimation;
+    baseband_reset(bb);
+
+    return 0;
+}
+
+void baseband_reset(struct baseband* bb)
+{
+    int s = 0;
+
+    bb->count = 0;
+    for (s = 0; s < BASEBAND_CIC_STAGES; s++)
+        bb->integ_re[s] = bb->integ_im[s] = bb->comb_re[s] = bb->comb_im[s] = 0;
+}
+
+int baseband_process(struct baseband* bb, const int16_t* data, int sz, int16_t* re, int16_t* im)
+{
+    uint32_t integ_re[BASEBAND_CIC_STAGES], integ_im[BASEBAND_CIC_STAGES];
+    uint32_t x_re, x_im, y;
+    int32_t sum = 0, mean, value;
+    int lo = bb->lo_index, count = bb->count;
+    int i = 0, s = 0, n = 0;
+
+    if (sz <= 0)
+        return 0;
+
+    for (i = 0; i < sz; i++)
+        sum += data[i];
+    mean = sum / sz;
+
+    for (s = 0; s < BASEBAND_CIC_STAGES; s++) {
+        integ_re[s] = bb->integ_re[s];
+        integ_im[s] = bb->integ_im[s];
+    }
+
+    for (i = 0; i < sz; i++) {
+        // Times 8 exp(-j centre t), Q15 by 2^12
+        value = data[i] - mean;
+        integ_re[0] += (uint32_t)((value * bb->lo_cos[lo]) >> 12);
+        integ_im[0] -= (uint32_t)((value * bb->lo_sin[lo]) >> 12);
+        if (++lo == bb->lo_size)
+            lo = 0;
+        for (s = 1; s < BASEBAND_CIC_STAGES; s++) {
+            integ_re[s] += integ_re[s - 1];
+            integ_im[s] += integ_im[s - 1];
+        }
+        if (++count < bb->decimation)
+            continue;
+
+        // Combs at the low rate, the wrap arounds of the integrators cancel
+        count = 0;
+        x_re = integ_re[BASEBAND_CIC_STAGES - 1];
+        x_im = integ_im[BASEBAND_CIC_STAGES - 1];
+        for (s = 0; s < BASEBAND_CIC_STAGES; s++) {
+            y = x_re - bb->comb_re[s];
+            bb->comb_re[s] = x_re;
+            x_re = y;
+            y = x_im - bb->comb_im[s];
+            bb->comb_im[s] = x_im;
+            x_im = y;
+        }
+        re[n] = (int16_t)((int32_t)x_re >> bb->shift);
+        im[n] = (int16_t)((int32_t)x_im >> bb->shift);
+        n++;
+    }
+
+    for (s = 0; s < BASEBAND_CIC_STAGES; s++) {
+        bb->integ_re[s] = integ_re[s];
+        bb->integ_im[s] = integ_im[s];
+    }
+    bb->lo_index = lo;
+    bb->count = count;
+
+    return n;
+}
+
+int baseband_tone(const struct baseband* bb, struct baseband_tone* tone, uint32_t freq)
+{
+    double offset = (double)freq - bb->centre_freq;
+    double w = 2.0 * 3.14159265358979 * offset * bb->decimation / bb->sample_rate;
+    double x = 3.14159265358979 * offset / bb->sample_rate;
+    double gain = 1.0;
+
+    if (2.0 * fabs(offset) * bb->decimation >= bb->sample_rate)
+        return -1;
+
+    // CIC response sin(R x) / (R sin(x)) to the power of the stages
+    if (offset != 0)
+        gain = pow(sin(bb->decimation * x) / (bb->decimation * sin(x)), BASEBAND_CIC_STAGES);
+
+    tone->coeff = (int)floor(2.0 * cos(w) * (1 << 14) + 0.5);
+    tone->sin_w = (int)floor(sin(w) * (1 << 14) + 0.5);
+    tone->gain = (int32_t)floor(gain * (1 << 14) + 0.5);
+
+    return 0;
+}
+
+int32_t baseband_amplitude(const int16_t* re, const int16_t* im, int n, const struct baseband_tone* tone)
+{
+    int32_t a_re, a_im, b_re, b_im;
+    int64_t x_re, x_im;
+    uint64_t amplitude;
+
+    if (n <= 0 || tone->gain <= 0)
+        return 0;
+
+    // The bin of re + j im from the bins of both parts
+    goertzel_complex(re, n, tone->coeff, tone->sin_w, &a_re, &a_im);
+    goertzel_complex(im, n, tone->coeff, tone->sin_w, &b_re, &b_im);
+    x_re = (int64_t)a_re - b_im;
+    x_im = (int64_t)a_im + b_re;
+
+    // A tone of amplitude A gives 4 * A * gain * n
+    amplitude = ((uint64_t)goertzel_isqrt64((uint64_t)(x_re * x_re + x_im * x_im)) << (14 + GOERTZEL_AMPLITUDE_SHIFT))
+        / ((uint64_t)4 * n * tone->gain);
+
+    return (amplitude > INT32_MAX) ? INT32_MAX : (int32_t)amplitude;
+}
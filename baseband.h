@@ -0,0 +1,90 @@
+//*****************************************************************************
+//
+// baseband.h - Complex mixer and CIC decimator in front of the detectors
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#ifndef BASEBAND_H_
+#define BASEBAND_H_
+
+#include <stdint.h>
+
+//*****************************************************************************
+// The ADC readings are multiplied by exp(-j 2 pi centre t), which moves the
+// band around the centre frequency down to 0Hz, and decimated by a
+// BASEBAND_CIC_STAGES stage CIC filter to sample_rate / decimation complex
+// samples. Tones within sample_rate / (2 * decimation) of the centre can be
+// detected on the decimated samples for a fraction of the cost at the full
+// rate. The mixer reads a table of one period of the local oscillator,
+// filled from nco_sin(), so the centre has to repeat within
+// BASEBAND_LO_SIZE samples (20800Hz at 51.2kHz does every 32).
+//*****************************************************************************
+#ifndef BASEBAND_CIC_STAGES
+#define BASEBAND_CIC_STAGES 3
+#endif
+#define BASEBAND_LO_SIZE 64
+
+struct baseband {
+    int16_t lo_cos[BASEBAND_LO_SIZE];   // Q15 local oscillator
+    int16_t lo_sin[BASEBAND_LO_SIZE];
+    int lo_size;                        // Samples in one period of it
+    int lo_index;                       // Next entry to mix with
+    uint32_t centre_freq;
+    uint32_t sample_rate;
+    int decimation;                     // Power of two
+    int shift;                          // Takes the CIC gain off
+    int count;                          // Readings into the next output
+    uint32_t integ_re[BASEBAND_CIC_STAGES];  // Integrators, wrap around
+    uint32_t integ_im[BASEBAND_CIC_STAGES];
+    uint32_t comb_re[BASEBAND_CIC_STAGES];   // Last input of each comb
+    uint32_t comb_im[BASEBAND_CIC_STAGES];
+};
+
+//*****************************************************************************
+// A tone to detect on the decimated samples, see baseband_tone()
+//*****************************************************************************
+struct baseband_tone {
+    int coeff;                          // 2*cos(w) in Q14
+    int sin_w;                          // sin(w) in Q14, negative below the centre
+    int32_t gain;                       // CIC response at the tone in Q14
+};
+
+//*****************************************************************************
+// The decimation has to be a power of two whose CIC gain, decimation to the
+// power of BASEBAND_CIC_STAGES, is at most 2^16, so the filter fits 32 bits
+// (up to 32 with 3 stages). Returns -1 if it is not or the centre does not
+// repeat within BASEBAND_LO_SIZE samples.
+//*****************************************************************************
+int baseband_init(struct baseband* bb, uint32_t centre_freq, uint32_t sample_rate, int decimation);
+
+//*****************************************************************************
+// Clear the filter, the oscillator keeps its phase
+//*****************************************************************************
+void baseband_reset(struct baseband* bb);
+
+//*****************************************************************************
+// Mix and decimate sz ADC readings into re and im, which need room for
+// sz / decimation + 1 samples. The mean of the readings is taken off first.
+// The filter carries over between calls, so the readings can come in frames
+// of any length. A tone of amplitude A (ADC counts) comes out with a
+// magnitude of 4 * A times the CIC response at it. Returns the number of
+// samples written.
+//*****************************************************************************
+int baseband_process(struct baseband* bb, const int16_t* data, int sz, int16_t* re, int16_t* im);
+
+//*****************************************************************************
+// Set up the detector of the tone at freq. Returns -1 if it is not within
+// the decimated band.
+//*****************************************************************************
+int baseband_tone(const struct baseband* bb, struct baseband_tone* tone, uint32_t freq);
+
+//*****************************************************************************
+// Amplitude of the tone in n decimated samples, in ADC counts with
+// GOERTZEL_AMPLITUDE_SHIFT fractional bits, as goertzel_window() gives for
+// the same readings at the full rate. The CIC response is taken off.
+//*****************************************************************************
+int32_t baseband_amplitude(const int16_t* re, const int16_t* im, int n, const struct baseband_tone* tone);
+
+#endif // BASEBAND_H_
@@ -0,0 +1,55 @@
+//*****************************************************************************
+//
+// cobs.c - Consistent overhead byte stuffing for binary blocks on the UART
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include "cobs.h"
+
+//*****************************************************************************
+// Every zero becomes the distance to the next one, the first byte is the
+// distance to the first zero
+//*****************************************************************************
+int cobs_encode(const uint8_t* raw, int length, uint8_t* out)
+{
+    int code = 0, i = 0;
+
+    for (i = 0; i < length; i++) {
+        if (raw[i]) {
+            out[i + 1] = raw[i];
+        } else {
+            out[code] = (uint8_t)(i + 1 - code);
+            code = i + 1;
+        }
+    }
+    out[code] = (uint8_t)(length + 1 - code);
+    out[length + 1] = 0;
+
+    return COBS_ENCODED_SIZE(length);
+}
+
+int cobs_decode(const uint8_t* in, int length, uint8_t* raw)
+{
+    int pos = 0, out = 0, code, i = 0;
+
+    if (length < 1 || length > COBS_MAX_BLOCK + 1)
+        return -1;
+
+    while (pos < length) {
+        code = in[pos++];
+        if (!code || pos + code - 1 > length)
+            return -1;
+        for (i = 1; i < code; i++) {
+            if (!in[pos])
+                return -1;
+            raw[out++] = in[pos++];
+        }
+        if (pos < length)
+            raw[out++] = 0;
+    }
+
+    return out;
+}
@@ -0,0 +1,34 @@
+//*****************************************************************************
+//
+// cobs.h - Consistent overhead byte stuffing for binary blocks on the UART
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#ifndef COBS_H_
+#define COBS_H_
+
+#include <stdint.h>
+
+//*****************************************************************************
+// Blocks up to COBS_MAX_BLOCK bytes are encoded with one extra byte and no
+// zeros, then a zero ends them. Console text has no zeros either, so a reader
+// can split binary blocks from the text around them at the zeros.
+//*****************************************************************************
+#define COBS_MAX_BLOCK 254
+#define COBS_ENCODED_SIZE(LENGTH) ((LENGTH) + 2)
+
+//*****************************************************************************
+// Encode length bytes (at most COBS_MAX_BLOCK) followed by the zero, returns
+// COBS_ENCODED_SIZE(length)
+//*****************************************************************************
+int cobs_encode(const uint8_t* raw, int length, uint8_t* out);
+
+//*****************************************************************************
+// Decode length bytes without the zero that ended them, returns the size of
+// the block (length - 1) or -1 if they are not a valid encoding
+//*****************************************************************************
+int cobs_decode(const uint8_t* in, int length, uint8_t* raw);
+
+#endif // COBS_H_
@@ -0,0 +1,209 @@
+//*****************************************************************************
+//
+// console.c - Deferred text output through a lock-free ring
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdarg.h>
+#include <string.h>
+#include "console.h"
+
+//*****************************************************************************
+// Text has to be in the ring before head makes it visible to the transmitter,
+// same rules as the frame queue
+//*****************************************************************************
+#if defined(__TI_ARM__)
+#define CONSOLE_BARRIER() __asm(" dmb")
+#elif defined(__GNUC__)
+#define CONSOLE_BARRIER() __sync_synchronize()
+#else
+#define CONSOLE_BARRIER()
+#endif
+
+void console_init(struct console* con)
+{
+    memset(con, 0, sizeof(*con));
+}
+
+static void copy_in(struct console* con, uint32_t offset, const char* text, int len)
+{
+    uint32_t pos = (con->head + offset) & (CONSOLE_BUFFER_SIZE - 1);
+    int first = CONSOLE_BUFFER_SIZE - pos;
+
+    if (first > len)
+        first = len;
+    memcpy(&con->buffer[pos], text, first);
+    memcpy(con->buffer, text + first, len - first);
+}
+
+//*****************************************************************************
+// Simple formatter, enough for status lines without pulling in the C
+// library's printf
+//*****************************************************************************
+static int format_number(char* out, uint32_t value, int base, int negative, int width, char pad)
+{
+    char digits[11];
+    int count = 0, len = 0;
+
+    do {
+        digits[count++] = "0123456789abcdef"[value % base];
+        value /= base;
+    } while (value);
+
+    if (negative && pad == '0')
+        out[len++] = '-';
+    for (width -= count + negative; width > 0; width--)
+        out[len++] = pad;
+    if (negative && pad != '0')
+        out[len++] = '-';
+    while (count)
+        out[len++] = digits[--count];
+
+    return len;
+}
+
+static int format_line(char* out, const char* format, va_list args)
+{
+    char number[24];
+    const char* text;
+    int len = 0, width, count = 0;
+    int32_t value;
+    char pad;
+
+    for (; *format; format++) {
+        if (*format != '%') {
+            if (len < CONSOLE_LINE_SIZE - 1)
+                out[len++] = *format;
+            continue;
+        }
+
+        format++;
+        pad = ' ';
+        if (*format == '0') {
+            pad = '0';
+            format++;
+        }
+        for (width = 0; *format >= '0' && *format <= '9'; format++)
+            width = width * 10 + *format - '0';
+        if (width > 16)
+            width = 16;
+
+        switch (*format) {
+        case 'c':
+            number[0] = (char)va_arg(args, int);
+            count = 1;
+            text = number;
+            break;
+        case 's':
+            text = va_arg(args, const char*);
+            count = strlen(text);
+            break;
+        case 'd':
+            value = va_arg(args, int32_t);
+            count = format_number(number, (value < 0) ? -(uint32_t)value : (uint32_t)value, 10, value < 0, width, pad);
+            text = number;
+            break;
+        case 'u':
+            count = format_number(number, va_arg(args, uint32_t), 10, 0, width, pad);
+            text = number;
+            break;
+        case 'x':
+            count = format_number(number, va_arg(args, uint32_t), 16, 0, width, pad);
+            text = number;
+            break;
+        case '\0':
+            format--;
+            count = 0;
+            text = number;
+            break;
+        default:
+            number[0] = *format;
+            count = 1;
+            text = number;
+            break;
+        }
+
+        if (count > CONSOLE_LINE_SIZE - 1 - len)
+            count = CONSOLE_LINE_SIZE - 1 - len;
+        memcpy(out + len, text, count);
+        len += count;
+    }
+
+    return len;
+}
+
+int console_write(struct console* con, const char* text, int len)
+{
+    char note[CONSOLE_LINE_SIZE];
+    uint32_t space = CONSOLE_BUFFER_SIZE - (con->head - con->tail);
+    int note_len = 0;
+
+    // Let the reader know output went missing before carrying on
+    if (con->dropped_messages != con->reported_messages) {
+        note_len = format_number(note, con->dropped_messages - con->reported_messages, 10, 0, 0, ' ');
+        memcpy(note + note_len, " messages dropped\n", 18);
+        note_len += 18;
+    }
+
+    if ((uint32_t)(len + note_len) > space) {
+        con->dropped_bytes += len;
+        con->dropped_messages++;
+        return 0;
+    }
+
+    copy_in(con, 0, note, note_len);
+    copy_in(con, note_len, text, len);
+    con->reported_messages = con->dropped_messages;
+    CONSOLE_BARRIER();
+    con->head += note_len + len;
+
+    return len;
+}
+
+int console_space(const struct console* con)
+{
+    int space = CONSOLE_BUFFER_SIZE - (con->head - con->tail);
+
+    return (space > CONSOLE_LINE_SIZE) ? space - CONSOLE_LINE_SIZE : 0;
+}
+
+int console_vprintf(struct console* con, const char* format, va_list args)
+{
+    char line[CONSOLE_LINE_SIZE];
+
+    return console_write(con, line, format_line(line, format, args));
+}
+
+int console_printf(struct console* con, const char* format, ...)
+{
+    va_list args;
+    int len;
+
+    va_start(args, format);
+    len = console_vprintf(con, format, args);
+    va_end(args);
+
+    return len;
+}
+
+int console_pending(struct console* con, const char** data)
+{
+    uint32_t pos = con->tail & (CONSOLE_BUFFER_SIZE - 1);
+    uint32_t waiting = con->head - con->tail;
+
+    CONSOLE_BARRIER();
+    *data = &con->buffer[pos];
+    if (waiting > CONSOLE_BUFFER_SIZE - pos)
+        waiting = CONSOLE_BUFFER_SIZE - pos;
+
+    return waiting;
+}
+
+void console_consume(struct console* con, int len)
+{
+    CONSOLE_BARRIER();
+    con->tail += len;
+}
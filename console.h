@@ -0,0 +1,62 @@
+//*****************************************************************************
+//
+// console.h - Deferred text output through a lock-free ring
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#ifndef CONSOLE_H_
+#define CONSOLE_H_
+
+#include <stdint.h>
+#include <stdarg.h>
+
+//*****************************************************************************
+// Size of the output ring (a power of two) and of the longest single message
+//*****************************************************************************
+#define CONSOLE_BUFFER_SIZE 1024
+#define CONSOLE_LINE_SIZE 96
+
+//*****************************************************************************
+// The main loop writes messages and the transmitter (UART DMA interrupt)
+// drains them, each index has a single writer so neither side ever waits.
+// A message that doesn't fit is dropped as a whole and counted; the next one
+// that fits is preceded by a note of how much went missing.
+//*****************************************************************************
+struct console {
+    char buffer[CONSOLE_BUFFER_SIZE];
+    volatile uint32_t head;             // Bytes written, producer only
+    volatile uint32_t tail;             // Bytes sent, transmitter only
+    volatile uint32_t dropped_bytes;    // Producer only
+    volatile uint32_t dropped_messages;
+    uint32_t reported_messages;         // dropped_messages already noted
+};
+
+void console_init(struct console* con);
+
+//*****************************************************************************
+// Queue len bytes. Returns len, or 0 if they were dropped for lack of space.
+//*****************************************************************************
+int console_write(struct console* con, const char* text, int len);
+
+//*****************************************************************************
+// Bytes that can be written now, less room for a dropped messages note
+//*****************************************************************************
+int console_space(const struct console* con);
+
+//*****************************************************************************
+// Format into the ring, at most CONSOLE_LINE_SIZE - 1 characters. Supports
+// %c, %s, %d, %u and %x with an optional width and 0 flag.
+//*****************************************************************************
+int console_printf(struct console* con, const char* format, ...);
+int console_vprintf(struct console* con, const char* format, va_list args);
+
+//*****************************************************************************
+// Transmitter side: the oldest unsent bytes that are contiguous in memory
+// (for one DMA transfer), and releasing them once they are sent
+//*****************************************************************************
+int console_pending(struct console* con, const char** data);
+void console_consume(struct console* con, int len);
+
+#endif // CONSOLE_H_
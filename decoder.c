@@ -0,0 +1,776 @@
+//*****************************************************************************
+//
+// decoder.c - Hardware independent ultrasonic message decoder
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "goertzel.h"
+#include "decoder.h"
+
+//*****************************************************************************
+// Hop energies of the sync carrier for the newest frame
+//*****************************************************************************
+#define SYNC_ENERGY(dec) (&(dec)->sync_history[SYNC_HISTORY_HOPS - HOPS_PER_FRAME])
+
+//*****************************************************************************
+// Bits kept of the turn between two DPSK frames, so the products of two turns
+// fit in 32 bits, and how quickly the drift estimate follows (1 / (1 <<
+// DPSK_DRIFT_SHIFT) of each new turn)
+//*****************************************************************************
+#define DPSK_TURN_BITS 14
+#define DPSK_DRIFT_SHIFT 2
+
+//*****************************************************************************
+// The bit synchronizer keeps SS_RING_HOPS hop magnitudes, which have to hold
+// a bit pulled 1/64 longer, the window before it and a hop to look for a
+// crossing in. A FRAMES_PER_BIT too large for them does not build.
+//*****************************************************************************
+typedef char bit_fits_sync_ring[((FRAMES_PER_BIT + 1) * HOPS_PER_FRAME + (FRAMES_PER_BIT * HOPS_PER_FRAME) / 64 + 2
+    <= SS_RING_HOPS) ? 1 : -1];
+
+//*****************************************************************************
+// Profiles from the slowest to the fastest, roughly 10 to 1900 bits a second
+//*****************************************************************************
+const struct rate_profile rate_profiles[RATE_NUM_PROFILES] = {
+    { OOK, FEC_NONE, 0 },                           // RATE_DEFAULT
+    { OOK, FEC_CONVOLUTIONAL, 2 },
+    { OOK, FEC_HAMMING, 2 },
+    { OOK, FEC_NONE, 2 },
+    { OOK, FEC_CONVOLUTIONAL, 1 },
+    { OOK, FEC_NONE, 1 },
+    { DBPSK, FEC_NONE, FRAMES_PER_BIT },
+    { DQPSK, FEC_NONE, FRAMES_PER_BIT },
+    { MFSK, FEC_NONE, FRAMES_PER_BIT },
+    { OFDM, FEC_NONE, FRAMES_PER_BIT }
+};
+
+//*****************************************************************************
+// Move a nominal frequency by the ratio the sync carrier moved
+//*****************************************************************************
+static uint32_t scale_freq(uint32_t freq, uint32_t sync_freq)
+{
+    return (uint32_t)(((uint64_t)freq * sync_freq + SYNC_TONE_FREQ / 2) / SYNC_TONE_FREQ);
+}
+
+//*****************************************************************************
+// Point the detectors at new carriers. MFSK tones and the noise reference
+// bins move by the same ratio as the sync carrier did from SYNC_TONE_FREQ.
+// References are rounded to the nearest bin, where the DC offset of the ADC
+// does not leak into them. Tones of the channel plan take their coefficients
+// from its tables, retuned ones are worked out here.
+//*****************************************************************************
+static int tune_carriers(struct decoder* dec, uint32_t sync_freq, uint32_t data_freq)
+{
+    static const uint32_t ref_freqs[NOISE_NUM_REFS] = NOISE_REF_FREQS;
+    int refs[NOISE_NUM_REFS];
+    uint64_t bin;
+    int tone = 0, ref = 0;
+
+    if (freq_plan_detector(&dec->data_detector, data_freq, dec->sample_rate, HOP_SIZE, HOPS_PER_FRAME)
+        || freq_plan_detector(&dec->sync_detector, sync_freq, dec->sample_rate, HOP_SIZE, HOPS_PER_FRAME))
+        return -1;
+
+    for (tone = 0; tone < MFSK_NUM_TONES; tone++)
+        dec->mfsk_coeffs[tone] = freq_plan_coeff(scale_freq(MFSK_BASE_FREQ + tone * MFSK_TONE_SPACING, sync_freq), dec->sample_rate);
+
+    for (ref = 0; ref < NOISE_NUM_REFS; ref++) {
+        bin = ((uint64_t)scale_freq(ref_freqs[ref], sync_freq) * NUM_SAMPLES + dec->sample_rate / 2) / dec->sample_rate;
+        refs[ref] = freq_plan_coeff((uint32_t)((bin * dec->sample_rate + NUM_SAMPLES / 2) / NUM_SAMPLES), dec->sample_rate);
+    }
+    bin = ((uint64_t)scale_freq(OFDM_BASE_FREQ, sync_freq) * NUM_SAMPLES + dec->sample_rate / 2) / dec->sample_rate;
+    dec->ofdm_bin = (int)bin;
+
+    if (noise_floor_tune(&dec->noise, refs, NOISE_NUM_REFS))
+        return -1;
+    if (dec->diversity && diversity_tune(dec->diversity, dec->sample_rate, sync_freq, data_freq, refs, NOISE_NUM_REFS))
+        return -1;
+
+    dec->sync_freq = sync_freq;
+    dec->data_freq = data_freq;
+
+    return 0;
+}
+
+int decoder_init(struct decoder* dec, uint32_t sample_rate, enum MODULATION modulation, decoder_callback callback, void* ctx)
+{
+    if (modulation == OFDM && sample_rate != PLAN_SAMPLE_RATE)
+        return -1;
+
+    memset(dec, 0, sizeof(*dec));
+    dec->sample_rate = sample_rate;
+    dec->modulation = modulation;
+    dec->callback = callback;
+    dec->ctx = ctx;
+    dec->sync_edge = -1;
+    dec->carrier_search = true;
+    dec->energy_gating = true;
+    energy_gate_init(&dec->gate, GATE_HANGOVER_FRAMES);
+    dec->adaptive_threshold = true;
+    dec->rate_switching = true;
+    noise_floor_init(&dec->noise, NOISE_FLOOR_MIN);
+    packet_parser_init(&dec->packet);
+    dec->threshold_on = FIXED_THRESHOLD;
+    dec->threshold_off = FIXED_THRESHOLD;
+
+    if (tune_carriers(dec, SYNC_TONE_FREQ, DATA_TONE_FREQ))
+        return -1;
+    symbol_sync_init(&dec->bit_sync, HOP_SIZE, NUM_SAMPLES, FRAMES_PER_BIT, FIXED_THRESHOLD);
+
+    decoder_reset(dec);
+
+    return 0;
+}
+
+int decoder_set_diversity(struct decoder* dec, struct diversity* div, int channels, enum DIVERSITY_MODE mode)
+{
+    if (dec->modulation == DBPSK || dec->modulation == DQPSK || dec->modulation == OFDM || diversity_init(div, channels, mode, NOISE_FLOOR_MIN))
+        return -1;
+
+    dec->diversity = div;
+    dec->carrier_search = false;
+
+    return tune_carriers(dec, dec->sync_freq, dec->data_freq);
+}
+
+void decoder_reset(struct decoder* dec)
+{
+    if (dec->profile != RATE_DEFAULT) {
+        dec->modulation = dec->default_modulation;
+        dec->coding = dec->default_coding;
+        symbol_sync_rate(&dec->bit_sync, FRAMES_PER_BIT);
+        dec->profile = RATE_DEFAULT;
+    }
+    memset(dec->descriptor, 0, sizeof(dec->descriptor));
+    dec->byte_sync = ONE;
+    dec->transfer_status = 0;
+    dec->frame_count = 0;
+    dec->bit_output_index = 0;
+    dec->data_byte = 0;
+    dec->dpsk_frames = 0;
+    dec->symbol_bits = 0;
+    dec->symbol_bit_count = 0;
+}
+
+//*****************************************************************************
+// Follow the noise floor with this frame and set the detection levels from
+// it. Until the floor has settled they are kept at least at the fixed level.
+//*****************************************************************************
+static void update_thresholds(struct decoder* dec, const int16_t* frame)
+{
+    noise_floor_update(&dec->noise, frame, NUM_SAMPLES);
+
+    if (dec->adaptive_threshold) {
+        dec->threshold_on = noise_floor_threshold(&dec->noise, SNR_ON_SHIFT, true);
+        dec->threshold_off = noise_floor_threshold(&dec->noise, SNR_OFF_SHIFT, false);
+        if (!noise_floor_settled(&dec->noise)) {
+            if (dec->threshold_on < FIXED_THRESHOLD)
+                dec->threshold_on = FIXED_THRESHOLD;
+            if (dec->threshold_off < FIXED_THRESHOLD)
+                dec->threshold_off = FIXED_THRESHOLD;
+        }
+    } else {
+        dec->threshold_on = FIXED_THRESHOLD;
+        dec->threshold_off = FIXED_THRESHOLD;
+    }
+    symbol_sync_threshold(&dec->bit_sync, dec->threshold_on, dec->threshold_off);
+}
+
+//*****************************************************************************
+// Hop energies of the newest frame on the sync and data carriers, combined
+// over the microphones with diversity
+//*****************************************************************************
+static void detect_sync(struct decoder* dec, const int16_t* frame, int* energy)
+{
+    if (dec->diversity)
+        diversity_sync(dec->diversity, energy);
+    else
+        sliding_goertzel_update(&dec->sync_detector, frame, NUM_SAMPLES, energy);
+}
+
+static void detect_data(struct decoder* dec, const int16_t* frame, int* energy)
+{
+    if (dec->diversity)
+        diversity_data(dec->diversity, energy);
+    else
+        sliding_goertzel_update(&dec->data_detector, frame, NUM_SAMPLES, energy);
+}
+
+//*****************************************************************************
+// SNR of the strongest of a set of carrier powers
+//*****************************************************************************
+static int peak_snr(struct decoder* dec, const int* power, int count)
+{
+    int peak = 0, i = 0;
+
+    for (i = 0; i < count; i++) {
+        if (power[i] > peak)
+            peak = power[i];
+    }
+
+    return noise_floor_snr_db(&dec->noise, peak);
+}
+
+//*****************************************************************************
+// Hand on one byte of data. Returns 1 once the message is over.
+//*****************************************************************************
+static int process_byte(struct decoder* dec, uint8_t byte)
+{
+    enum PACKET_STATUS status;
+
+    if (dec->packets) {
+        status = packet_parser_push(&dec->packet, byte);
+        if (status == PACKET_INCOMPLETE)
+            return 0;
+        if (status == PACKET_OK)
+            dec->callback(dec->ctx, DECODER_PACKET, dec->packet.length);
+        else
+            dec->callback(dec->ctx, DECODER_PACKET_REJECTED, status);
+        return 1;
+    }
+
+    if (!byte) { // stop condition
+        dec->callback(dec->ctx, DECODER_END, 0);
+        return 1;
+    }
+    dec->callback(dec->ctx, DECODER_CHAR, byte);
+    return 0;
+}
+
+//*****************************************************************************
+// Shift the bits of an MFSK or DPSK symbol into symbol_bits and hand on every
+// byte they complete
+//*****************************************************************************
+static void push_symbol(struct decoder* dec, int symbol, int bits)
+{
+    char byte = 0;
+
+    dec->symbol_bits = (dec->symbol_bits << bits) | symbol;
+    dec->symbol_bit_count += bits;
+    dec->frame_count++;
+
+    if (dec->symbol_bit_count >= 8) {
+        dec->symbol_bit_count -= 8;
+        byte = (dec->symbol_bits >> dec->symbol_bit_count) & 0xFF;
+
+        if (process_byte(dec, (uint8_t)byte))
+            decoder_reset(dec);
+    }
+}
+
+//*****************************************************************************
+// MFSK data frame: the strongest tone of the bank is the next symbol
+//*****************************************************************************
+static void process_mfsk(struct decoder* dec, const int16_t* frame)
+{
+    int symbol = 0;
+
+    // The tone has been on since the start sequence, it only has to stay on
+    update_thresholds(dec, frame);
+    if (dec->diversity)
+        diversity_bank(dec->diversity, dec->mfsk_coeffs, dec->mfsk_power, MFSK_NUM_TONES);
+    else
+        goertzel_bank16(frame, NUM_SAMPLES, dec->mfsk_coeffs, dec->mfsk_power, MFSK_NUM_TONES);
+    symbol = goertzel_strongest(dec->mfsk_power, MFSK_NUM_TONES, dec->threshold_off);
+    dec->snr_db = peak_snr(dec, dec->mfsk_power, MFSK_NUM_TONES);
+
+    // Every data frame has to carry a tone, silence means we lost the transmitter
+    if (symbol < 0) {
+        dec->callback(dec->ctx, DECODER_SYNC_FAILED, 0);
+        decoder_reset(dec);
+        return;
+    }
+
+    push_symbol(dec, symbol, MFSK_BITS_PER_SYMBOL);
+}
+
+//*****************************************************************************
+// DPSK data frame ending in the bin (re, im). The turn from the last frame
+// less the drift is rounded to the nearest step. Turns are cut down to
+// DPSK_TURN_BITS, only their angle counts.
+//*****************************************************************************
+static void dpsk_symbol(struct decoder* dec, int32_t re, int32_t im, int energy)
+{
+    int steps = (dec->modulation == DQPSK) ? 4 : 2;
+    int bits = (dec->modulation == DQPSK) ? DQPSK_BITS_PER_SYMBOL : DBPSK_BITS_PER_SYMBOL;
+    int64_t turn_re, turn_im, swap;
+    int step = 0, quarter = 0;
+
+    dec->snr_db = noise_floor_snr_db(&dec->noise, energy);
+
+    // The carrier never goes off during a message
+    if (energy < dec->threshold_off) {
+        dec->callback(dec->ctx, DECODER_SYNC_FAILED, 0);
+        decoder_reset(dec);
+        return;
+    }
+
+    turn_re = (int64_t)re * dec->dpsk_re + (int64_t)im * dec->dpsk_im;
+    turn_im = (int64_t)im * dec->dpsk_re - (int64_t)re * dec->dpsk_im;
+    while ((turn_re < 0 ? -turn_re : turn_re) >= (1 << DPSK_TURN_BITS) || (turn_im < 0 ? -turn_im : turn_im) >= (1 << DPSK_TURN_BITS)) {
+        turn_re /= 2;
+        turn_im /= 2;
+    }
+    dec->dpsk_re = re;
+    dec->dpsk_im = im;
+
+    // The first frame is only a reference, the second one the drift
+    if (++dec->dpsk_frames < DPSK_REFERENCE_FRAMES)
+        return;
+    if (dec->dpsk_frames == DPSK_REFERENCE_FRAMES) {
+        dec->drift_re = (int32_t)turn_re;
+        dec->drift_im = (int32_t)turn_im;
+        return;
+    }
+
+    step = goertzel_nearest_phase(turn_re * dec->drift_re + turn_im * dec->drift_im,
+        turn_im * dec->drift_re - turn_re * dec->drift_im, steps);
+
+    // Take the step back out and follow the drift with what is left
+    for (quarter = step * 4 / steps; quarter > 0; quarter--) {
+        swap = turn_re;
+        turn_re = turn_im;
+        turn_im = -swap;
+    }
+    dec->drift_re += (int32_t)(turn_re - dec->drift_re) >> DPSK_DRIFT_SHIFT;
+    dec->drift_im += (int32_t)(turn_im - dec->drift_im) >> DPSK_DRIFT_SHIFT;
+
+    push_symbol(dec, DPSK_GRAY(step), bits);
+}
+
+//*****************************************************************************
+// DPSK frame: the data detector is stopped at the hop where the symbol ends
+// to read the phase, then runs on through the rest of the frame
+//*****************************************************************************
+static void process_dpsk(struct decoder* dec, const int16_t* frame)
+{
+    int split = (dec->dpsk_hop + 1) * HOP_SIZE;
+    int32_t re, im;
+
+    update_thresholds(dec, frame);
+    sliding_goertzel_update(&dec->data_detector, frame, split, dec->data_energy);
+    sliding_goertzel_phasor(&dec->data_detector, &re, &im);
+    sliding_goertzel_update(&dec->data_detector, frame + split, NUM_SAMPLES - split, dec->data_energy + dec->dpsk_hop + 1);
+    dpsk_symbol(dec, re, im, dec->data_energy[dec->dpsk_hop]);
+}
+
+//*****************************************************************************
+// The start byte ended during hop of this frame. The first reference frame
+// ends a frame after the boundary the synchronizer worked out, so its window
+// ends at the hop nearest to that. That is a hop of the next frame unless the
+// byte ended right at the start of this one.
+//*****************************************************************************
+static void start_dpsk(struct decoder* dec, int hop)
+{
+    int32_t boundary = dec->bit_sync.to_end - dec->bit_sync.period;
+    int32_t re, im;
+    int end = hop + HOPS_PER_FRAME + (boundary - HOP_SIZE * 128) / (HOP_SIZE * 256);
+
+    dec->dpsk_hop = end % HOPS_PER_FRAME;
+    dec->dpsk_frames = 0;
+    if (end < HOPS_PER_FRAME) {
+        sliding_goertzel_phasor(&dec->data_detector, &re, &im);
+        dpsk_symbol(dec, re, im, dec->data_energy[dec->dpsk_hop]);
+    }
+}
+
+//*****************************************************************************
+// OFDM symbol in spectrum. The reference bins are among the subcarriers, so
+// the noise floor and levels stay as they were before the message and the
+// pilots have to stay above the level a carrier goes off at.
+//*****************************************************************************
+static void ofdm_symbol(struct decoder* dec)
+{
+    int power = ofdm_demodulate(dec->spectrum, dec->ofdm_bin, dec->ofdm_symbols);
+    int i = 0;
+
+    dec->snr_db = noise_floor_snr_db(&dec->noise, power);
+    if (power < dec->threshold_off) {
+        dec->callback(dec->ctx, DECODER_SYNC_FAILED, 0);
+        decoder_reset(dec);
+        return;
+    }
+
+    // Padding after the end of the message is left alone
+    for (i = 0; i < OFDM_NUM_DATA && dec->byte_sync == COMPLETE; i++)
+        push_symbol(dec, dec->ofdm_symbols[i] ^ ofdm_scramble(&dec->ofdm_scrambler, OFDM_BITS_PER_CARRIER), OFDM_BITS_PER_CARRIER);
+}
+
+//*****************************************************************************
+// OFDM frame: a window that began in the last frame ends in this one. The
+// symbols are longer than a frame, so there is never more than one. Part of
+// a bin off, the subcarriers would leak into each other, so the window is
+// moved down by where the sync carrier was in its bin during the start
+// sequence, scaled to the middle of the subcarriers as a clock error or
+// Doppler shift scales it.
+//*****************************************************************************
+static void process_ofdm(struct decoder* dec, const int16_t* frame)
+{
+    int start = dec->ofdm_start;
+
+    if (start <= 0) {
+        ofdm_load(dec->last_frame + NUM_SAMPLES + start, -start, frame,
+            (int)((int64_t)dec->sync_offset * OFDM_CENTRE_FREQ / dec->sync_freq), dec->spectrum);
+        fft_radix4(dec->spectrum, NUM_SAMPLES);
+        ofdm_symbol(dec);
+        start += OFDM_SYMBOL_SAMPLES;
+    }
+
+    memcpy(dec->last_frame, frame, sizeof(dec->last_frame));
+    dec->ofdm_start = start - NUM_SAMPLES;
+}
+
+//*****************************************************************************
+// The start byte ended during hop of this frame, where the guard of the
+// first symbol begins. Its window is OFDM_WINDOW_OFFSET samples on.
+//*****************************************************************************
+static void start_ofdm(struct decoder* dec, const int16_t* frame, int hop)
+{
+    int32_t boundary = dec->bit_sync.to_end - dec->bit_sync.period;
+
+    dec->ofdm_start = (hop + 1) * HOP_SIZE + boundary / 256 + OFDM_WINDOW_OFFSET - NUM_SAMPLES;
+    dec->ofdm_scrambler = OFDM_DATA_SEED;
+    memcpy(dec->last_frame, frame, sizeof(dec->last_frame));
+}
+
+//*****************************************************************************
+// Descriptor bit sent with the start bit that just ended, from the data
+// carrier in the last window that lies fully inside that bit. Both carriers
+// go out at the same level, so it is placed against the averaged magnitude
+// of the sync carrier's ones, halfway being an erasure.
+//*****************************************************************************
+static void read_descriptor(struct decoder* dec, int energy)
+{
+    int one = dec->bit_sync.one_level;
+    int soft;
+
+    if (dec->bit_output_index >= RATE_DESCRIPTOR_BITS || one <= 0)
+        return;
+
+    soft = (2 * goertzel_isqrt((energy > 0) ? energy : 0) - one) * FEC_SOFT_MAX / one;
+    if (soft > FEC_SOFT_MAX)
+        soft = FEC_SOFT_MAX;
+    dec->descriptor[dec->bit_output_index] = soft;
+}
+
+//*****************************************************************************
+// The start byte is complete, switch to the profile it announced. Returns -1
+// for a profile this decoder can't follow.
+//*****************************************************************************
+static int switch_rate(struct decoder* dec)
+{
+    int index = fec_hamming_decode(dec->descriptor);
+    const struct rate_profile* profile = &rate_profiles[index];
+
+    if (index == RATE_DEFAULT)
+        return 0;
+    if (!profile->frames_per_bit || (profile->modulation == OFDM && dec->sample_rate != PLAN_SAMPLE_RATE)
+        || (dec->diversity && (profile->modulation == DBPSK || profile->modulation == DQPSK || profile->modulation == OFDM)))
+        return -1;
+
+    dec->default_modulation = dec->modulation;
+    dec->default_coding = dec->coding;
+    dec->profile = index;
+    dec->modulation = profile->modulation;
+    dec->coding = profile->coding;
+    fec_decoder_init(&dec->fec, dec->coding);
+    if (dec->modulation == OOK)
+        symbol_sync_rate(&dec->bit_sync, profile->frames_per_bit);
+    dec->callback(dec->ctx, DECODER_RATE, index);
+
+    return 0;
+}
+
+//*****************************************************************************
+// Shift one bit into the byte being assembled and act on complete bytes
+//*****************************************************************************
+static void assemble_bit(struct decoder* dec, int bit)
+{
+    int reset_flags = 0;
+
+    if (bit)
+        dec->data_byte |= 1;
+
+    if (!((dec->bit_output_index + 1) % 8)) {
+        if (dec->byte_sync == ONE) {
+            dec->byte_sync = COMPLETE;
+
+            // Data comes on a different tone, don't compare levels across it
+            symbol_sync_hold(&dec->bit_sync);
+            if (dec->rate_switching && switch_rate(dec)) {
+                dec->callback(dec->ctx, DECODER_SYNC_FAILED, 0);
+                decoder_reset(dec);
+                return;
+            }
+        } else if (dec->byte_sync == COMPLETE) {
+            reset_flags = process_byte(dec, (uint8_t)dec->data_byte);
+        }
+        dec->data_byte = 0;
+    }
+
+    dec->bit_output_index++;
+    dec->data_byte <<= 1;
+
+    if (reset_flags == 1)
+        decoder_reset(dec);
+}
+
+//*****************************************************************************
+// Feed one bit from the symbol synchronizer into the byte state machine.
+// After the start byte the channel bits go through the FEC decoder, which
+// uses the soft value and hands back data bits.
+//*****************************************************************************
+static void process_bit(struct decoder* dec, int bit, int soft)
+{
+    uint8_t bits[FEC_MAX_BITS];
+    int count = 0, i = 0;
+
+    if (dec->byte_sync == COMPLETE && dec->coding != FEC_NONE) {
+        count = fec_decode(&dec->fec, soft, bits);
+        for (i = 0; i < count && dec->transfer_status; i++)
+            assemble_bit(dec, bits[i]);
+        return;
+    }
+
+    if (dec->byte_sync != COMPLETE) {
+        if (dec->byte_sync == ONE && bit) {
+            dec->byte_sync = ZERO;
+        }
+        else if (dec->byte_sync == ZERO && !bit) {
+            dec->byte_sync = ONE;
+        }
+        else {
+            // Not a start sequence after all, look for the next one
+            dec->callback(dec->ctx, DECODER_SYNC_FAILED, 0);
+            decoder_reset(dec);
+            return;
+        }
+    }
+
+    assemble_bit(dec, bit);
+}
+
+//*****************************************************************************
+// Look for the sync carrier in the spectrum of this frame and retune if it is
+// clearly somewhere other than where the detectors are listening. Returns 1
+// after a retune.
+//*****************************************************************************
+static int search_carrier(struct decoder* dec, const int16_t* frame)
+{
+    uint32_t bin_width = dec->sample_rate / NUM_SAMPLES;
+    int first, last, tuned, peak, power;
+    int64_t position;
+    int data_bin;
+
+    // Only rates with whole Hz bins can be retuned to any bin
+    if (dec->sample_rate % NUM_SAMPLES)
+        return 0;
+
+    fft_load(frame, dec->spectrum, NUM_SAMPLES);
+    fft_radix4(dec->spectrum, NUM_SAMPLES);
+
+    first = (SYNC_TONE_FREQ - CARRIER_SEARCH_RANGE) / bin_width;
+    last = (SYNC_TONE_FREQ + CARRIER_SEARCH_RANGE) / bin_width;
+    tuned = dec->sync_freq / bin_width;
+    peak = fft_peak(dec->spectrum, first, last, &power);
+
+    // Leakage of a carrier we are already on doesn't count, it has to beat
+    // the tuned bin by 6dB
+    if (peak == tuned || power < dec->threshold_on || power < 4 * fft_power(dec->spectrum, tuned))
+        return 0;
+
+    // The data carrier is scaled by where exactly in its bin the sync
+    // carrier is, 1/256 bin steps
+    position = (int64_t)peak * 256 + fft_peak_offset(dec->spectrum, peak);
+    data_bin = (int)((DATA_TONE_FREQ * position + SYNC_TONE_FREQ * 128) / ((int64_t)SYNC_TONE_FREQ * 256));
+
+    if (tune_carriers(dec, peak * bin_width, data_bin * bin_width))
+        return 0;
+    dec->callback(dec->ctx, DECODER_RETUNE, dec->sync_freq);
+
+    return 1;
+}
+
+//*****************************************************************************
+// Where in its bin the sync carrier is in a frame the first bit of the start
+// sequence fills
+//*****************************************************************************
+static void measure_offset(struct decoder* dec, const int16_t* frame)
+{
+    fft_load(frame, dec->spectrum, NUM_SAMPLES);
+    fft_radix4(dec->spectrum, NUM_SAMPLES);
+    dec->sync_offset = fft_tone_offset(dec->spectrum, dec->sync_freq / (dec->sample_rate / NUM_SAMPLES));
+}
+
+void decoder_process(struct decoder* dec, const int16_t* frame)
+{
+    int* sync_energy = SYNC_ENERGY(dec);
+    int aligned = 0, edge = 0, hop = 0, bit = 0, descriptor = 0;
+
+    dec->frames++;
+
+    // Every microphone's detectors see every frame, the rest of the decoder
+    // works on the best one
+    if (dec->diversity) {
+        diversity_update(dec->diversity, frame, dec->noise.level);
+        frame += dec->diversity->selected * NUM_SAMPLES;
+    }
+
+    // Once synchronized, MFSK frames are decoded by the tone bank, DPSK
+    // frames by the phase of the data carrier and OFDM symbols by an FFT of
+    // a window across two frames. The sync detector hasn't seen them, so it
+    // starts over when the message ends and needs a whole window before it
+    // can find an edge.
+    if (dec->byte_sync == COMPLETE && dec->modulation != OOK) {
+        if (dec->modulation == MFSK)
+            process_mfsk(dec, frame);
+        else if (dec->modulation == OFDM)
+            process_ofdm(dec, frame);
+        else
+            process_dpsk(dec, frame);
+        if (dec->byte_sync != COMPLETE) {
+            sliding_goertzel_reset(&dec->sync_detector);
+            memset(dec->sync_history, 0, sizeof(dec->sync_history));
+            if (!dec->settling)
+                dec->settling = 1;
+        }
+        return;
+    }
+
+    //Nothing can start in a quiet frame, it only moves the history along.
+    //When the gate opens the previous frame is replayed so the detector
+    //windows reaching back into it are right. The gate stays open until
+    //the noise floor has settled.
+    if (dec->energy_gating && !dec->settling && !dec->transfer_status && dec->sync_edge < 0) {
+        if (!energy_gate_update(&dec->gate, energy_gate_measure(frame, NUM_SAMPLES)) && noise_floor_settled(&dec->noise)) {
+            if (!(dec->frames % NOISE_GATED_INTERVAL))
+                noise_floor_update(&dec->noise, frame, NUM_SAMPLES);
+            memmove(dec->sync_history, dec->sync_history + HOPS_PER_FRAME, (SYNC_HISTORY_HOPS - HOPS_PER_FRAME) * sizeof(int));
+            if (dec->diversity)
+                diversity_sync(dec->diversity, sync_energy);
+            else
+                memset(sync_energy, 0, HOPS_PER_FRAME * sizeof(int));
+            memcpy(dec->last_frame, frame, sizeof(dec->last_frame));
+            dec->gated = true;
+            return;
+        }
+        if (dec->gated && !dec->diversity) {
+            sliding_goertzel_reset(&dec->sync_detector);
+            sliding_goertzel_update(&dec->sync_detector, dec->last_frame, NUM_SAMPLES, sync_energy);
+            dec->gated = false;
+        }
+    }
+
+    update_thresholds(dec, frame);
+
+    //A transmitter that is off frequency is found before its start sequence
+    //reaches the detectors. Replaying the previous frame leaves the history
+    //as it would be had they been on the new carrier all along.
+    if (dec->carrier_search && !dec->transfer_status && dec->sync_edge < 0) {
+        if (search_carrier(dec, frame)) {
+            memset(dec->sync_history, 0, sizeof(dec->sync_history));
+            sliding_goertzel_update(&dec->sync_detector, dec->last_frame, NUM_SAMPLES, sync_energy);
+        }
+        memcpy(dec->last_frame, frame, sizeof(dec->last_frame));
+    }
+
+    //The start condition is an out-of-band 21khz byte, keep the hop energies
+    //of the last SYNC_HISTORY_FRAMES buffers to find where it began
+    memmove(dec->sync_history, dec->sync_history + HOPS_PER_FRAME, (SYNC_HISTORY_HOPS - HOPS_PER_FRAME) * sizeof(int));
+    detect_sync(dec, frame, sync_energy);
+    dec->snr_db = peak_snr(dec, sync_energy, HOPS_PER_FRAME);
+
+    if (!dec->transfer_status) {
+        //if we detect a high bit (transmission starts with double "1"), wait
+        //one more buffer so the whole rising edge is in the history. After
+        //a gap the sync detector needs a whole window of samples first.
+        if (dec->sync_edge < 0) {
+            if (dec->settling) {
+                dec->settling--;
+                return;
+            }
+            edge = sliding_goertzel_edge(sync_energy, HOPS_PER_FRAME, dec->threshold_on);
+            if (edge >= 0)
+                dec->sync_edge = SYNC_HISTORY_HOPS - 2 * HOPS_PER_FRAME + edge;
+            return;
+        }
+
+        // The first bit is FRAMES_PER_BIT frames long, so it fills this one.
+        // Any message might switch to OFDM.
+        if ((dec->modulation == OFDM || dec->rate_switching) && dec->carrier_search)
+            measure_offset(dec, frame);
+
+        // The first bit starts where the window of hop "aligned" begins
+        aligned = sliding_goertzel_align(dec->sync_history, dec->sync_edge, HOPS_PER_FRAME) - HOPS_PER_FRAME;
+        dec->sync_edge = -1;
+        dec->transfer_status = 1;
+        sliding_goertzel_reset(&dec->data_detector);
+        fec_decoder_init(&dec->fec, dec->coding);
+        packet_parser_start(&dec->packet);
+        dec->callback(dec->ctx, DECODER_LOCK, peak_snr(dec, dec->sync_history, SYNC_HISTORY_HOPS));
+
+        // Catch up on the start sequence hops that are already in the history
+        hop = (aligned < 0) ? 0 : aligned + 1;
+        symbol_sync_start(&dec->bit_sync, (aligned + 1 - hop) * HOP_SIZE);
+        for (; hop < SYNC_HISTORY_HOPS && dec->transfer_status; hop++) {
+            bit = symbol_sync_push(&dec->bit_sync, dec->sync_history[hop]);
+            if (bit >= 0)
+                process_bit(dec, bit, dec->bit_sync.soft);
+        }
+        return;
+    }
+
+    //Transfer mode - the synchronizer follows the transmitter clock and
+    //hands over a bit whenever one ends. Start bits also hand over the
+    //descriptor bit sent with them, from the window a hop before their end.
+    descriptor = dec->data_energy[HOPS_PER_FRAME - 1];
+    detect_data(dec, frame, dec->data_energy);
+    if (dec->byte_sync == COMPLETE)
+        dec->snr_db = peak_snr(dec, dec->data_energy, HOPS_PER_FRAME);
+    for (hop = 0; hop < HOPS_PER_FRAME && dec->transfer_status; hop++) {
+        bit = symbol_sync_push(&dec->bit_sync, (dec->byte_sync == COMPLETE) ? dec->data_energy[hop] : sync_energy[hop]);
+        if (bit >= 0 && dec->byte_sync != COMPLETE && dec->rate_switching)
+            read_descriptor(dec, descriptor);
+        if (bit >= 0)
+            process_bit(dec, bit, dec->bit_sync.soft);
+        descriptor = dec->data_energy[hop];
+
+        // MFSK symbols start where the start byte ended. If that was early
+        // in this frame, the frame is mostly the first symbol. DPSK symbols
+        // are read where they end, to the hop, OFDM windows to the sample.
+        if (dec->byte_sync == COMPLETE && dec->modulation != OOK) {
+            if (dec->modulation == OFDM)
+                start_ofdm(dec, frame, hop);
+            else if (dec->modulation != MFSK)
+                start_dpsk(dec, hop);
+            else if (hop < HOPS_PER_FRAME / 2)
+                process_mfsk(dec, frame);
+            return;
+        }
+    }
+}
+
+void decoder_skip(struct decoder* dec, uint32_t frames)
+{
+    if (!frames)
+        return;
+
+    dec->frames += frames;
+    if (dec->transfer_status)
+        dec->callback(dec->ctx, DECODER_SYNC_FAILED, 0);
+
+    decoder_reset(dec);
+    dec->sync_edge = -1;
+    memset(dec->sync_history, 0, sizeof(dec->sync_history));
+    memset(dec->last_frame, 0, sizeof(dec->last_frame));
+    sliding_goertzel_reset(&dec->sync_detector);
+    if (dec->diversity)
+        diversity_reset(dec->diversity);
+    dec->gated = false;
+    if (!dec->settling)
+        dec->settling = 1;
+}
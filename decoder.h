@@ -0,0 +1,278 @@
+//*****************************************************************************
+//
+// decoder.h - Hardware independent ultrasonic message decoder
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#ifndef DECODER_H_
+#define DECODER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sliding_goertzel.h"
+#include "symbol_sync.h"
+#include "fft.h"
+#include "energy_gate.h"
+#include "noise_floor.h"
+#include "fec.h"
+#include "packet.h"
+#include "freq_plan.h"
+#include "diversity.h"
+#include "ofdm.h"
+
+//*****************************************************************************
+// Frame length, tones and their Goertzel coefficients come from the channel
+// plan in freq_plan.h.
+//
+// Streaming detectors for the sync and data carriers. The magnitude of the
+// last NUM_SAMPLES samples is updated every HOP_SIZE samples, so a frame can
+// be lined up with the transmitter to within one hop (2.5ms) instead of
+// whatever offset the DMA buffers happen to have. The start of the first bit
+// is found from the rising edge of the start sequence in sync_history.
+//*****************************************************************************
+#define SYNC_HISTORY_FRAMES 3
+#define SYNC_HISTORY_HOPS (SYNC_HISTORY_FRAMES * HOPS_PER_FRAME)
+
+//*****************************************************************************
+// While waiting for a start sequence every frame is transformed and searched
+// for the sync carrier up to CARRIER_SEARCH_RANGE Hz either side of
+// SYNC_TONE_FREQ. If the transmitter is off frequency the detectors are
+// retuned to it. The data and MFSK tones are scaled by the same ratio, since
+// a clock error moves all of them together.
+//*****************************************************************************
+#define CARRIER_SEARCH_RANGE 500
+
+//*****************************************************************************
+// While waiting for a start sequence, frames that the energy gate finds quiet
+// skip the tone detectors and carrier search. The gate stays open for
+// GATE_HANGOVER_FRAMES after the last loud frame.
+//*****************************************************************************
+#define GATE_HANGOVER_FRAMES 8
+
+//*****************************************************************************
+// Carriers are detected relative to the noise floor measured on reference
+// bins between the tones (which move with the carriers on a retune). A
+// carrier is on once its power is 1 << SNR_ON_SHIFT times the floor (3dB per
+// step) and stays on down to 1 << SNR_OFF_SHIFT times the floor. Clearing
+// adaptive_threshold goes back to the fixed FIXED_THRESHOLD. Frames the
+// energy gate skips still update the floor every NOISE_GATED_INTERVAL frames.
+//*****************************************************************************
+#define NOISE_FLOOR_MIN 1
+#define SNR_ON_SHIFT 4
+#define SNR_OFF_SHIFT 3
+#define FIXED_THRESHOLD 100
+#define NOISE_GATED_INTERVAL 4
+
+//*****************************************************************************
+// Bits are decided by a synchronizer that follows drift of the transmitter
+// clock, so the number of frames per bit no longer has to absorb it
+//*****************************************************************************
+#ifndef FRAMES_PER_BIT
+#define FRAMES_PER_BIT 5
+#endif
+
+//*****************************************************************************
+// Modulation used for the data that follows the start sequence
+//*****************************************************************************
+enum MODULATION {
+    OOK,
+    MFSK,
+    DBPSK,                              // Phase steps of the data carrier, see freq_plan.h
+    DQPSK,
+    OFDM                                // Subcarriers read by an FFT, see freq_plan.h
+};
+
+//*****************************************************************************
+// Rate profiles a transmitter can switch to for one message. While the start
+// byte goes out on the sync carrier, the data carrier sends the number of
+// the profile as a Hamming(7,4) codeword, one bit on each of the first
+// RATE_DESCRIPTOR_BITS start bits (on for a 1). Sending nothing there
+// announces RATE_DEFAULT, which is decoded with the receiver's own
+// modulation and code. Any other profile is used for the rest of the message
+// and the receiver goes back to its own after it. The frame length and
+// sample rate can't change, every tone and detector sits on the bins of a
+// NUM_SAMPLES frame, so a faster profile has fewer frames per OOK bit or
+// more bits per frame. Profiles with frames_per_bit 0 are not assigned.
+//*****************************************************************************
+#define RATE_DEFAULT 0
+#define RATE_NUM_PROFILES 16
+#define RATE_DESCRIPTOR_BITS 7
+
+struct rate_profile {
+    enum MODULATION modulation;
+    enum FEC_CODE coding;               // OOK only
+    int frames_per_bit;                 // OOK only, the other symbols are a frame
+};
+
+extern const struct rate_profile rate_profiles[RATE_NUM_PROFILES];
+
+//*****************************************************************************
+// This enum is used to ensure synchronization with initial bits/frames
+//*****************************************************************************
+enum SYNCHRONIZATION {
+    FAILED = -1,
+    NONE,
+    ONE,
+    ZERO,
+    COMPLETE
+};
+
+//*****************************************************************************
+// Everything the decoder reports goes through a callback, value holds the
+// character for DECODER_CHAR
+//*****************************************************************************
+enum DECODER_EVENT {
+    DECODER_LOCK,                       // value is the SNR of the start sequence in dB
+    DECODER_CHAR,
+    DECODER_END,
+    DECODER_SYNC_FAILED,
+    DECODER_RETUNE,                     // value is the new sync carrier in Hz
+    DECODER_PACKET,                     // value is the payload length, packet holds the rest
+    DECODER_PACKET_REJECTED,            // value is the PACKET_STATUS
+    DECODER_RATE                        // value is the profile the message switched to
+};
+typedef void (*decoder_callback)(void* ctx, enum DECODER_EVENT event, int value);
+
+//*****************************************************************************
+// Complete state of one receiver, there are no globals so any number of
+// streams can be decoded side by side
+//*****************************************************************************
+struct decoder {
+    uint32_t sample_rate;
+    enum MODULATION modulation;
+    decoder_callback callback;
+    void* ctx;
+    uint32_t frames;                    // Frames processed since init
+
+    // Store data for the frames and bytes collected
+    bool transfer_status;
+    int bit_output_index;
+    int frame_count;
+    char data_byte;
+    enum SYNCHRONIZATION byte_sync;
+
+    struct sliding_goertzel data_detector;
+    struct sliding_goertzel sync_detector;
+    int data_energy[HOPS_PER_FRAME];
+    int sync_history[SYNC_HISTORY_HOPS];
+    int sync_edge;
+    struct symbol_sync bit_sync;
+
+    // OOK data after the start byte is decoded with this code, the trellis
+    // starts over with every message
+    enum FEC_CODE coding;
+    struct fec_decoder fec;
+
+    // With packets set the data is one packet instead of text up to a zero
+    // byte, the parser also counts the packets that were rejected
+    bool packets;
+    struct packet_parser packet;
+
+    int mfsk_coeffs[MFSK_NUM_TONES];
+    int mfsk_power[MFSK_NUM_TONES];
+
+    // DBPSK and DQPSK symbols are read from the data detector at the hop
+    // where they end, the drift is the turn of a frame without a step
+    int dpsk_hop;
+    int dpsk_frames;                    // Frames read, the references included
+    int32_t dpsk_re, dpsk_im;           // Bin of the last frame
+    int32_t drift_re, drift_im;
+
+    // OFDM windows are put together from the end of last_frame and the start
+    // of the new frame, spectrum holds their transform. ofdm_start is where
+    // the next one starts from the start of the next frame, the subcarriers
+    // begin at ofdm_bin.
+    int ofdm_start;
+    int ofdm_bin;
+    uint8_t ofdm_scrambler;
+    uint8_t ofdm_symbols[OFDM_NUM_DATA];
+
+    // With rate_switching set the descriptor is read along with the start
+    // byte. While a profile is in force, the configured modulation and code
+    // are kept in default_modulation and default_coding.
+    bool rate_switching;
+    int descriptor[RATE_DESCRIPTOR_BITS];   // Soft values of the codeword
+    int profile;
+    enum MODULATION default_modulation;
+    enum FEC_CODE default_coding;
+
+    // Bits of MFSK, DPSK and OFDM symbols waiting to make up a byte
+    uint32_t symbol_bits;
+    int symbol_bit_count;
+
+    // Carrier search, the last frame is kept to replay it after a retune.
+    // sync_offset is where in its bin the sync carrier was at the start of
+    // an OFDM message, in 1/256ths of a bin.
+    bool carrier_search;
+    uint32_t sync_freq;
+    uint32_t data_freq;
+    int sync_offset;
+    int16_t last_frame[NUM_SAMPLES];
+    int16_t spectrum[2 * NUM_SAMPLES];
+
+    // Detection levels, from the noise floor unless adaptive_threshold is cleared
+    bool adaptive_threshold;
+    struct noise_floor noise;
+    int threshold_on;
+    int threshold_off;
+    int snr_db;                         // Carrier over the floor in the newest frame
+    int settling;                       // Frames before a start sequence is looked for again
+
+    // Quiet frames are only measured, not searched
+    bool energy_gating;
+    bool gated;                         // The last frame was skipped
+    struct energy_gate gate;
+
+    // Several microphones, see decoder_set_diversity()
+    struct diversity* diversity;
+};
+
+//*****************************************************************************
+// Set up a decoder for the given sampling rate. Returns -1 if the carriers do
+// not fall on a bin of a NUM_SAMPLES frame at that rate, or for OFDM at any
+// rate but PLAN_SAMPLE_RATE (its subcarriers are a bin apart). Carrier search,
+// energy gating and adaptive thresholds are on, clear carrier_search to stay
+// on the nominal frequencies, energy_gating to search every frame or
+// adaptive_threshold to detect carriers at FIXED_THRESHOLD. OOK data is not
+// coded unless coding is set to one of the FEC codes, and is text unless
+// packets is set. Rate switching is on, clear rate_switching to ignore
+// descriptors. A message that announces OFDM at a rate OFDM can't be set up
+// for fails to synchronize.
+//*****************************************************************************
+int decoder_init(struct decoder* dec, uint32_t sample_rate, enum MODULATION modulation, decoder_callback callback, void* ctx);
+
+//*****************************************************************************
+// Decode channels microphones at once (2 to DIVERSITY_MAX_CHANNELS), with
+// their carrier energies combined by mode before every decision. div is the
+// state for them and has to live as long as the decoder. A frame is then one
+// frame of each microphone one after the other. The decoder's noise floor,
+// energy gate and flight recorder follow the best microphone. The detectors
+// can't be replayed on every microphone after a retune, so carrier search is
+// turned off. Returns -1 if channels is out of range, or for DBPSK, DQPSK and
+// OFDM, whose phase differs from one microphone to the next. Messages that
+// announce one of those fail to synchronize.
+//*****************************************************************************
+int decoder_set_diversity(struct decoder* dec, struct diversity* div, int channels, enum DIVERSITY_MODE mode);
+
+//*****************************************************************************
+// Return to waiting for a start sequence, with the configured modulation and
+// code if a message switched them
+//*****************************************************************************
+void decoder_reset(struct decoder* dec);
+
+//*****************************************************************************
+// Decode one frame of NUM_SAMPLES 12 bit ADC samples (of every microphone
+// with diversity)
+//*****************************************************************************
+void decoder_process(struct decoder* dec, const int16_t* frame);
+
+//*****************************************************************************
+// Account for frames that were lost before reaching the decoder. Bit timing
+// can't survive a gap, so a message in progress is given up on
+// (DECODER_SYNC_FAILED) and the decoder waits for the next start sequence.
+//*****************************************************************************
+void decoder_skip(struct decoder* dec, uint32_t frames);
+
+#endif // DECODER_H_
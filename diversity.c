@@ -0,0 +1,228 @@
+//*****************************************************************************
+//
+// diversity.c - Combine the carrier energies of several microphones
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <string.h>
+#include "goertzel.h"
+#include "diversity.h"
+
+//*****************************************************************************
+// Largest SNR a microphone is weighed with, in Q8, so the sum of all of them
+// stays in 32 bits
+//*****************************************************************************
+#define SNR_LIMIT (1u << 24)
+
+void diversity_deinterleave(int16_t* samples, int channels, int count)
+{
+    uint32_t last = (uint32_t)channels * count - 1, start, next;
+    int16_t carry, swap;
+
+    if (channels < 2)
+        return;
+
+    // Reading s of microphone c moves from s * channels + c to c * count + s,
+    // which is index * count modulo last. Each cycle of that permutation is
+    // walked once, from its smallest index; the short test costs less than
+    // marking visited readings would take memory.
+    for (start = 1; start < last; start++) {
+        for (next = (start * count) % last; next > start; next = (next * count) % last)
+            ;
+        if (next < start)
+            continue;
+
+        carry = samples[start];
+        next = start;
+        do {
+            next = (next * count) % last;
+            swap = samples[next];
+            samples[next] = carry;
+            carry = swap;
+        } while (next != start);
+    }
+}
+
+int diversity_init(struct diversity* div, int channels, enum DIVERSITY_MODE mode, int noise_minimum)
+{
+    int c = 0;
+
+    if (channels < 2 || channels > DIVERSITY_MAX_CHANNELS)
+        return -1;
+
+    memset(div, 0, sizeof(*div));
+    div->channels = channels;
+    div->mode = mode;
+    for (c = 0; c < channels; c++)
+        noise_floor_init(&div->branch[c].noise, noise_minimum);
+
+    return 0;
+}
+
+int diversity_tune(struct diversity* div, uint32_t sample_rate, uint32_t sync_freq, uint32_t data_freq,
+    const int* refs, int num_refs)
+{
+    struct diversity_branch* branch;
+    int c = 0;
+
+    for (c = 0; c < div->channels; c++) {
+        branch = &div->branch[c];
+        if (freq_plan_detector(&branch->sync_detector, sync_freq, sample_rate, HOP_SIZE, HOPS_PER_FRAME)
+            || freq_plan_detector(&branch->data_detector, data_freq, sample_rate, HOP_SIZE, HOPS_PER_FRAME)
+            || noise_floor_tune(&branch->noise, refs, num_refs))
+            return -1;
+    }
+
+    return 0;
+}
+
+void diversity_reset(struct diversity* div)
+{
+    int c = 0;
+
+    for (c = 0; c < div->channels; c++) {
+        sliding_goertzel_reset(&div->branch[c].sync_detector);
+        sliding_goertzel_reset(&div->branch[c].data_detector);
+    }
+}
+
+//*****************************************************************************
+// Carrier estimate of a microphone, jumps up to a new peak and decays within
+// a few frames so a blocked microphone loses its weight quickly. Silence in
+// OOK data decays every microphone alike and leaves their order alone.
+//*****************************************************************************
+static void track_signal(struct diversity_branch* branch, const int* power, int count)
+{
+    uint32_t peak = 0;
+    int i = 0;
+
+    for (i = 0; i < count; i++) {
+        if (power[i] > 0 && (uint32_t)power[i] > peak)
+            peak = (uint32_t)power[i];
+    }
+
+    if (peak > branch->signal)
+        branch->signal = peak;
+}
+
+void diversity_update(struct diversity* div, const int16_t* frames, uint32_t reference)
+{
+    struct diversity_branch* branch;
+    const int16_t* frame;
+    int c = 0;
+
+    div->frames = frames;
+    for (c = 0; c < div->channels; c++) {
+        branch = &div->branch[c];
+        frame = frames + c * NUM_SAMPLES;
+
+        sliding_goertzel_update(&branch->sync_detector, frame, NUM_SAMPLES, branch->sync_energy);
+        sliding_goertzel_update(&branch->data_detector, frame, NUM_SAMPLES, branch->data_energy);
+        noise_floor_update(&branch->noise, frame, NUM_SAMPLES);
+
+        branch->signal -= branch->signal >> DIVERSITY_DECAY_SHIFT;
+        track_signal(branch, branch->sync_energy, HOPS_PER_FRAME);
+        track_signal(branch, branch->data_energy, HOPS_PER_FRAME);
+    }
+
+    diversity_weigh(div, reference);
+}
+
+//*****************************************************************************
+// Floor of a microphone in the noise_floor format, never below its minimum
+//*****************************************************************************
+static uint32_t branch_floor(const struct diversity_branch* branch)
+{
+    if (branch->noise.level < branch->noise.minimum)
+        return branch->noise.minimum ? branch->noise.minimum : 1;
+
+    return branch->noise.level ? branch->noise.level : 1;
+}
+
+void diversity_weigh(struct diversity* div, uint32_t reference)
+{
+    uint32_t snr[DIVERSITY_MAX_CHANNELS] = { 0 }, weight[DIVERSITY_MAX_CHANNELS], total = 0;
+    uint64_t ratio, gain;
+    int c = 0, best = 0;
+
+    div->reference = reference;
+
+    // Carrier over floor in Q8, less the noise in the carrier estimate
+    for (c = 0; c < div->channels; c++) {
+        ratio = ((uint64_t)div->branch[c].signal << (2 * NF_FRACTION_BITS)) / branch_floor(&div->branch[c]);
+        snr[c] = (ratio <= 256) ? 0 : (ratio - 256 > SNR_LIMIT) ? SNR_LIMIT : (uint32_t)(ratio - 256);
+        total += snr[c];
+        if (snr[c] > snr[best])
+            best = c;
+    }
+
+    if (snr[best] > (snr[div->selected] << DIVERSITY_SWITCH_SHIFT))
+        div->selected = best;
+
+    for (c = 0; c < div->channels; c++) {
+        if (div->mode == DIVERSITY_SELECTION)
+            weight[c] = (c == div->selected) ? 65536 : 0;
+        else if (total)
+            weight[c] = (uint32_t)(((uint64_t)snr[c] << 16) / total);
+        else
+            weight[c] = 65536 / div->channels;
+
+        gain = (uint64_t)weight[c] * reference / branch_floor(&div->branch[c]);
+        div->gain[c] = (gain > UINT32_MAX) ? UINT32_MAX : (uint32_t)gain;
+    }
+}
+
+void diversity_combine(const struct diversity* div, const int* const* traces, int count, int* out)
+{
+    int64_t sum;
+    int c = 0, i = 0;
+
+    for (i = 0; i < count; i++) {
+        sum = 0;
+        for (c = 0; c < div->channels; c++)
+            sum += ((int64_t)traces[c][i] * div->gain[c]) >> 16;
+        out[i] = (sum > INT32_MAX) ? INT32_MAX : (sum < INT32_MIN) ? INT32_MIN : (int)sum;
+    }
+}
+
+void diversity_sync(const struct diversity* div, int* energy)
+{
+    const int* traces[DIVERSITY_MAX_CHANNELS];
+    int c = 0;
+
+    for (c = 0; c < div->channels; c++)
+        traces[c] = div->branch[c].sync_energy;
+    diversity_combine(div, traces, HOPS_PER_FRAME, energy);
+}
+
+void diversity_data(const struct diversity* div, int* energy)
+{
+    const int* traces[DIVERSITY_MAX_CHANNELS];
+    int c = 0;
+
+    for (c = 0; c < div->channels; c++)
+        traces[c] = div->branch[c].data_energy;
+    diversity_combine(div, traces, HOPS_PER_FRAME, energy);
+}
+
+void diversity_bank(struct diversity* div, const int* coeffs, int* power, int num_bins)
+{
+    const int* traces[DIVERSITY_MAX_CHANNELS];
+    int c = 0;
+
+    if (num_bins > MFSK_NUM_TONES)
+        num_bins = MFSK_NUM_TONES;
+
+    for (c = 0; c < div->channels; c++) {
+        goertzel_bank16(div->frames + c * NUM_SAMPLES, NUM_SAMPLES, coeffs, div->branch[c].bank_power, num_bins);
+        track_signal(&div->branch[c], div->branch[c].bank_power, num_bins);
+        traces[c] = div->branch[c].bank_power;
+    }
+
+    // MFSK tones are off the carriers, weigh again with them
+    diversity_weigh(div, div->reference);
+    diversity_combine(div, traces, num_bins, power);
+}
@@ -0,0 +1,119 @@
+//*****************************************************************************
+//
+// diversity.h - Combine the carrier energies of several microphones
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#ifndef DIVERSITY_H_
+#define DIVERSITY_H_
+
+#include <stdint.h>
+#include "sliding_goertzel.h"
+#include "noise_floor.h"
+#include "freq_plan.h"
+
+//*****************************************************************************
+// Microphones one ADC sequence can take, how fast the carrier estimate of a
+// microphone decays (1 / (1 << DIVERSITY_DECAY_SHIFT) per frame) and how much
+// better another microphone has to be before selection moves to it
+// (1 << DIVERSITY_SWITCH_SHIFT times the SNR, 3dB)
+//*****************************************************************************
+#define DIVERSITY_MAX_CHANNELS 4
+#define DIVERSITY_DECAY_SHIFT 1
+#define DIVERSITY_SWITCH_SHIFT 1
+
+enum DIVERSITY_MODE {
+    DIVERSITY_SELECTION,                // Only the microphone with the best SNR
+    DIVERSITY_MAX_RATIO                 // Every microphone, weighted by its SNR
+};
+
+//*****************************************************************************
+// Detectors and noise floor of one microphone. They run on every frame, so
+// unlike the decoder's own detectors nothing has to be replayed when the
+// energy gate opens.
+//*****************************************************************************
+struct diversity_branch {
+    struct sliding_goertzel sync_detector;
+    struct sliding_goertzel data_detector;
+    struct noise_floor noise;
+    int sync_energy[HOPS_PER_FRAME];
+    int data_energy[HOPS_PER_FRAME];
+    int bank_power[MFSK_NUM_TONES];     // Tone bank of the newest frame, too big for the stack
+    uint32_t signal;                    // Strongest recent carrier energy
+};
+
+//*****************************************************************************
+// Every microphone's energies are divided by its own noise floor and the
+// weighted sum is scaled back to a reference floor, the decoder's, so the
+// decoder's thresholds hold for the combined energies. Selection gives the
+// best microphone all the weight. Max ratio weights each microphone by its
+// SNR, so a blocked one fades out instead of adding noise.
+//*****************************************************************************
+struct diversity {
+    int channels;
+    enum DIVERSITY_MODE mode;
+    int selected;                       // Best microphone, the decoder follows its frame
+    uint32_t gain[DIVERSITY_MAX_CHANNELS];  // Q16 factor on each microphone's energies
+    uint32_t reference;                 // Floor the gains scale to
+    const int16_t* frames;              // Frames of the newest update
+    struct diversity_branch branch[DIVERSITY_MAX_CHANNELS];
+};
+
+//*****************************************************************************
+// The ADC sequence takes one reading of every microphone in turn, so count
+// readings of each arrive interleaved. Sort them in place into one frame per
+// microphone, one after the other.
+//*****************************************************************************
+void diversity_deinterleave(int16_t* samples, int channels, int count);
+
+//*****************************************************************************
+// Returns -1 unless there are 2 to DIVERSITY_MAX_CHANNELS channels. The
+// detectors have to be tuned before the first update.
+//*****************************************************************************
+int diversity_init(struct diversity* div, int channels, enum DIVERSITY_MODE mode, int noise_minimum);
+
+//*****************************************************************************
+// Point every microphone's detectors at the carriers and its noise floor at
+// the reference bins (Q14 coefficients). Returns -1 if a carrier is not on a
+// bin.
+//*****************************************************************************
+int diversity_tune(struct diversity* div, uint32_t sample_rate, uint32_t sync_freq, uint32_t data_freq,
+    const int* refs, int num_refs);
+
+//*****************************************************************************
+// Clear the detector windows after frames were lost
+//*****************************************************************************
+void diversity_reset(struct diversity* div);
+
+//*****************************************************************************
+// Run a frame of every microphone (channels frames one after the other)
+// through its detectors and weigh the microphones for it
+//*****************************************************************************
+void diversity_update(struct diversity* div, const int16_t* frames, uint32_t reference);
+
+//*****************************************************************************
+// Work out gain and selected from each microphone's carrier and noise floor,
+// with reference the floor the combined energies are scaled to
+//*****************************************************************************
+void diversity_weigh(struct diversity* div, uint32_t reference);
+
+//*****************************************************************************
+// Weighted sum of count energies of every microphone
+//*****************************************************************************
+void diversity_combine(const struct diversity* div, const int* const* traces, int count, int* out);
+
+//*****************************************************************************
+// Combined hop energies of the newest frame on the two carriers
+//*****************************************************************************
+void diversity_sync(const struct diversity* div, int* energy);
+void diversity_data(const struct diversity* div, int* energy);
+
+//*****************************************************************************
+// Combined powers of a Goertzel bank (up to MFSK_NUM_TONES bins) over the
+// newest frames. The tones count towards each microphone's carrier estimate.
+//*****************************************************************************
+void diversity_bank(struct diversity* div, const int* coeffs, int* power, int num_bins);
+
+#endif // DIVERSITY_H_
@@ -0,0 +1,64 @@
+//*****************************************************************************
+//
+// energy_gate.c - Cheap high-pass energy detector to skip quiet frames
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include "energy_gate.h"
+
+void energy_gate_init(struct energy_gate* gate, int hangover)
+{
+    gate->floor = 0;
+    gate->hangover = hangover;
+    gate->hold = 0;
+    gate->frames = 0;
+    gate->open_frames = 0;
+}
+
+uint32_t energy_gate_measure(const int16_t* frame, int sz)
+{
+    int64_t sum = 0;
+    int32_t diff;
+    int i = 0;
+
+    for (i = 2; i < sz; i++) {
+        diff = frame[i] - 2 * frame[i - 1] + frame[i - 2];
+        sum += diff * diff;
+    }
+
+    return (sz > 2) ? (uint32_t)(sum / (sz - 2)) : 0;
+}
+
+int energy_gate_update(struct energy_gate* gate, uint32_t energy)
+{
+    int open = 0;
+
+    gate->frames++;
+
+    // The first frame only sets the floor
+    if (!gate->floor) {
+        gate->floor = energy ? energy : 1;
+        gate->hold = gate->hangover;
+    } else {
+        open = energy > gate->floor + (gate->floor >> EG_OPEN_SHIFT) + 1;
+        if (energy < gate->floor)
+            gate->floor -= (gate->floor - energy) >> EG_TRACK_SHIFT;
+        else
+            gate->floor += (energy - gate->floor) >> (open ? EG_OPEN_TRACK_SHIFT : EG_TRACK_SHIFT);
+        if (!gate->floor)
+            gate->floor = 1;
+    }
+
+    if (open)
+        gate->hold = gate->hangover;
+    else if (gate->hold > 0)
+        gate->hold--;
+    else
+        return 0;
+
+    gate->open_frames++;
+    return 1;
+}
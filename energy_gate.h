@@ -0,0 +1,51 @@
+//*****************************************************************************
+//
+// energy_gate.h - Cheap high-pass energy detector to skip quiet frames
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#ifndef ENERGY_GATE_H_
+#define ENERGY_GATE_H_
+
+#include <stdint.h>
+
+//*****************************************************************************
+// Opening level above the floor (floor + floor >> EG_OPEN_SHIFT, 25%) and how
+// fast the floor follows the frame energy. Frames above the opening level
+// still pull it up, only far slower, so a floor that fell during a dead
+// silent stretch recovers.
+//*****************************************************************************
+#define EG_OPEN_SHIFT 2
+#define EG_TRACK_SHIFT 4
+#define EG_OPEN_TRACK_SHIFT 8
+
+//*****************************************************************************
+// Tracks the noise floor of the high-passed input. A frame clearly above the
+// floor opens the gate, which then stays open for hangover more frames so a
+// short gap in a start sequence isn't cut off.
+//*****************************************************************************
+struct energy_gate {
+    uint32_t floor;
+    int hangover;
+    int hold;
+    uint32_t frames;            // Frames seen
+    uint32_t open_frames;       // Frames let through
+};
+
+void energy_gate_init(struct energy_gate* gate, int hangover);
+
+//*****************************************************************************
+// Mean square of the second difference x[n] - 2x[n-1] + x[n-2] of a frame of
+// ADC readings. The filter passes 20kHz at 51.2kHz with a gain of 3.5 and
+// takes 1kHz down by 36dB, so audible room noise hardly moves it.
+//*****************************************************************************
+uint32_t energy_gate_measure(const int16_t* frame, int sz);
+
+//*****************************************************************************
+// Returns 1 if the frame with this energy should go through full detection
+//*****************************************************************************
+int energy_gate_update(struct energy_gate* gate, uint32_t energy);
+
+#endif // ENERGY_GATE_H_
@@ -0,0 +1,255 @@
+//*****************************************************************************
+//
+// fec.c - Forward error correction for the OOK data bits
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include "fec.h"
+
+//*****************************************************************************
+// Hamming(7,4) codewords, data nibble in the top 4 bits followed by the
+// parity bits d1^d2^d4, d1^d3^d4 and d2^d3^d4. Any two differ in at least 3
+// bits.
+//*****************************************************************************
+static const uint8_t hamming_codewords[16] = {
+    0x00, 0x0F, 0x13, 0x1C, 0x25, 0x2A, 0x36, 0x39,
+    0x46, 0x49, 0x55, 0x5A, 0x63, 0x6C, 0x70, 0x7F
+};
+
+//*****************************************************************************
+// Encoder output (POLY_A bit, POLY_B bit) for a register whose oldest bit is
+// 0, indexed by the newest 6 bits. Both polynomials tap the oldest bit, so
+// the output is the complement when it is 1.
+//*****************************************************************************
+static const uint8_t conv_symbols[FEC_CONV_STATES] = {
+    0, 3, 2, 1, 3, 0, 1, 2, 3, 0, 1, 2, 0, 3, 2, 1,
+    0, 3, 2, 1, 3, 0, 1, 2, 3, 0, 1, 2, 0, 3, 2, 1,
+    1, 2, 3, 0, 2, 1, 0, 3, 2, 1, 0, 3, 1, 2, 3, 0,
+    1, 2, 3, 0, 2, 1, 0, 3, 2, 1, 0, 3, 1, 2, 3, 0
+};
+
+//*****************************************************************************
+// Path metric of states the encoder cannot be in when a message starts
+//*****************************************************************************
+#define FEC_UNREACHABLE (-(1 << 20))
+
+//*****************************************************************************
+// How far state 0 has to lead before a stop byte is believed. Every other
+// state holds a 1 among its last bits, so this asks for the last step to
+// have read as zeros with some confidence.
+//*****************************************************************************
+#define FEC_FLUSH_MARGIN FEC_SOFT_MAX
+
+static int parity(uint32_t value)
+{
+    value ^= value >> 4;
+    value ^= value >> 2;
+    value ^= value >> 1;
+    return value & 1;
+}
+
+void fec_encoder_init(struct fec_encoder* enc, enum FEC_CODE code)
+{
+    enc->code = code;
+    enc->shift = 0;
+}
+
+int fec_encode_byte(struct fec_encoder* enc, uint8_t byte, uint8_t* bits)
+{
+    uint8_t codeword;
+    int count = 0, i = 0;
+
+    switch (enc->code) {
+    case FEC_HAMMING:
+        codeword = hamming_codewords[byte >> 4];
+        for (i = 6; i >= 0; i--)
+            bits[count++] = (codeword >> i) & 1;
+        codeword = hamming_codewords[byte & 0xF];
+        for (i = 6; i >= 0; i--)
+            bits[count++] = (codeword >> i) & 1;
+        break;
+    case FEC_CONVOLUTIONAL:
+        for (i = 7; i >= 0; i--) {
+            enc->shift = ((enc->shift << 1) | ((byte >> i) & 1)) & ((1 << FEC_CONV_K) - 1);
+            bits[count++] = parity(enc->shift & FEC_CONV_POLY_A);
+            bits[count++] = parity(enc->shift & FEC_CONV_POLY_B);
+        }
+        break;
+    default:
+        for (i = 7; i >= 0; i--)
+            bits[count++] = (byte >> i) & 1;
+        break;
+    }
+
+    return count;
+}
+
+void fec_decoder_init(struct fec_decoder* fec, enum FEC_CODE code)
+{
+    int state = 0;
+
+    fec->code = code;
+    fec->count = 0;
+    fec->steps = 0;
+    fec->decided = 0;
+
+    // Every message starts with the encoder register cleared
+    fec->metric[0] = 0;
+    for (state = 1; state < FEC_CONV_STATES; state++)
+        fec->metric[state] = FEC_UNREACHABLE;
+}
+
+uint8_t fec_hamming_codeword(int nibble)
+{
+    return hamming_codewords[nibble & 0xF];
+}
+
+int fec_hamming_decode(const int* soft)
+{
+    int best = 0, best_score = 0, score, word = 0, i = 0;
+
+    for (word = 0; word < 16; word++) {
+        score = 0;
+        for (i = 0; i < 7; i++)
+            score += ((hamming_codewords[word] >> (6 - i)) & 1) ? soft[i] : -soft[i];
+        if (!word || score > best_score) {
+            best = word;
+            best_score = score;
+        }
+    }
+
+    return best;
+}
+
+//*****************************************************************************
+// Best path metric of the states other than 0
+//*****************************************************************************
+static int32_t runner_up(const struct fec_decoder* fec)
+{
+    int32_t best = FEC_UNREACHABLE;
+    int state = 0;
+
+    for (state = 1; state < FEC_CONV_STATES; state++) {
+        if (fec->metric[state] > best)
+            best = fec->metric[state];
+    }
+
+    return best;
+}
+
+//*****************************************************************************
+// Trace the survivor of state back over the newest depth steps. The newest
+// bit of a state is the data bit that led into it, so bits come out newest
+// first: bits[0] is the bit of the latest step.
+//*****************************************************************************
+static void traceback(const struct fec_decoder* fec, int state, uint32_t depth, uint8_t* bits)
+{
+    uint32_t step = 0;
+
+    for (step = 0; step < depth; step++) {
+        bits[step] = state & 1;
+        state = (state >> 1) | ((int)((fec->decisions[(fec->steps - 1 - step) % FEC_HISTORY] >> state) & 1) << (FEC_CONV_K - 2));
+    }
+}
+
+//*****************************************************************************
+// One trellis step on the soft inputs of the two encoder outputs. Each new
+// state has two possible predecessors that differ only in the bit shifted
+// out, and their branches carry complementary outputs, so one branch metric
+// serves both. Normally the bit from FEC_TRACEBACK steps ago is decided.
+// When a byte ends with the best path in state 0 after 8 zero bits, and
+// FEC_FLUSH_MARGIN ahead of every other state, it may be the stop byte or the
+// end of a packet, so everything still undecided is put out at once: the
+// silence after a message is shorter than the traceback. Decoding goes on
+// from there with the bits already out skipped.
+//*****************************************************************************
+static int viterbi_step(struct fec_decoder* fec, int soft_a, int soft_b, uint8_t* bits)
+{
+    int32_t metric[FEC_CONV_STATES];
+    int32_t branch, from_0, from_1, best;
+    uint64_t decisions = 0;
+    uint8_t path[FEC_TRACEBACK];
+    uint32_t depth;
+    int state = 0, best_state = 0, count = 0, i = 0;
+
+    for (state = 0; state < FEC_CONV_STATES; state++) {
+        branch = ((conv_symbols[state] & 2) ? soft_a : -soft_a) + ((conv_symbols[state] & 1) ? soft_b : -soft_b);
+        from_0 = fec->metric[state >> 1] + branch;
+        from_1 = fec->metric[(state >> 1) | (FEC_CONV_STATES >> 1)] - branch;
+        if (from_1 > from_0) {
+            metric[state] = from_1;
+            decisions |= (uint64_t)1 << state;
+        } else {
+            metric[state] = from_0;
+        }
+    }
+
+    // Keep the best path at 0 so the metrics never grow
+    best = metric[0];
+    for (state = 1; state < FEC_CONV_STATES; state++) {
+        if (metric[state] > best) {
+            best = metric[state];
+            best_state = state;
+        }
+    }
+    for (state = 0; state < FEC_CONV_STATES; state++)
+        fec->metric[state] = (metric[state] - best < FEC_UNREACHABLE) ? FEC_UNREACHABLE : metric[state] - best;
+
+    fec->decisions[fec->steps % FEC_HISTORY] = decisions;
+    fec->steps++;
+
+    depth = (fec->steps < FEC_TRACEBACK) ? fec->steps : FEC_TRACEBACK;
+    traceback(fec, best_state, depth, path);
+
+    if (!best_state && !(fec->steps % 8) && depth >= 8 && runner_up(fec) < -FEC_FLUSH_MARGIN) {
+        for (i = 0; i < 8 && !path[i]; i++)
+            ;
+        if (i == 8) {
+            for (i = fec->steps - fec->decided - 1; i >= 0; i--)
+                bits[count++] = path[i];
+            fec->decided = fec->steps;
+            return count;
+        }
+    }
+
+    // Nothing to do while the oldest step is one that was flushed
+    if (fec->steps < FEC_TRACEBACK || fec->steps - FEC_TRACEBACK < fec->decided)
+        return 0;
+    bits[0] = path[FEC_TRACEBACK - 1];
+    fec->decided++;
+    return 1;
+}
+
+int fec_decode(struct fec_decoder* fec, int soft, uint8_t* bits)
+{
+    int nibble, i = 0;
+
+    if (soft > FEC_SOFT_MAX)
+        soft = FEC_SOFT_MAX;
+    if (soft < -FEC_SOFT_MAX)
+        soft = -FEC_SOFT_MAX;
+
+    switch (fec->code) {
+    case FEC_HAMMING:
+        fec->soft[fec->count++] = soft;
+        if (fec->count < 7)
+            return 0;
+        fec->count = 0;
+        nibble = fec_hamming_decode(fec->soft);
+        for (i = 0; i < 4; i++)
+            bits[i] = (nibble >> (3 - i)) & 1;
+        return 4;
+    case FEC_CONVOLUTIONAL:
+        fec->soft[fec->count++] = soft;
+        if (fec->count < 2)
+            return 0;
+        fec->count = 0;
+        return viterbi_step(fec, fec->soft[0], fec->soft[1], bits);
+    default:
+        bits[0] = soft > 0;
+        return 1;
+    }
+}
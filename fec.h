@@ -0,0 +1,100 @@
+//*****************************************************************************
+//
+// fec.h - Forward error correction for the OOK data bits
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#ifndef FEC_H_
+#define FEC_H_
+
+#include <stdint.h>
+
+//*****************************************************************************
+// Codes that can be put between the bit slicer and byte assembly
+//   FEC_NONE           8 channel bits per byte
+//   FEC_HAMMING        Hamming(7,4) on each nibble, high nibble first, 14
+//                      channel bits per byte, corrects one error per nibble
+//   FEC_CONVOLUTIONAL  rate 1/2, K=7 (polynomials 0x4F and 0x6D), 16 channel
+//                      bits per byte. The stop byte and the silence after it
+//                      terminate the trellis, no tail has to be sent.
+//*****************************************************************************
+enum FEC_CODE {
+    FEC_NONE,
+    FEC_HAMMING,
+    FEC_CONVOLUTIONAL
+};
+
+//*****************************************************************************
+// Soft inputs run from -FEC_SOFT_MAX (surely 0) to FEC_SOFT_MAX (surely 1)
+//*****************************************************************************
+#define FEC_SOFT_MAX 16
+
+//*****************************************************************************
+// Viterbi decoder size. A bit is decided FEC_TRACEBACK steps after it was
+// received (more than 5 constraint lengths), decisions are kept in a ring of
+// FEC_HISTORY steps.
+//*****************************************************************************
+#define FEC_CONV_K 7
+#define FEC_CONV_STATES (1 << (FEC_CONV_K - 1))
+#define FEC_CONV_POLY_A 0x4F
+#define FEC_CONV_POLY_B 0x6D
+#define FEC_TRACEBACK 40
+#define FEC_HISTORY 64
+
+//*****************************************************************************
+// Most data bits one call to fec_decode() can return
+//*****************************************************************************
+#define FEC_MAX_BITS FEC_TRACEBACK
+
+struct fec_encoder {
+    enum FEC_CODE code;
+    uint32_t shift;                 // Convolutional encoder register
+};
+
+//*****************************************************************************
+// Channel bits still have to be turned back into data bits. Hamming
+// codewords are collected whole and decoded to the nearest codeword by
+// correlating the soft inputs with all 16. The convolutional code has a 64
+// state Viterbi decoder with one survivor decision bit per state and step.
+//*****************************************************************************
+struct fec_decoder {
+    enum FEC_CODE code;
+    int soft[7];                    // Channel bits of the codeword or step being collected
+    int count;
+    int32_t metric[FEC_CONV_STATES];
+    uint64_t decisions[FEC_HISTORY];
+    uint32_t steps;
+    uint32_t decided;               // Steps whose data bit has been put out
+};
+
+void fec_encoder_init(struct fec_encoder* enc, enum FEC_CODE code);
+
+//*****************************************************************************
+// Encode one data byte, MSB first. Returns the number of channel bits
+// written to bits (one 0 or 1 per entry), 16 at most.
+//*****************************************************************************
+int fec_encode_byte(struct fec_encoder* enc, uint8_t byte, uint8_t* bits);
+
+//*****************************************************************************
+// Start decoding a new message
+//*****************************************************************************
+void fec_decoder_init(struct fec_decoder* fec, enum FEC_CODE code);
+
+//*****************************************************************************
+// Feed the next channel bit as a soft value. Decoded data bits are written to
+// bits (FEC_MAX_BITS at most) and their number is returned.
+//*****************************************************************************
+int fec_decode(struct fec_decoder* fec, int soft, uint8_t* bits);
+
+//*****************************************************************************
+// A single Hamming(7,4) codeword, for short fields sent outside the coded
+// data. The codeword is the low 7 bits, sent from bit 6 down. Decoding takes
+// the 7 soft values in that order and returns the data nibble of the
+// codeword they correlate best with.
+//*****************************************************************************
+uint8_t fec_hamming_codeword(int nibble);
+int fec_hamming_decode(const int* soft);
+
+#endif // FEC_H_
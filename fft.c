@@ -0,0 +1,185 @@
+//*****************************************************************************
+//
+// fft.c - Fixed point radix-4 FFT for spectrum search
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include "fft.h"
+#include "freq_plan.h"
+#include "goertzel.h"
+
+#define QUARTER (FFT_MAX_SIZE / 4)
+
+//*****************************************************************************
+// sin(2*pi*i/FFT_MAX_SIZE) in Q15 for the first quarter wave, the rest of the
+// twiddle factors follow from symmetry. Worked out by the compiler, rounded
+// and kept below 32768.
+//*****************************************************************************
+#define SINE_Q15(J) ((PLAN_SIN(J, FFT_MAX_SIZE) * 32768.0 + 0.5 < 32767.0) \
+    ? (int16_t)(PLAN_SIN(J, FFT_MAX_SIZE) * 32768.0 + 0.5) : 32767),
+#define SINE_8(J) SINE_Q15(J) SINE_Q15(J + 1) SINE_Q15(J + 2) SINE_Q15(J + 3) SINE_Q15(J + 4) SINE_Q15(J + 5) \
+    SINE_Q15(J + 6) SINE_Q15(J + 7)
+#define SINE_64(J) SINE_8(J) SINE_8(J + 8) SINE_8(J + 16) SINE_8(J + 24) SINE_8(J + 32) SINE_8(J + 40) \
+    SINE_8(J + 48) SINE_8(J + 56)
+
+typedef char sine_table_listed[(QUARTER == 256) ? 1 : -1];
+
+static const int16_t sine_table[QUARTER + 1] = {
+    SINE_64(0) SINE_64(64) SINE_64(128) SINE_64(192) SINE_Q15(256)
+};
+
+static int32_t twiddle_sin(int m)
+{
+    m &= FFT_MAX_SIZE - 1;
+    if (m <= QUARTER)
+        return sine_table[m];
+    if (m <= 2 * QUARTER)
+        return sine_table[2 * QUARTER - m];
+    if (m <= 3 * QUARTER)
+        return -sine_table[m - 2 * QUARTER];
+    return -sine_table[4 * QUARTER - m];
+}
+
+static int32_t twiddle_cos(int m)
+{
+    return twiddle_sin(m + QUARTER);
+}
+
+void fft_load(const int16_t* samples, int16_t* data, int n)
+{
+    int32_t sum = 0;
+    int i = 0;
+
+    for (i = 0; i < n; i++)
+        sum += samples[i];
+    sum /= n;
+
+    // 12 bit readings use the top of the Q15 range after removing DC
+    for (i = 0; i < n; i++) {
+        data[2 * i] = (int16_t)((samples[i] - sum) << 3);
+        data[2 * i + 1] = 0;
+    }
+}
+
+//*****************************************************************************
+// Multiply (re, im) by exp(-j*2*pi*m/FFT_MAX_SIZE)
+//*****************************************************************************
+static void rotate(int16_t* x, int32_t re, int32_t im, int m)
+{
+    int32_t c = twiddle_cos(m), s = twiddle_sin(m);
+
+    x[0] = (int16_t)((re * c + im * s) >> 15);
+    x[1] = (int16_t)((im * c - re * s) >> 15);
+}
+
+void fft_radix4(int16_t* data, int n)
+{
+    int32_t ar, ai, br, bi, cr, ci, dr, di;
+    int16_t* x0;
+    int16_t* x1;
+    int16_t* x2;
+    int16_t* x3;
+    int16_t tmp;
+    int span, quarter, step, k = 0, group = 0, i = 0, j = 0, digits;
+
+    // Decimation in frequency, each butterfly takes four points a quarter
+    // span apart and scales them by 1/4 on the way in
+    for (span = n; span > 1; span >>= 2) {
+        quarter = span >> 2;
+        step = FFT_MAX_SIZE / span;
+        for (k = 0; k < quarter; k++) {
+            for (group = k; group < n; group += span) {
+                x0 = &data[2 * group];
+                x1 = x0 + 2 * quarter;
+                x2 = x1 + 2 * quarter;
+                x3 = x2 + 2 * quarter;
+
+                ar = (x0[0] >> 2) + (x2[0] >> 2);
+                ai = (x0[1] >> 2) + (x2[1] >> 2);
+                br = (x0[0] >> 2) - (x2[0] >> 2);
+                bi = (x0[1] >> 2) - (x2[1] >> 2);
+                cr = (x1[0] >> 2) + (x3[0] >> 2);
+                ci = (x1[1] >> 2) + (x3[1] >> 2);
+                dr = (x1[0] >> 2) - (x3[0] >> 2);
+                di = (x1[1] >> 2) - (x3[1] >> 2);
+
+                x0[0] = (int16_t)(ar + cr);
+                x0[1] = (int16_t)(ai + ci);
+                rotate(x1, ar - cr, ai - ci, 2 * k * step);
+                rotate(x2, br + di, bi - dr, k * step);
+                rotate(x3, br - di, bi + dr, 3 * k * step);
+            }
+        }
+    }
+
+    // The outputs above are stored as 0, 2, 1, 3 of each butterfly, so the
+    // bins end up in bit reversed order
+    for (digits = 0; (1 << digits) < n; digits++);
+    for (i = 0; i < n; i++) {
+        for (j = 0, k = 0; k < digits; k++)
+            j |= ((i >> k) & 1) << (digits - 1 - k);
+        if (j > i) {
+            tmp = data[2 * i];
+            data[2 * i] = data[2 * j];
+            data[2 * j] = tmp;
+            tmp = data[2 * i + 1];
+            data[2 * i + 1] = data[2 * j + 1];
+            data[2 * j + 1] = tmp;
+        }
+    }
+}
+
+int fft_power(const int16_t* data, int bin)
+{
+    int32_t re = data[2 * bin], im = data[2 * bin + 1];
+
+    return (re * re + im * im) >> 3;
+}
+
+int fft_peak(const int16_t* data, int first, int last, int* power)
+{
+    int bin = 0, best = first, value = 0;
+
+    *power = -1;
+    for (bin = first; bin <= last; bin++) {
+        value = fft_power(data, bin);
+        if (value > *power) {
+            *power = value;
+            best = bin;
+        }
+    }
+
+    return best;
+}
+
+int fft_peak_offset(const int16_t* data, int bin)
+{
+    int32_t left, centre, right, curve;
+
+    left = goertzel_isqrt(fft_power(data, bin - 1));
+    centre = goertzel_isqrt(fft_power(data, bin));
+    right = goertzel_isqrt(fft_power(data, bin + 1));
+    curve = 2 * centre - left - right;
+    if (curve <= 0)
+        return 0;
+
+    return ((right - left) * 128) / curve;
+}
+
+int fft_tone_offset(const int16_t* data, int bin)
+{
+    int32_t left, centre, right;
+
+    left = goertzel_isqrt(fft_power(data, bin - 1));
+    centre = goertzel_isqrt(fft_power(data, bin));
+    right = goertzel_isqrt(fft_power(data, bin + 1));
+    if (right > left)
+        return (right * 256) / (centre + right);
+    if (left > right)
+        return -(left * 256) / (centre + left);
+
+    return 0;
+}
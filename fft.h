@@ -0,0 +1,56 @@
+//*****************************************************************************
+//
+// fft.h - Fixed point radix-4 FFT for spectrum search
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#ifndef FFT_H_
+#define FFT_H_
+
+#include <stdint.h>
+
+//*****************************************************************************
+// Largest transform, the length of a DMA frame. Sizes have to be a power of 4.
+//*****************************************************************************
+#define FFT_MAX_SIZE 1024
+
+//*****************************************************************************
+// Copy n ADC readings into data as complex Q15 values with the DC offset
+// removed. data holds n interleaved (re, im) pairs.
+//*****************************************************************************
+void fft_load(const int16_t* samples, int16_t* data, int n);
+
+//*****************************************************************************
+// In place forward transform of n interleaved complex values. Every stage is
+// scaled by 1/4, so the output is the spectrum divided by n and can't
+// overflow. Bins come out in natural order.
+//*****************************************************************************
+void fft_radix4(int16_t* data, int n);
+
+//*****************************************************************************
+// Power of one bin of a transformed ADC frame, on the same scale as
+// goertzel() so the same thresholds apply
+//*****************************************************************************
+int fft_power(const int16_t* data, int bin);
+
+//*****************************************************************************
+// Strongest bin from first to last inclusive, its power is stored in power
+//*****************************************************************************
+int fft_peak(const int16_t* data, int first, int last, int* power);
+
+//*****************************************************************************
+// Position of a tone relative to the centre of its peak bin in 1/256ths of a
+// bin (-128 to 128), from a parabola through the neighbouring magnitudes
+//*****************************************************************************
+int fft_peak_offset(const int16_t* data, int bin);
+
+//*****************************************************************************
+// The same from the ratio of the bin's magnitude to its stronger neighbour's,
+// which is exact for a steady tone over the whole frame (a parabola
+// underestimates the offset of one by up to half)
+//*****************************************************************************
+int fft_tone_offset(const int16_t* data, int bin);
+
+#endif // FFT_H_
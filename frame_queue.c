@@ -0,0 +1,100 @@
+//*****************************************************************************
+//
+// frame_queue.c - Lock-free queue of sample frames between an ISR and main
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <string.h>
+#include "frame_queue.h"
+
+//*****************************************************************************
+// Frame contents have to be complete before an index update makes them
+// visible to the other side. A compiler barrier is enough on the single core
+// M4, a full barrier keeps threaded host builds honest.
+//*****************************************************************************
+#if defined(__TI_ARM__)
+#define FRAME_QUEUE_BARRIER() __asm(" dmb")
+#elif defined(__GNUC__)
+#define FRAME_QUEUE_BARRIER() __sync_synchronize()
+#else
+#define FRAME_QUEUE_BARRIER()
+#endif
+
+#define SCRATCH_SLOT (-1)
+
+int frame_queue_init(struct frame_queue* q, int16_t* storage, int frame_size, int depth)
+{
+    // A power of two keeps the ring positions continuous when the counters wrap
+    if (depth <= FRAME_QUEUE_MAX_ARMED || depth > FRAME_QUEUE_MAX_DEPTH || (depth & (depth - 1)))
+        return -1;
+
+    memset(q, 0, sizeof(*q));
+    q->storage = storage;
+    q->frame_size = frame_size;
+    q->depth = depth;
+
+    return 0;
+}
+
+int16_t* frame_queue_arm(struct frame_queue* q)
+{
+    int slot = SCRATCH_SLOT;
+
+    // A slot is free once the consumer released it, counting the frames that
+    // are queued and the transfers that are already running
+    if (q->next_slot - q->tail < q->depth) {
+        slot = q->next_slot % q->depth;
+        q->next_slot++;
+    }
+
+    q->armed[q->armed_count++] = slot;
+
+    return q->storage + ((slot == SCRATCH_SLOT) ? q->depth : (uint32_t)slot) * q->frame_size;
+}
+
+void frame_queue_complete(struct frame_queue* q)
+{
+    int slot = q->armed[0];
+    uint32_t waiting;
+    int i = 0;
+
+    q->armed_count--;
+    for (i = 0; i < q->armed_count; i++)
+        q->armed[i] = q->armed[i + 1];
+
+    if (slot == SCRATCH_SLOT) {
+        q->overruns++;
+    } else {
+        q->sequence[slot] = q->next_sequence;
+        FRAME_QUEUE_BARRIER();
+        q->head++;
+
+        waiting = q->head - q->tail;
+        if (waiting > q->high_water)
+            q->high_water = waiting;
+    }
+    q->next_sequence++;
+}
+
+const int16_t* frame_queue_peek(struct frame_queue* q, uint32_t* sequence)
+{
+    uint32_t slot;
+
+    if (q->head == q->tail)
+        return NULL;
+    FRAME_QUEUE_BARRIER();
+
+    slot = q->tail % q->depth;
+    *sequence = q->sequence[slot];
+
+    return q->storage + slot * q->frame_size;
+}
+
+void frame_queue_release(struct frame_queue* q)
+{
+    FRAME_QUEUE_BARRIER();
+    q->tail++;
+}
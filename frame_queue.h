@@ -0,0 +1,77 @@
+//*****************************************************************************
+//
+// frame_queue.h - Lock-free queue of sample frames between an ISR and main
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#ifndef FRAME_QUEUE_H_
+#define FRAME_QUEUE_H_
+
+#include <stdint.h>
+
+//*****************************************************************************
+// Largest number of frame slots, and how many transfers can be running at
+// once (two for a ping-pong uDMA channel)
+//*****************************************************************************
+#define FRAME_QUEUE_MAX_DEPTH 16
+#define FRAME_QUEUE_MAX_ARMED 2
+
+//*****************************************************************************
+// Single producer (the ADC interrupt) and single consumer (the main loop).
+// Slots are filled in ring order. The producer arms transfers into the next
+// free slots and publishes each one as it completes by advancing head; the
+// consumer advances tail when it is done with a frame. Each index is only
+// written by one side, so no locks or interrupt masking are needed.
+//
+// Every frame gets the next sequence number whether it is kept or not. When
+// all slots are full the transfer goes into a scratch frame and is dropped,
+// so the consumer sees the gap in the sequence numbers and overruns counts
+// it. Queued frames are never overwritten.
+//*****************************************************************************
+struct frame_queue {
+    int16_t* storage;                   // depth + 1 frames, the last is scratch
+    int frame_size;
+    uint32_t depth;
+    volatile uint32_t head;             // Frames published, producer only
+    volatile uint32_t tail;             // Frames released, consumer only
+    uint32_t sequence[FRAME_QUEUE_MAX_DEPTH];
+
+    // Producer only
+    uint32_t next_sequence;             // Number of the next frame to complete
+    uint32_t next_slot;                 // Ring position of the next armed slot
+    int armed[FRAME_QUEUE_MAX_ARMED];   // Slots of running transfers, oldest first
+    int armed_count;
+    volatile uint32_t overruns;         // Frames dropped because the queue was full
+    volatile uint32_t high_water;       // Most frames ever waiting
+};
+
+//*****************************************************************************
+// storage must hold (depth + 1) * frame_size samples. depth has to be a
+// power of two above FRAME_QUEUE_MAX_ARMED, returns -1 otherwise.
+//*****************************************************************************
+int frame_queue_init(struct frame_queue* q, int16_t* storage, int frame_size, int depth);
+
+//*****************************************************************************
+// Producer: buffer for the next transfer. Transfers must complete in the
+// order they were armed.
+//*****************************************************************************
+int16_t* frame_queue_arm(struct frame_queue* q);
+
+//*****************************************************************************
+// Producer: the oldest armed transfer has finished
+//*****************************************************************************
+void frame_queue_complete(struct frame_queue* q);
+
+//*****************************************************************************
+// Consumer: oldest waiting frame and its sequence number, NULL if none
+//*****************************************************************************
+const int16_t* frame_queue_peek(struct frame_queue* q, uint32_t* sequence);
+
+//*****************************************************************************
+// Consumer: done with the frame returned by frame_queue_peek()
+//*****************************************************************************
+void frame_queue_release(struct frame_queue* q);
+
+#endif // FRAME_QUEUE_H_
@@ -0,0 +1,111 @@
+//*****************************************************************************
+//
+// freq_plan.c - Tables for the tones of the channel plan, built by the
+// compiler from freq_plan.h
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include "freq_plan.h"
+#include "goertzel.h"
+#include "sliding_goertzel.h"
+
+//*****************************************************************************
+// A plan that fails one of these does not compile. Each check is an array
+// that gets a negative size when its condition is false.
+//*****************************************************************************
+#define PLAN_CHECK(NAME, CONDITION) typedef char plan_check_##NAME[(CONDITION) ? 1 : -1];
+#define PLAN_BIN_WIDTH (PLAN_SAMPLE_RATE / NUM_SAMPLES)
+#define PLAN_APART(A, B, BINS) (((A) > (B) ? (A) - (B) : (B) - (A)) >= (BINS) * PLAN_BIN_WIDTH)
+
+// Whole Hz bins (the carrier search relies on them) and whole hops
+PLAN_CHECK(whole_hz_bins, PLAN_SAMPLE_RATE % NUM_SAMPLES == 0)
+PLAN_CHECK(whole_hops, NUM_SAMPLES % HOP_SIZE == 0 && HOPS_PER_FRAME <= SG_MAX_HOPS)
+
+// Every tone below Nyquist and on a bin
+#define PLAN_CHECK_TONE(NAME, FREQ) \
+    PLAN_CHECK(NAME##_below_nyquist, 2 * (FREQ) < PLAN_SAMPLE_RATE && (FREQ) > 0) \
+    PLAN_CHECK(NAME##_on_bin, ((uint32_t)(FREQ) * NUM_SAMPLES) % PLAN_SAMPLE_RATE == 0)
+PLAN_TONES(PLAN_CHECK_TONE)
+
+// The carriers two bins apart, references two bins from both carriers and
+// MFSK tones at least a bin apart
+PLAN_CHECK(carriers_apart, PLAN_APART(DATA_TONE_FREQ, SYNC_TONE_FREQ, 2))
+#define PLAN_CHECK_REF(NAME, FREQ) \
+    PLAN_CHECK(NAME##_apart, PLAN_APART(FREQ, DATA_TONE_FREQ, 2) && PLAN_APART(FREQ, SYNC_TONE_FREQ, 2))
+PLAN_NOISE_REFS(PLAN_CHECK_REF)
+PLAN_CHECK(mfsk_apart, MFSK_TONE_SPACING >= PLAN_BIN_WIDTH)
+PLAN_CHECK(mfsk_listed, PLAN_REF_0 - PLAN_MFSK_0 == MFSK_NUM_TONES)
+
+// OFDM subcarriers on bins below Nyquist, a pilot at both ends and a guard
+// shorter than a frame
+PLAN_CHECK_TONE(OFDM_FIRST, OFDM_BASE_FREQ)
+PLAN_CHECK_TONE(OFDM_LAST, OFDM_BASE_FREQ + (OFDM_NUM_BINS - 1) * OFDM_BIN_WIDTH)
+PLAN_CHECK(ofdm_pilots, OFDM_NUM_BINS > OFDM_PILOT_SPACING && (OFDM_NUM_BINS - 1) % OFDM_PILOT_SPACING == 0)
+PLAN_CHECK(ofdm_guard, OFDM_GUARD > 0 && OFDM_GUARD < NUM_SAMPLES)
+
+//*****************************************************************************
+// The tables
+//*****************************************************************************
+#define PLAN_COEFF_ENTRY(NAME, FREQ) PLAN_Q14(2.0 * PLAN_COS(FREQ, PLAN_SAMPLE_RATE)),
+
+const uint32_t plan_freqs[PLAN_NUM_TONES] = {
+    PLAN_TONES(PLAN_FREQ)
+};
+
+const int32_t plan_coeffs[PLAN_NUM_TONES] = {
+    PLAN_TONES(PLAN_COEFF_ENTRY)
+};
+
+//*****************************************************************************
+// Hop slot s of a window is rotated by -w * HOP_SIZE * s
+//*****************************************************************************
+#define PLAN_ROT_RE(FREQ, SLOT) PLAN_Q14(PLAN_COS((uint32_t)(FREQ) * HOP_SIZE * (SLOT), PLAN_SAMPLE_RATE))
+#define PLAN_ROT_IM(FREQ, SLOT) PLAN_Q14(-PLAN_SIN((uint32_t)(FREQ) * HOP_SIZE * (SLOT), PLAN_SAMPLE_RATE))
+#define PLAN_SLOTS(ROT, FREQ) { \
+    ROT(FREQ, 0), ROT(FREQ, 1), ROT(FREQ, 2), ROT(FREQ, 3), ROT(FREQ, 4), ROT(FREQ, 5), ROT(FREQ, 6), ROT(FREQ, 7), \
+    ROT(FREQ, 8), ROT(FREQ, 9), ROT(FREQ, 10), ROT(FREQ, 11), ROT(FREQ, 12), ROT(FREQ, 13), ROT(FREQ, 14), ROT(FREQ, 15) }
+#define PLAN_CARRIER(FREQ) { \
+    PLAN_Q14(2.0 * PLAN_COS(FREQ, PLAN_SAMPLE_RATE)), \
+    PLAN_Q14(PLAN_COS(FREQ, PLAN_SAMPLE_RATE)), \
+    PLAN_Q14(PLAN_SIN(FREQ, PLAN_SAMPLE_RATE)), \
+    PLAN_SLOTS(PLAN_ROT_RE, FREQ), \
+    PLAN_SLOTS(PLAN_ROT_IM, FREQ) }
+
+PLAN_CHECK(slots_listed, SG_MAX_HOPS == 16)
+
+const struct plan_carrier plan_data_carrier = PLAN_CARRIER(DATA_TONE_FREQ);
+const struct plan_carrier plan_sync_carrier = PLAN_CARRIER(SYNC_TONE_FREQ);
+
+int freq_plan_coeff(uint32_t freq, uint32_t sample_rate)
+{
+    int tone = 0;
+
+    if (sample_rate == PLAN_SAMPLE_RATE) {
+        for (tone = 0; tone < PLAN_NUM_TONES; tone++) {
+            if (plan_freqs[tone] == freq)
+                return plan_coeffs[tone];
+        }
+    }
+
+    return goertzel_coeff(freq, sample_rate);
+}
+
+int freq_plan_detector(struct sliding_goertzel* sg, uint32_t freq, uint32_t sample_rate, int hop, int hops)
+{
+    const struct plan_carrier* carrier = 0;
+
+    if (sample_rate == PLAN_SAMPLE_RATE && hop == HOP_SIZE) {
+        if (freq == DATA_TONE_FREQ)
+            carrier = &plan_data_carrier;
+        else if (freq == SYNC_TONE_FREQ)
+            carrier = &plan_sync_carrier;
+    }
+
+    if (!carrier)
+        return sliding_goertzel_init(sg, freq, sample_rate, hop, hops);
+
+    return sliding_goertzel_load(sg, carrier->coeff, carrier->cos_w, carrier->sin_w, carrier->rot_re, carrier->rot_im, hop, hops);
+}
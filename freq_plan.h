@@ -0,0 +1,167 @@
+//*****************************************************************************
+//
+// freq_plan.h - Sample rate, frame length and tones in one place
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#ifndef FREQ_PLAN_H_
+#define FREQ_PLAN_H_
+
+#include <stdint.h>
+#include "sliding_goertzel.h"
+
+//*****************************************************************************
+// The channel plan. Everything else (Goertzel coefficient tables, hop
+// rotations, bin numbers) is worked out from these by the compiler, and
+// freq_plan.c refuses to build a plan that breaks Nyquist, puts a tone
+// between bins or packs tones too close together.
+//   PLAN_SAMPLE_RATE   ADC rate the sampling timer runs at
+//   NUM_SAMPLES        samples per frame, also the length of a uDMA transfer
+//   HOP_SIZE           the sliding detectors report every HOP_SIZE samples
+// Tones must sit on a bin of a NUM_SAMPLES frame (50Hz at 51.2kHz).
+//*****************************************************************************
+#define PLAN_SAMPLE_RATE 51200
+#define NUM_SAMPLES 1024
+#define HOP_SIZE 128
+#define HOPS_PER_FRAME (NUM_SAMPLES / HOP_SIZE)
+
+#define DATA_TONE_FREQ 20000
+#define SYNC_TONE_FREQ 21000
+
+//*****************************************************************************
+// In MFSK mode every data frame is one symbol out of MFSK_NUM_TONES tones,
+// carrying MFSK_BITS_PER_SYMBOL bits. Tones are placed on multiples of the
+// 50Hz bin width so they stay orthogonal over a 1024 sample frame.
+//*****************************************************************************
+#define MFSK_BITS_PER_SYMBOL 3
+#define MFSK_NUM_TONES (1 << MFSK_BITS_PER_SYMBOL)
+#define MFSK_BASE_FREQ 18000
+#define MFSK_TONE_SPACING 750
+#define PLAN_MFSK_TONES(TONE) \
+    TONE(MFSK_0, MFSK_BASE_FREQ) \
+    TONE(MFSK_1, MFSK_BASE_FREQ + 1 * MFSK_TONE_SPACING) \
+    TONE(MFSK_2, MFSK_BASE_FREQ + 2 * MFSK_TONE_SPACING) \
+    TONE(MFSK_3, MFSK_BASE_FREQ + 3 * MFSK_TONE_SPACING) \
+    TONE(MFSK_4, MFSK_BASE_FREQ + 4 * MFSK_TONE_SPACING) \
+    TONE(MFSK_5, MFSK_BASE_FREQ + 5 * MFSK_TONE_SPACING) \
+    TONE(MFSK_6, MFSK_BASE_FREQ + 6 * MFSK_TONE_SPACING) \
+    TONE(MFSK_7, MFSK_BASE_FREQ + 7 * MFSK_TONE_SPACING)
+
+//*****************************************************************************
+// In DBPSK and DQPSK mode the data carrier stays on after the start sequence.
+// For DPSK_REFERENCE_FRAMES frames it holds still, the first sets the phase
+// and the next how far a clock error turns it in a frame. After them every
+// frame turns the phase on by one of 2 or 4 equal steps, carrying 1 or 2
+// bits. Symbol s turns it DPSK_GRAY(s) steps anticlockwise, so mistaking a
+// step for its neighbour costs a single bit (the mapping is its own inverse).
+//*****************************************************************************
+#define DBPSK_BITS_PER_SYMBOL 1
+#define DQPSK_BITS_PER_SYMBOL 2
+#define DPSK_REFERENCE_FRAMES 2
+#define DPSK_GRAY(SYMBOL) ((SYMBOL) ^ ((SYMBOL) >> 1))
+
+//*****************************************************************************
+// In OFDM mode the start sequence is followed by symbols of OFDM_NUM_BINS
+// subcarriers on neighbouring bins from OFDM_BASE_FREQ, all sent at once.
+// Each symbol is a frame long plus a guard of OFDM_GUARD samples, a copy of
+// its last samples sent first, so an error in where the receiver puts its
+// frame (it aims at the middle of the guard) only turns the phase of every
+// bin. Every OFDM_PILOT_SPACING-th subcarrier, the first and the last
+// included, is a pilot with a known phase for the receiver to measure the
+// channel on. The others each carry 2 bits as one of four phases, DPSK_GRAY
+// mapped.
+//*****************************************************************************
+#define OFDM_BASE_FREQ 18400
+#define OFDM_NUM_BINS 33
+#define OFDM_PILOT_SPACING 4
+#define OFDM_GUARD 256
+#define OFDM_BIN_WIDTH (PLAN_SAMPLE_RATE / NUM_SAMPLES)
+#define OFDM_CENTRE_FREQ (OFDM_BASE_FREQ + (OFDM_NUM_BINS - 1) * OFDM_BIN_WIDTH / 2)
+#define OFDM_SYMBOL_SAMPLES (NUM_SAMPLES + OFDM_GUARD)
+#define OFDM_WINDOW_OFFSET (OFDM_GUARD / 2)
+
+//*****************************************************************************
+// Noise floor reference bins, between the carriers and a few bins away from
+// each of them
+//*****************************************************************************
+#define PLAN_NOISE_REFS(TONE) \
+    TONE(REF_0, 19250) \
+    TONE(REF_1, 19750) \
+    TONE(REF_2, 20600) \
+    TONE(REF_3, 22100)
+
+#define PLAN_FREQ(NAME, FREQ) FREQ,
+#define NOISE_REF_FREQS { PLAN_NOISE_REFS(PLAN_FREQ) }
+#define NOISE_NUM_REFS (PLAN_NUM_TONES - PLAN_REF_0)
+
+//*****************************************************************************
+// Every tone of the plan, for the tables and the checks
+//*****************************************************************************
+#define PLAN_TONES(TONE) \
+    TONE(DATA, DATA_TONE_FREQ) \
+    TONE(SYNC, SYNC_TONE_FREQ) \
+    PLAN_MFSK_TONES(TONE) \
+    PLAN_NOISE_REFS(TONE)
+
+#define PLAN_TONE_ENUM(NAME, FREQ) PLAN_##NAME,
+enum PLAN_TONE {
+    PLAN_TONES(PLAN_TONE_ENUM)
+    PLAN_NUM_TONES
+};
+
+//*****************************************************************************
+// Bin of a tone in a NUM_SAMPLES frame
+//*****************************************************************************
+#define PLAN_BIN(FREQ) ((int)(((uint32_t)(FREQ) * NUM_SAMPLES + PLAN_SAMPLE_RATE / 2) / PLAN_SAMPLE_RATE))
+
+//*****************************************************************************
+// cos(2 pi NUM / DEN) as a constant expression, for static tables. NUM is
+// reduced modulo DEN and folded onto [0, pi] in integers, then
+// cos(a) = sin(pi / 2 - a) comes from a Taylor series that is good to 1e-11
+// over [-pi / 2, pi / 2], far below a Q14 step.
+//*****************************************************************************
+#define PLAN_PI 3.14159265358979
+#define PLAN_SIN_SERIES(T) ((T) * (1.0 - (T) * (T) / 6.0 * (1.0 - (T) * (T) / 20.0 * (1.0 - (T) * (T) / 42.0 \
+    * (1.0 - (T) * (T) / 72.0 * (1.0 - (T) * (T) / 110.0 * (1.0 - (T) * (T) / 156.0 * (1.0 - (T) * (T) / 210.0))))))))
+#define PLAN_FOLD(M, DEN) ((2 * (M) > (DEN)) ? (DEN) - (M) : (M))
+#define PLAN_COS(NUM, DEN) PLAN_SIN_SERIES(PLAN_PI / 2 - 2.0 * PLAN_PI * PLAN_FOLD((NUM) % (DEN), DEN) / (DEN))
+#define PLAN_SIN(NUM, DEN) PLAN_COS(4 * (NUM) + 3 * (DEN), 4 * (DEN))
+
+//*****************************************************************************
+// Round to Q14 the way the run time code does, floor(x * 2^14 + 0.5), for x
+// from -2 to 2
+//*****************************************************************************
+#define PLAN_Q14(X) ((int32_t)((X) * 16384.0 + 32768.5) - 32768)
+
+//*****************************************************************************
+// Goertzel coefficient 2 cos(w) of every tone, and the complete detector
+// setup of the two carriers for sliding_goertzel_load()
+//*****************************************************************************
+struct plan_carrier {
+    int32_t coeff;
+    int32_t cos_w, sin_w;
+    int32_t rot_re[SG_MAX_HOPS];
+    int32_t rot_im[SG_MAX_HOPS];
+};
+
+extern const uint32_t plan_freqs[PLAN_NUM_TONES];
+extern const int32_t plan_coeffs[PLAN_NUM_TONES];
+extern const struct plan_carrier plan_data_carrier;
+extern const struct plan_carrier plan_sync_carrier;
+
+//*****************************************************************************
+// Q14 coefficient of a tone from the table when it is part of the plan at
+// this sample rate, otherwise worked out with goertzel_coeff()
+//*****************************************************************************
+int freq_plan_coeff(uint32_t freq, uint32_t sample_rate);
+
+//*****************************************************************************
+// Set up a sliding detector from the tables when the tone is one of the
+// carriers at this sample rate and hop, otherwise with
+// sliding_goertzel_init(). Returns -1 if the tone is not on a bin.
+//*****************************************************************************
+int freq_plan_detector(struct sliding_goertzel* sg, uint32_t freq, uint32_t sample_rate, int hop, int hops);
+
+#endif // FREQ_PLAN_H_
@@ -0,0 +1,493 @@
+//*****************************************************************************
+//
+// goertzel.c - Fixed point Goertzel tone detectors
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <math.h>
+#include "goertzel.h"
+#include "freq_plan.h"
+
+#if defined(__TI_TMS470_V7M4__) || defined(__TI_ARM_V7M4__)
+#define GOERTZEL_SMLAD(x, y, acc) _smlad(x, y, acc)
+#elif defined(__ARM_FEATURE_DSP)
+#include <arm_acle.h>
+#define GOERTZEL_SMLAD(x, y, acc) __smlad(x, y, acc)
+#elif defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+//*****************************************************************************
+// -1.0 in Q14, the weight of delay_2 in the packed recurrence
+//*****************************************************************************
+#define BANK16_MINUS_ONE (-16384)
+
+//*****************************************************************************
+// goertzel_window() halves its states when one passes this. Then the next
+// recurrence step stays below 2^31: a 16 bit input, under 2 * 2^29 from
+// coeff * delay_1 and 2^29 from delay_2.
+//*****************************************************************************
+#define WINDOW_STATE_LIMIT (1 << 29)
+
+//*****************************************************************************
+// The window tables, entry j at j / (2 * GOERTZEL_WINDOW_POINTS) of the length
+//*****************************************************************************
+#define WINDOW_DEN (2 * GOERTZEL_WINDOW_POINTS)
+#define WINDOW_HANN(J) PLAN_Q14(0.5 - 0.5 * PLAN_COS(J, WINDOW_DEN)),
+#define WINDOW_BLACKMAN(J) PLAN_Q14(0.42 - 0.5 * PLAN_COS(J, WINDOW_DEN) + 0.08 * PLAN_COS(2 * (J), WINDOW_DEN)),
+#define WINDOW_8(W, J) W(J) W(J + 1) W(J + 2) W(J + 3) W(J + 4) W(J + 5) W(J + 6) W(J + 7)
+#define WINDOW_TABLE(W) { \
+    WINDOW_8(W, 0) WINDOW_8(W, 8) WINDOW_8(W, 16) WINDOW_8(W, 24) WINDOW_8(W, 32) WINDOW_8(W, 40) \
+    WINDOW_8(W, 48) WINDOW_8(W, 56) WINDOW_8(W, 64) WINDOW_8(W, 72) WINDOW_8(W, 80) WINDOW_8(W, 88) \
+    WINDOW_8(W, 96) WINDOW_8(W, 104) WINDOW_8(W, 112) WINDOW_8(W, 120) W(128) W(129) }
+
+typedef char window_points_listed[(GOERTZEL_WINDOW_POINTS == 128) ? 1 : -1];
+
+const int16_t goertzel_hann[GOERTZEL_WINDOW_SIZE] = WINDOW_TABLE(WINDOW_HANN);
+const int16_t goertzel_blackman[GOERTZEL_WINDOW_SIZE] = WINDOW_TABLE(WINDOW_BLACKMAN);
+
+int goertzel_isqrt(uint32_t value)
+{
+    uint32_t root = 0, bit = 1UL << 30;
+
+    while (bit > value)
+        bit >>= 2;
+
+    while (bit) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return (int)root;
+}
+
+uint32_t goertzel_isqrt64(uint64_t value)
+{
+    uint64_t root = 0, bit = (uint64_t)1 << 62;
+
+    while (bit > value)
+        bit >>= 2;
+    while (bit) {
+        if (value >= root + bit) {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+
+    return (uint32_t)root;
+}
+
+int goertzel(int16_t* data, int sz, int coeff)
+{
+    int32_t delay;
+    int32_t delay_1 = 0;
+    int32_t delay_2 = 0;
+    int goertzel_value = 0;
+    int prod1, prod2, prod3;
+    uint32_t input;
+    int32_t coef_1 = coeff;
+    int i = 0;
+
+    for (i = 0; i < sz; i++) {
+        input = data[i] >> 4; // Scale down input to prevent overflow
+        delay = input + (short)((delay_1 * coef_1) >> 14) - delay_2;
+        delay_2 = delay_1;
+        delay_1 = delay;
+    }
+
+    prod1 = (delay_1 * delay_1);
+    prod2 = (delay_2 * delay_2);
+    prod3 = (delay_1 * coef_1) >> 14;
+    prod3 = prod3 * delay_2;
+    goertzel_value = (prod1 + prod2 - prod3) >> 15;
+    goertzel_value <<= 6; // Scale up value for sensitivity
+
+    return goertzel_value;
+}
+
+void goertzel_complex(const int16_t* data, int sz, int coeff, int sin_w, int32_t* re, int32_t* im)
+{
+    int32_t delay;
+    int32_t delay_1 = 0;
+    int32_t delay_2 = 0;
+    int i = 0;
+
+    for (i = 0; i < sz; i++) {
+        delay = data[i] + (int32_t)(((int64_t)delay_1 * coeff) >> 14) - delay_2;
+        delay_2 = delay_1;
+        delay_1 = delay;
+    }
+
+    // delay_1 - e^(-jw) * delay_2, coeff is also cos(w) in Q15
+    *re = delay_1 - (int32_t)(((int64_t)delay_2 * coeff) >> 15);
+    *im = (int32_t)(((int64_t)delay_2 * sin_w) >> 14);
+}
+
+int32_t goertzel_window(const int16_t* data, int sz, int coeff, const int16_t* window)
+{
+    int32_t delay;
+    int32_t delay_1 = 0;
+    int32_t delay_2 = 0;
+    int32_t mean, low, high, value, weight;
+    uint32_t pos = 0, step, at;
+    int64_t sum = 0, gain = 0, power;
+    uint64_t amplitude;
+    int shift = 0, exponent = 0, scale;
+    int i = 0;
+
+    if (sz <= 0)
+        return 0;
+
+    // Block exponent: the largest shift that keeps the input within 16 bits
+    low = high = data[0];
+    for (i = 0; i < sz; i++) {
+        sum += data[i];
+        if (data[i] < low)
+            low = data[i];
+        if (data[i] > high)
+            high = data[i];
+    }
+    mean = (int32_t)(sum / sz);
+    high = (high - mean > mean - low) ? high - mean : mean - low;
+    if (!high)
+        return 0;
+    while ((high << (shift + 1)) < 0x8000)
+        shift++;
+
+    // Window position in 1/65536ths of a table entry, folded at the middle
+    step = (uint32_t)(((uint64_t)WINDOW_DEN << 16) / sz);
+
+    for (i = 0; i < sz; i++) {
+        value = (data[i] - mean) << shift;
+        if (window) {
+            at = (pos > ((uint32_t)GOERTZEL_WINDOW_POINTS << 16)) ? ((uint32_t)WINDOW_DEN << 16) - pos : pos;
+            weight = window[at >> 16] + (((window[(at >> 16) + 1] - window[at >> 16]) * (int32_t)(at & 0xFFFF)) >> 16);
+            value = (value * weight) >> 14;
+            gain += weight;
+            pos += step;
+        }
+        value = (value + ((1 << exponent) >> 1)) >> exponent;
+        delay = value + (int32_t)(((int64_t)delay_1 * coeff) >> 14) - delay_2;
+        delay_2 = delay_1;
+        delay_1 = delay;
+        if ((delay > WINDOW_STATE_LIMIT || delay < -WINDOW_STATE_LIMIT) && exponent < 30) {
+            delay_1 >>= 1;
+            delay_2 >>= 1;
+            exponent++;
+        }
+    }
+    if (!window)
+        gain = (int64_t)sz << 14;
+    if (!gain)
+        return 0;
+
+    // Each state is below 2^30, so the power fits 62 bits
+    power = (int64_t)delay_1 * delay_1 + (int64_t)delay_2 * delay_2
+        - (((int64_t)delay_1 * coeff) >> 14) * delay_2;
+    if (power <= 0)
+        return 0;
+
+    // Amplitude = 2 |bin| 2^(exponent - shift) / (gain / 2^14)
+    amplitude = ((uint64_t)goertzel_isqrt64((uint64_t)power) << (15 + GOERTZEL_AMPLITUDE_SHIFT)) / (uint64_t)gain;
+    scale = exponent - shift;
+    if (scale < 0)
+        amplitude = (amplitude + (((uint64_t)1 << -scale) >> 1)) >> -scale;
+    else if (scale > 0)
+        amplitude = (amplitude > ((uint64_t)INT32_MAX >> scale)) ? (uint64_t)INT32_MAX : amplitude << scale;
+
+    return (amplitude > INT32_MAX) ? INT32_MAX : (int32_t)amplitude;
+}
+
+int goertzel_coeff(uint32_t target_freq, uint32_t sample_rate)
+{
+    double w = (2.0 * 3.14159265358979 * target_freq) / sample_rate;
+
+    return (int)floor(2.0 * cos(w) * (1 << 14) + 0.5);
+}
+
+void goertzel_bank(const int16_t* data, int sz, const int* coeffs, int* power, int num_bins)
+{
+    int32_t delay;
+    int32_t delay_1[GOERTZEL_MAX_BINS] = { 0 };
+    int32_t delay_2[GOERTZEL_MAX_BINS] = { 0 };
+    int32_t input;
+    int prod1, prod2, prod3;
+    int i = 0, bin = 0;
+
+    if (num_bins > GOERTZEL_MAX_BINS)
+        num_bins = GOERTZEL_MAX_BINS;
+
+    // Every sample is loaded once and fed to all of the bins together
+    for (i = 0; i < sz; i++) {
+        input = data[i] >> 4; // Same input scaling as goertzel()
+        for (bin = 0; bin < num_bins; bin++) {
+            delay = input + (short)((delay_1[bin] * coeffs[bin]) >> 14) - delay_2[bin];
+            delay_2[bin] = delay_1[bin];
+            delay_1[bin] = delay;
+        }
+    }
+
+    for (bin = 0; bin < num_bins; bin++) {
+        prod1 = (delay_1[bin] * delay_1[bin]);
+        prod2 = (delay_2[bin] * delay_2[bin]);
+        prod3 = (delay_1[bin] * coeffs[bin]) >> 14;
+        prod3 = prod3 * delay_2[bin];
+        power[bin] = ((prod1 + prod2 - prod3) >> 15) << 6;
+    }
+}
+
+//*****************************************************************************
+// Power of a 16 bit state bank, same formula as goertzel()
+//*****************************************************************************
+static void bank16_power(const int16_t* delay_1, const int16_t* delay_2, const int* coeffs, int* power, int num_bins)
+{
+    int prod1, prod2, prod3;
+    int bin = 0;
+
+    for (bin = 0; bin < num_bins; bin++) {
+        prod1 = (delay_1[bin] * delay_1[bin]);
+        prod2 = (delay_2[bin] * delay_2[bin]);
+        prod3 = (delay_1[bin] * coeffs[bin]) >> 14;
+        prod3 = prod3 * delay_2[bin];
+        power[bin] = ((prod1 + prod2 - prod3) >> 15) << 6;
+    }
+}
+
+//*****************************************************************************
+// delay = ((coeff * delay_1 - 1.0 * delay_2 + input) in Q14) >> 14, which is
+// the goertzel() recurrence without any rounding in between. It can't
+// overflow 32 bits for 16 bit states and 8 bit inputs.
+//*****************************************************************************
+void goertzel_bank16_scalar(const int16_t* data, int sz, const int* coeffs, int* power, int num_bins)
+{
+    int16_t delay_1[GOERTZEL_MAX_BINS] = { 0 };
+    int16_t delay_2[GOERTZEL_MAX_BINS] = { 0 };
+    int32_t input;
+    int16_t delay;
+    int i = 0, bin = 0;
+
+    if (num_bins > GOERTZEL_MAX_BINS)
+        num_bins = GOERTZEL_MAX_BINS;
+
+    for (i = 0; i < sz; i++) {
+        input = (data[i] >> 4) << 14;
+        for (bin = 0; bin < num_bins; bin++) {
+            delay = (int16_t)((coeffs[bin] * delay_1[bin] + BANK16_MINUS_ONE * delay_2[bin] + input) >> 14);
+            delay_2[bin] = delay_1[bin];
+            delay_1[bin] = delay;
+        }
+    }
+
+    bank16_power(delay_1, delay_2, coeffs, power, num_bins);
+}
+
+#if defined(GOERTZEL_SMLAD)
+
+//*****************************************************************************
+// Each bin is one word holding delay_1 in the bottom and delay_2 in the top
+// half, so SMLAD does both products of the recurrence in one instruction
+//*****************************************************************************
+void goertzel_bank16(const int16_t* data, int sz, const int* coeffs, int* power, int num_bins)
+{
+    uint32_t state[GOERTZEL_MAX_BINS] = { 0 };
+    uint32_t weights[GOERTZEL_MAX_BINS];
+    int16_t delay_1[GOERTZEL_MAX_BINS];
+    int16_t delay_2[GOERTZEL_MAX_BINS];
+    int32_t input, delay;
+    int i = 0, bin = 0;
+
+    if (num_bins > GOERTZEL_MAX_BINS)
+        num_bins = GOERTZEL_MAX_BINS;
+
+    for (bin = 0; bin < num_bins; bin++)
+        weights[bin] = (coeffs[bin] & 0xFFFF) | ((uint32_t)BANK16_MINUS_ONE << 16);
+
+    for (i = 0; i < sz; i++) {
+        input = (data[i] >> 4) << 14;
+        for (bin = 0; bin < num_bins; bin++) {
+            delay = GOERTZEL_SMLAD(state[bin], weights[bin], input) >> 14;
+            state[bin] = (delay & 0xFFFF) | (state[bin] << 16);
+        }
+    }
+
+    for (bin = 0; bin < num_bins; bin++) {
+        delay_1[bin] = (int16_t)state[bin];
+        delay_2[bin] = (int16_t)(state[bin] >> 16);
+    }
+    bank16_power(delay_1, delay_2, coeffs, power, num_bins);
+}
+
+#elif defined(__AVX2__) || defined(__SSE2__)
+
+#if defined(__AVX2__)
+#define BANK16_LANES 8
+typedef __m256i bank16_vec;
+#define BANK16_MADD _mm256_madd_epi16
+#define BANK16_ADD _mm256_add_epi32
+#define BANK16_SRAI _mm256_srai_epi32
+#define BANK16_SLLI _mm256_slli_epi32
+#define BANK16_AND _mm256_and_si256
+#define BANK16_OR _mm256_or_si256
+#define BANK16_SET1 _mm256_set1_epi32
+#define BANK16_LOAD(p) _mm256_loadu_si256((const __m256i*)(p))
+#define BANK16_STORE(p, v) _mm256_storeu_si256((__m256i*)(p), v)
+#else
+#define BANK16_LANES 4
+typedef __m128i bank16_vec;
+#define BANK16_MADD _mm_madd_epi16
+#define BANK16_ADD _mm_add_epi32
+#define BANK16_SRAI _mm_srai_epi32
+#define BANK16_SLLI _mm_slli_epi32
+#define BANK16_AND _mm_and_si128
+#define BANK16_OR _mm_or_si128
+#define BANK16_SET1 _mm_set1_epi32
+#define BANK16_LOAD(p) _mm_loadu_si128((const __m128i*)(p))
+#define BANK16_STORE(p, v) _mm_storeu_si128((__m128i*)(p), v)
+#endif
+
+#define BANK16_GROUPS (GOERTZEL_MAX_BINS / BANK16_LANES)
+
+//*****************************************************************************
+// Same packing as the SMLAD version with one bin per 32 bit lane, PMADDWD
+// is SMLAD across all lanes at once
+//*****************************************************************************
+void goertzel_bank16(const int16_t* data, int sz, const int* coeffs, int* power, int num_bins)
+{
+    bank16_vec state[BANK16_GROUPS], weights[BANK16_GROUPS];
+    bank16_vec input, delay, low = BANK16_SET1(0xFFFF);
+    int16_t packed[2 * GOERTZEL_MAX_BINS] = { 0 };
+    int16_t delay_1[GOERTZEL_MAX_BINS];
+    int16_t delay_2[GOERTZEL_MAX_BINS];
+    int i = 0, bin = 0, group = 0, groups = 0;
+
+    if (num_bins > GOERTZEL_MAX_BINS)
+        num_bins = GOERTZEL_MAX_BINS;
+    groups = (num_bins + BANK16_LANES - 1) / BANK16_LANES;
+
+    // Unused lanes of the last group run with a zero coefficient
+    for (bin = 0; bin < num_bins; bin++) {
+        packed[2 * bin] = coeffs[bin];
+        packed[2 * bin + 1] = BANK16_MINUS_ONE;
+    }
+    for (group = 0; group < groups; group++) {
+        weights[group] = BANK16_LOAD(&packed[2 * BANK16_LANES * group]);
+        state[group] = BANK16_SET1(0);
+    }
+
+    for (i = 0; i < sz; i++) {
+        input = BANK16_SET1((data[i] >> 4) << 14);
+        for (group = 0; group < groups; group++) {
+            delay = BANK16_SRAI(BANK16_ADD(BANK16_MADD(state[group], weights[group]), input), 14);
+            state[group] = BANK16_OR(BANK16_AND(delay, low), BANK16_SLLI(state[group], 16));
+        }
+    }
+
+    for (group = 0; group < groups; group++)
+        BANK16_STORE(&packed[2 * BANK16_LANES * group], state[group]);
+    for (bin = 0; bin < num_bins; bin++) {
+        delay_1[bin] = packed[2 * bin];
+        delay_2[bin] = packed[2 * bin + 1];
+    }
+    bank16_power(delay_1, delay_2, coeffs, power, num_bins);
+}
+
+#elif defined(__ARM_NEON)
+
+#define BANK16_GROUPS (GOERTZEL_MAX_BINS / 4)
+
+//*****************************************************************************
+// NEON has no pairwise 16 bit multiply-add, so delay_1 and delay_2 are kept
+// in separate vectors and combined with a widening multiply and subtract.
+// The narrowing shift wraps just like the (int16_t) cast of the scalar code.
+//*****************************************************************************
+void goertzel_bank16(const int16_t* data, int sz, const int* coeffs, int* power, int num_bins)
+{
+    int16x4_t state_1[BANK16_GROUPS], state_2[BANK16_GROUPS], weights[BANK16_GROUPS], delay;
+    int32x4_t input;
+    int16_t packed[GOERTZEL_MAX_BINS] = { 0 };
+    int16_t delay_1[GOERTZEL_MAX_BINS];
+    int16_t delay_2[GOERTZEL_MAX_BINS];
+    int i = 0, bin = 0, group = 0, groups = 0;
+
+    if (num_bins > GOERTZEL_MAX_BINS)
+        num_bins = GOERTZEL_MAX_BINS;
+    groups = (num_bins + 3) / 4;
+
+    for (bin = 0; bin < num_bins; bin++)
+        packed[bin] = coeffs[bin];
+    for (group = 0; group < groups; group++) {
+        weights[group] = vld1_s16(&packed[4 * group]);
+        state_1[group] = state_2[group] = vdup_n_s16(0);
+    }
+
+    for (i = 0; i < sz; i++) {
+        input = vdupq_n_s32((data[i] >> 4) << 14);
+        for (group = 0; group < groups; group++) {
+            delay = vshrn_n_s32(vmlsl_n_s16(vmlal_s16(input, state_1[group], weights[group]), state_2[group], -BANK16_MINUS_ONE), 14);
+            state_2[group] = state_1[group];
+            state_1[group] = delay;
+        }
+    }
+
+    for (group = 0; group < groups; group++) {
+        vst1_s16(&delay_1[4 * group], state_1[group]);
+        vst1_s16(&delay_2[4 * group], state_2[group]);
+    }
+    bank16_power(delay_1, delay_2, coeffs, power, num_bins);
+}
+
+#else
+
+void goertzel_bank16(const int16_t* data, int sz, const int* coeffs, int* power, int num_bins)
+{
+    goertzel_bank16_scalar(data, sz, coeffs, power, num_bins);
+}
+
+#endif
+
+int goertzel_strongest(const int* power, int num_bins, int threshold)
+{
+    int bin = 0, best = -1;
+    int best_power = threshold - 1;
+
+    for (bin = 0; bin < num_bins; bin++) {
+        if (power[bin] > best_power) {
+            best_power = power[bin];
+            best = bin;
+        }
+    }
+
+    return best;
+}
+
+int goertzel_nearest_phase(int64_t re, int64_t im, int steps)
+{
+    int64_t mag_re = (re < 0) ? -re : re;
+    int64_t mag_im = (im < 0) ? -im : im;
+
+    if (steps == 2)
+        return (re < 0) ? 1 : 0;
+
+    // Quarter turns, split on the diagonals
+    if (re > mag_im)
+        return 0;
+    if (im >= mag_re)
+        return 1;
+    if (-re > mag_im)
+        return 2;
+
+    return 3;
+}
@@ -0,0 +1,106 @@
+//*****************************************************************************
+//
+// goertzel.h - Fixed point Goertzel tone detectors
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#ifndef GOERTZEL_H_
+#define GOERTZEL_H_
+
+#include <stdint.h>
+
+//*****************************************************************************
+// Largest number of tones that can be evaluated in a single bank pass
+//*****************************************************************************
+#define GOERTZEL_MAX_BINS 16
+
+//*****************************************************************************
+// Single bin detector, coefficient is 2*cos(w) in Q14 format
+//*****************************************************************************
+int goertzel(int16_t* data, int sz, int coeff);
+
+//*****************************************************************************
+// Single bin detector that keeps the phase. re and im are the DFT bin of the
+// block turned by an angle that only depends on sz and the tone, so the bins
+// of two blocks of a phase continuous tone differ by the phase it moved in
+// between. coeff is 2*cos(w) in Q14 as for goertzel(), sin_w is sin(w) in
+// Q14. The states are 32 bits and the input is not scaled, a tone on the bin
+// gives a magnitude of amplitude * sz / 2.
+//*****************************************************************************
+void goertzel_complex(const int16_t* data, int sz, int coeff, int sin_w, int32_t* re, int32_t* im);
+
+//*****************************************************************************
+// Window tables for goertzel_window(). A window is symmetric, so a table
+// holds its first half: entry j is the weight at j / (2 * GOERTZEL_WINDOW_POINTS)
+// of the window length in Q14, for j up to GOERTZEL_WINDOW_POINTS + 1 (the
+// last entry repeats the one two before it). Windows of any length are
+// interpolated from it. Both tables are const and stay in flash.
+//*****************************************************************************
+#define GOERTZEL_WINDOW_POINTS 128
+#define GOERTZEL_WINDOW_SIZE (GOERTZEL_WINDOW_POINTS + 2)
+
+extern const int16_t goertzel_hann[GOERTZEL_WINDOW_SIZE];
+extern const int16_t goertzel_blackman[GOERTZEL_WINDOW_SIZE];
+
+//*****************************************************************************
+// Fractional bits of the amplitude goertzel_window() returns
+//*****************************************************************************
+#define GOERTZEL_AMPLITUDE_SHIFT 8
+
+//*****************************************************************************
+// Block floating point detector for blocks of any length. The block mean is
+// taken off, the rest is shifted up to 16 bits and multiplied by the window
+// (0 for none), and the 32 bit states are halved whenever they pass 2^29,
+// with the input shifted down to match, so nothing is thrown away up front
+// and nothing wraps however long the block is. Returns the amplitude of a
+// tone on the bin in ADC counts, GOERTZEL_AMPLITUDE_SHIFT bits after the
+// point: the magnitude of the bin over the sum of the window weights, so it
+// does not depend on sz or the window. coeff is 2*cos(w) in Q14 as for
+// goertzel().
+//*****************************************************************************
+int32_t goertzel_window(const int16_t* data, int sz, int coeff, const int16_t* window);
+
+//*****************************************************************************
+// Calculate the Q14 coefficient for a tone at the given sampling rate
+//*****************************************************************************
+int goertzel_coeff(uint32_t target_freq, uint32_t sample_rate);
+
+//*****************************************************************************
+// Evaluate several bins with one pass over the samples. Each power[] entry
+// matches what goertzel() would return for the same coefficient.
+//*****************************************************************************
+void goertzel_bank(const int16_t* data, int sz, const int* coeffs, int* power, int num_bins);
+
+//*****************************************************************************
+// Bank with 16 bit filter states, so the whole recurrence of a bin is one
+// multiply-accumulate of packed (delay_1, delay_2) by (coeff, -1.0):
+// SMLAD on the Cortex-M4, PMADDWD lanes with SSE2/AVX2 and VMULL/VMLSL with
+// NEON on a PC. goertzel_bank16_scalar() is the portable version, every
+// vector version returns exactly the same power. Both match goertzel() as
+// long as the states stay within 16 bits, about 600 counts of tone amplitude
+// on the 12 bit ADC (goertzel() wraps at a similar level). Coefficients must
+// be below 2.0 (any tone above DC).
+//*****************************************************************************
+void goertzel_bank16(const int16_t* data, int sz, const int* coeffs, int* power, int num_bins);
+void goertzel_bank16_scalar(const int16_t* data, int sz, const int* coeffs, int* power, int num_bins);
+
+//*****************************************************************************
+// Pick the strongest bin of a bank, -1 if none reach the threshold
+//*****************************************************************************
+int goertzel_strongest(const int* power, int num_bins, int threshold);
+
+//*****************************************************************************
+// Which of steps phases (2 or 4, a whole number of steps of a turn
+// anticlockwise from 0) a complex value is nearest to
+//*****************************************************************************
+int goertzel_nearest_phase(int64_t re, int64_t im, int steps);
+
+//*****************************************************************************
+// Integer square roots, rounded down. Turn an energy back into a magnitude.
+//*****************************************************************************
+int goertzel_isqrt(uint32_t value);
+uint32_t goertzel_isqrt64(uint64_t value);
+
+#endif // GOERTZEL_H_
@@ -8,11 +8,13 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdarg.h>
 #include "inc/hw_ints.h"
 #include "inc/hw_memmap.h"
 #include "inc/hw_types.h"
 #include "inc/hw_adc.h"
 #include "inc/hw_udma.h"
+#include "inc/hw_uart.h"
 #include "driverlib/debug.h"
 #include "driverlib/fpu.h"
 #include "driverlib/gpio.h"
@@ -23,16 +25,62 @@
 #include "driverlib/timer.h"
 #include "driverlib/udma.h"
 #include "driverlib/uart.h"
-#include "utils/uartstdio.h"
 #include "driverlib/adc.h"
 #include "driverlib/systick.h"
+#include "decoder.h"
+#include "frame_queue.h"
+#include "console.h"
+#include "telemetry.h"
+#include "recorder.h"
+#include "cobs.h"
+
+//*****************************************************************************
+// Build with TELEMETRY=1 to follow every frame with a binary record on the
+// UART (tools/telemetry_view.c reads them). The decoding time comes from the
+// DWT cycle counter.
+//*****************************************************************************
+#ifndef TELEMETRY
+#define TELEMETRY 0
+#endif
+
+//*****************************************************************************
+// Build with MIC_CHANNELS=2 or 4 to listen on that many microphones, combined
+// by MIC_DIVERSITY (see diversity.h). ADC0 sequence 0 then takes one reading
+// of each per timer period and the uDMA moves them interleaved, which the
+// main loop sorts into one frame per microphone. Each microphone costs
+// (FRAME_DEPTH + 1) * 2KB of frames, more than the 32KB TM4C123GH6PM has left
+// beside the flight recorder, so this is meant for a part with more SRAM.
+// 3 microphones would need a uDMA burst of 3, which does not exist.
+//*****************************************************************************
+#ifndef MIC_CHANNELS
+#define MIC_CHANNELS 1
+#endif
+#ifndef MIC_DIVERSITY
+#define MIC_DIVERSITY DIVERSITY_MAX_RATIO
+#endif
+
+#if MIC_CHANNELS == 1
+#define MIC_ARB UDMA_ARB_1
+#elif MIC_CHANNELS == 2
+#define MIC_ARB UDMA_ARB_2
+#elif MIC_CHANNELS == 4
+#define MIC_ARB UDMA_ARB_4
+#else
+#error "MIC_CHANNELS must be 1, 2 or 4"
+#endif
+
+#define DEM_CR (*(volatile uint32_t*)0xE000EDFC)
+#define DEM_CR_TRCENA (1u << 24)
+#define DWT_CTRL (*(volatile uint32_t*)0xE0001000)
+#define DWT_CTRL_CYCCNTENA 1u
+#define DWT_CYCCNT (*(volatile uint32_t*)0xE0001004)
 
 //*****************************************************************************
 // Sampling rate for microphone. Based on Nyquist, we need atleast 2x our max
-// frequency of 22kHz. We have the resources overshoot to avoid issues
+// frequency of 22kHz. We have the resources overshoot to avoid issues. The
+// channel plan in freq_plan.h checks the tones against it.
 //*****************************************************************************
-#define NUM_SAMPLES 1024
-uint16_t sampling_rate = NUM_SAMPLES * 10 * 5;
+uint32_t sampling_rate = PLAN_SAMPLE_RATE;
 
 //*****************************************************************************
 // Buffer for the 5 FFT calculations, representing 1 Bit of data
@@ -46,50 +94,51 @@ uint16_t bit_buffer[5] = { 0 };
 uint8_t g_ui32Flags;
 
 //*****************************************************************************
-// Store data for the frames and bytes collected
+// Decoder state for the microphone stream
 //*****************************************************************************
-bool transfer_status = false;
-int amplitude_buffer[5] = { 0 };
-volatile int bit_output_index = 0;
-int frame_count = 0;
-char data_byte = 0;
+struct decoder decoder;
+#if MIC_CHANNELS > 1
+struct diversity diversity;
+#endif
 
 //*****************************************************************************
-// Create buffer for PingPong uDMA and create enum for status
+// Microphone inputs in the order the sequence samples them, all on port E:
+// AIN8 (PE5), AIN9 (PE4), AIN2 (PE1) and AIN1 (PE2)
 //*****************************************************************************
-int16_t ADC_Out1[NUM_SAMPLES];
-int16_t ADC_Out2[NUM_SAMPLES];
-enum BUFFERSTATUS {
-    EMPTY,
-    FILLING,
-    FULL
-};
-enum BUFFERSTATUS BufferStatus[2];
+const uint32_t mic_inputs[4] = { ADC_CTL_CH8, ADC_CTL_CH9, ADC_CTL_CH2, ADC_CTL_CH1 };
+const uint8_t mic_pins[4] = { GPIO_PIN_5, GPIO_PIN_4, GPIO_PIN_1, GPIO_PIN_2 };
 
 //*****************************************************************************
-// This enum is used to ensure synchronization with initial bits/frames
+// Frames from the PingPong uDMA wait in a queue of FRAME_DEPTH buffers, so
+// the main loop can fall behind for a few frames (long UART output) without
+// losing any. One more buffer takes the samples that have to be dropped
+// when it falls further behind than that. A frame holds the readings of
+// every microphone.
 //*****************************************************************************
-enum SYNCHRONIZATION {
-    FAILED = -1,
-    NONE,
-    ONE,
-    ZERO,
-    COMPLETE
-};
-volatile enum SYNCHRONIZATION byte_sync = ONE;
+#define FRAME_DEPTH 4
+#define FRAME_READINGS (MIC_CHANNELS * NUM_SAMPLES)
+int16_t ADC_Frames[(FRAME_DEPTH + 1) * FRAME_READINGS];
+struct frame_queue adc_queue;
 
 //*****************************************************************************
-// Store some coefficients for goertzel.These are formatted in Q14 format to
-// achieve fixed point calculations
+// Text for the UART waits in the console ring and is sent by uDMA, so the
+// decoder never waits for the serial port. tx_length is the size of the
+// transfer in progress, only touched by the UART interrupt.
 //*****************************************************************************
-#define goe_coeff(TARGET_FREQ) ((2.0 * cos((2.0 * pi * (0.5 + ((NUM_SAMPLES * (TARGET_FREQ)) / NUM_SAMPLES))) / 46080)) * pow(2, 14))
-#define twenty_khz -25331
-#define twenty_one_khz -27685
+struct console console;
+uint32_t tx_length;
 
 //*****************************************************************************
-// To debug, we can store the last 500 frames
+// To debug, the flight recorder keeps the last frames and what the decoder
+// did with them. It freezes when sync is lost or a packet is rejected; send
+// 'd' on the UART to dump it (tools/recorder_dump.c turns the dump into a WAV
+// file) and 'a' to record again. A block of the dump waits in dump_block
+// until the console ring has room for it.
 //*****************************************************************************
-uint8_t output[5000];
+struct recorder recorder;
+volatile int recorder_command;
+uint8_t dump_block[COBS_ENCODED_SIZE(RECORDER_MAX_BLOCK)];
+int dump_length;
 
 //*****************************************************************************
 // Control table for uDMA transfers
@@ -97,57 +146,163 @@ uint8_t output[5000];
 #pragma DATA_ALIGN(ucControlTable, 1024)
 uint8_t ucControlTable[1024];
 
-int goertzel(int16_t* data, int sz, int coeff)
+//*****************************************************************************
+// A uDMA transfer is at most 1024 items, so with several microphones a frame
+// is filled by MIC_CHANNELS transfers of NUM_SAMPLES readings. NextTransfer()
+// hands out the parts of the frames in turn and FinishTransfer() publishes a
+// frame once its last part is in.
+//*****************************************************************************
+int16_t* NextTransfer(void)
 {
-    int32_t delay;
-    int32_t delay_1 = 0;
-    int32_t delay_2 = 0;
-    int goertzel_value = 0;
-    int prod1, prod2, prod3;
-    uint32_t input;
-    int32_t coef_1 = coeff;
-    int i = 0;
-
-    for (i = 0; i < sz; i++) {
-        input = data[i] >> 4; // Scale down input to prevent overflow
-        delay = input + (short)((delay_1 * coef_1) >> 14) - delay_2;
-        delay_2 = delay_1;
-        delay_1 = delay;
-    }
+    static int16_t* frame;
+    static int part;
+    int16_t* buffer;
 
-    prod1 = (delay_1 * delay_1);
-    prod2 = (delay_2 * delay_2);
-    prod3 = (delay_1 * coef_1) >> 14;
-    prod3 = prod3 * delay_2;
-    goertzel_value = (prod1 + prod2 - prod3) >> 15;
-    goertzel_value <<= 6; // Scale up value for sensitivity
+    if (!part)
+        frame = frame_queue_arm(&adc_queue);
+    buffer = frame + part * NUM_SAMPLES;
+    part = (part + 1) % MIC_CHANNELS;
 
-    return goertzel_value;
+    return buffer;
 }
 
+void FinishTransfer(void)
+{
+    static int part;
+
+    part = (part + 1) % MIC_CHANNELS;
+    if (!part)
+        frame_queue_complete(&adc_queue);
+}
+
+//*****************************************************************************
+// The primary and alternate transfers finish in turn. Publish what just
+// completed and point that half of the ping-pong at the next free buffer.
+//*****************************************************************************
 void ADC3IntHandler(void)
 {
     ADCIntClear(ADC0_BASE, 0);
 
-    if ((uDMAChannelModeGet(UDMA_CHANNEL_ADC0 | UDMA_PRI_SELECT) == UDMA_MODE_STOP)
-        && (BufferStatus[0] == FILLING)) {
-        BufferStatus[0] = FULL;
-        BufferStatus[1] = FILLING;
-        uDMAChannelTransferSet(UDMA_CHANNEL_ADC0 | UDMA_PRI_SELECT, UDMA_MODE_PINGPONG, (void*)(ADC0_BASE + ADC_O_SSFIFO0), &ADC_Out1, NUM_SAMPLES);
+    if (uDMAChannelModeGet(UDMA_CHANNEL_ADC0 | UDMA_PRI_SELECT) == UDMA_MODE_STOP) {
+        FinishTransfer();
+        uDMAChannelTransferSet(UDMA_CHANNEL_ADC0 | UDMA_PRI_SELECT, UDMA_MODE_PINGPONG, (void*)(ADC0_BASE + ADC_O_SSFIFO0), NextTransfer(), NUM_SAMPLES);
     }
-    else if ((uDMAChannelModeGet(UDMA_CHANNEL_ADC0 | UDMA_ALT_SELECT) == UDMA_MODE_STOP)
-        && (BufferStatus[1] == FILLING)) {
-        BufferStatus[0] = FILLING;
-        BufferStatus[1] = FULL;
-        uDMAChannelTransferSet(UDMA_CHANNEL_ADC0 | UDMA_ALT_SELECT, UDMA_MODE_PINGPONG, (void*)(ADC0_BASE + ADC_O_SSFIFO0), &ADC_Out2, NUM_SAMPLES);
+    else if (uDMAChannelModeGet(UDMA_CHANNEL_ADC0 | UDMA_ALT_SELECT) == UDMA_MODE_STOP) {
+        FinishTransfer();
+        uDMAChannelTransferSet(UDMA_CHANNEL_ADC0 | UDMA_ALT_SELECT, UDMA_MODE_PINGPONG, (void*)(ADC0_BASE + ADC_O_SSFIFO0), NextTransfer(), NUM_SAMPLES);
     }
 }
 
 //*****************************************************************************
-// Configure the ADC Port 4 Pin 5 (AIN8)
+// Runs when a UART uDMA transfer finishes and when new text is queued. Frees
+// what was sent and starts on the next contiguous block of the ring.
+//*****************************************************************************
+void UART0IntHandler(void)
+{
+    const char* data;
+
+    UARTIntClear(UART0_BASE, UARTIntStatus(UART0_BASE, true));
+
+    // Commands for the main loop, the last one wins
+    while (UARTCharsAvail(UART0_BASE))
+        recorder_command = UARTCharGetNonBlocking(UART0_BASE);
+
+    // The channel disables itself once the transfer is done
+    if (tx_length && !uDMAChannelIsEnabled(UDMA_CHANNEL_UART0TX)) {
+        console_consume(&console, tx_length);
+        tx_length = 0;
+    }
+
+    if (!tx_length) {
+        tx_length = console_pending(&console, &data);
+        if (tx_length) {
+            uDMAChannelTransferSet(UDMA_CHANNEL_UART0TX | UDMA_PRI_SELECT, UDMA_MODE_BASIC, (void*)data, (void*)(UART0_BASE + UART_O_DR), tx_length);
+            uDMAChannelEnable(UDMA_CHANNEL_UART0TX);
+        }
+    }
+}
+
+//*****************************************************************************
+// printf to the UART without waiting. Text that doesn't fit in the console
+// ring is dropped and counted.
+//*****************************************************************************
+void ConsolePrintf(const char* format, ...)
+{
+    va_list args;
+
+    va_start(args, format);
+    console_vprintf(&console, format, args);
+    va_end(args);
+
+    // Let the UART interrupt start a transfer if it is idle
+    IntPendSet(INT_UART0);
+}
+
+//*****************************************************************************
+// Queue the record of a decoded frame behind the text it caused
+//*****************************************************************************
+void SendTelemetry(uint32_t sequence, uint32_t dropped, uint32_t cycles)
+{
+    static uint32_t dropped_messages;
+    struct telemetry_record rec;
+    uint8_t encoded[TELEMETRY_ENCODED_SIZE];
+
+    telemetry_capture(&rec, &decoder);
+    rec.sequence = sequence;
+    rec.cycles = cycles;
+    rec.dropped = (uint8_t)((dropped > 255) ? 255 : dropped);
+    if (dropped)
+        rec.flags |= TELEMETRY_OVERRUN;
+    if (console.dropped_messages != dropped_messages)
+        rec.flags |= TELEMETRY_TEXT_DROPPED;
+    dropped_messages = console.dropped_messages;
+
+    console_write(&console, (const char*)encoded, telemetry_encode(&rec, encoded));
+    IntPendSet(INT_UART0);
+}
+
+//*****************************************************************************
+// Act on a recorder command and queue as much of a dump as the console ring
+// has room for
+//*****************************************************************************
+void ServiceRecorder(void)
+{
+    int command;
+
+    // Masked so a command the UART interrupt stores in between isn't cleared
+    ROM_IntMasterDisable();
+    command = recorder_command;
+    recorder_command = 0;
+    ROM_IntMasterEnable();
+
+    if (command == 'd') {
+        recorder_dump_start(&recorder);
+        dump_length = 0;
+    } else if (command == 'a') {
+        recorder_arm(&recorder);
+        dump_length = 0;
+        ConsolePrintf("Recorder armed\n");
+    }
+
+    while (1) {
+        if (!dump_length)
+            dump_length = recorder_dump_next(&recorder, &decoder, dump_block);
+        if (!dump_length || console_space(&console) < dump_length)
+            break;
+        console_write(&console, (const char*)dump_block, dump_length);
+        dump_length = 0;
+        IntPendSet(INT_UART0);
+    }
+}
+
+//*****************************************************************************
+// Configure the ADC Port 4 Pin 5 (AIN8), and the other microphone inputs
+// with MIC_CHANNELS
 //*****************************************************************************
 void ConfigureADCuDMA(void)
 {
+    int mic = 0;
+
     // Enables uDMA
     uDMAEnable();
     uDMAControlBaseSet(ucControlTable);
@@ -157,19 +312,21 @@ void ConfigureADCuDMA(void)
     // Only allow burst transfers
     uDMAChannelAttributeEnable(UDMA_CHANNEL_ADC0, UDMA_ATTR_USEBURST);
 
-    uDMAChannelControlSet(UDMA_CHANNEL_ADC0 | UDMA_PRI_SELECT, UDMA_SIZE_16 | UDMA_SRC_INC_NONE | UDMA_DST_INC_16 | UDMA_ARB_1);
-    uDMAChannelControlSet(UDMA_CHANNEL_ADC0 | UDMA_ALT_SELECT, UDMA_SIZE_16 | UDMA_SRC_INC_NONE | UDMA_DST_INC_16 | UDMA_ARB_1);
+    // Every trigger puts one reading of each microphone in the FIFO
+    uDMAChannelControlSet(UDMA_CHANNEL_ADC0 | UDMA_PRI_SELECT, UDMA_SIZE_16 | UDMA_SRC_INC_NONE | UDMA_DST_INC_16 | MIC_ARB);
+    uDMAChannelControlSet(UDMA_CHANNEL_ADC0 | UDMA_ALT_SELECT, UDMA_SIZE_16 | UDMA_SRC_INC_NONE | UDMA_DST_INC_16 | MIC_ARB);
 
-    uDMAChannelTransferSet(UDMA_CHANNEL_ADC0 | UDMA_PRI_SELECT, UDMA_MODE_PINGPONG, (void*)(ADC0_BASE + ADC_O_SSFIFO0), &ADC_Out1, NUM_SAMPLES);
-    uDMAChannelTransferSet(UDMA_CHANNEL_ADC0 | UDMA_ALT_SELECT, UDMA_MODE_PINGPONG, (void*)(ADC0_BASE + ADC_O_SSFIFO0), &ADC_Out2, NUM_SAMPLES);
+    uDMAChannelTransferSet(UDMA_CHANNEL_ADC0 | UDMA_PRI_SELECT, UDMA_MODE_PINGPONG, (void*)(ADC0_BASE + ADC_O_SSFIFO0), NextTransfer(), NUM_SAMPLES);
+    uDMAChannelTransferSet(UDMA_CHANNEL_ADC0 | UDMA_ALT_SELECT, UDMA_MODE_PINGPONG, (void*)(ADC0_BASE + ADC_O_SSFIFO0), NextTransfer(), NUM_SAMPLES);
 
     // Enables DMA channel so it can perform transfers
     uDMAChannelEnable(UDMA_CHANNEL_ADC0);
 
-    GPIOPinTypeADC(GPIO_PORTE_BASE, GPIO_PIN_5);
+    for (mic = 0; mic < MIC_CHANNELS; mic++)
+        GPIOPinTypeADC(GPIO_PORTE_BASE, mic_pins[mic]);
     SysCtlDelay(80u);
 
-    // Use ADC0 sequence 0 to sample channel 0 once for each timer period
+    // Use ADC0 sequence 0 to sample every microphone once for each timer period
     ADCClockConfigSet(ADC0_BASE, ADC_CLOCK_SRC_PIOSC | ADC_CLOCK_RATE_HALF, 1);
 
     // Time for the clock configuration to set
@@ -182,7 +339,8 @@ void ConfigureADCuDMA(void)
     ADCSequenceDisable(ADC0_BASE, 0u);
 
     ADCSequenceConfigure(ADC0_BASE, 0u, ADC_TRIGGER_TIMER, 0u);
-    ADCSequenceStepConfigure(ADC0_BASE, 0u, 0u, ADC_CTL_CH8 | ADC_CTL_END | ADC_CTL_IE);
+    for (mic = 0; mic < MIC_CHANNELS; mic++)
+        ADCSequenceStepConfigure(ADC0_BASE, 0u, mic, mic_inputs[mic] | ((mic == MIC_CHANNELS - 1) ? ADC_CTL_END | ADC_CTL_IE : 0));
 
     //Once configuration is set, re-enable the sequencer
     ADCSequenceEnable(ADC0_BASE, 0u);
@@ -211,8 +369,21 @@ void ConfigureUART(void)
     // Use the internal 16MHz oscillator as the UART clock source.
     UARTClockSourceSet(UART0_BASE, UART_CLOCK_PIOSC);
 
-    // Initialize the UART for console I/O.
-    UARTStdioConfig(0, 115200, 16000000);
+    // 115200 8N1, the FIFO requests a burst of 4 when it is half empty
+    UARTConfigSetExpClk(UART0_BASE, 16000000, 115200, UART_CONFIG_WLEN_8 | UART_CONFIG_STOP_ONE | UART_CONFIG_PAR_NONE);
+    UARTFIFOLevelSet(UART0_BASE, UART_FIFO_TX4_8, UART_FIFO_RX4_8);
+    UARTFIFOEnable(UART0_BASE);
+
+    // Output is sent by uDMA from the console ring (uDMA is enabled by ConfigureADCuDMA)
+    console_init(&console);
+    uDMAChannelAttributeDisable(UDMA_CHANNEL_UART0TX, UDMA_ATTR_ALL);
+    uDMAChannelControlSet(UDMA_CHANNEL_UART0TX | UDMA_PRI_SELECT, UDMA_SIZE_8 | UDMA_SRC_INC_8 | UDMA_DST_INC_NONE | UDMA_ARB_4);
+    UARTDMAEnable(UART0_BASE, UART_DMA_TX);
+    UARTEnable(UART0_BASE);
+
+    // Recorder commands come in on the receive side
+    UARTIntEnable(UART0_BASE, UART_INT_RX | UART_INT_RT);
+    IntEnable(INT_UART0);
 }
 
 //*****************************************************************************
@@ -241,75 +412,42 @@ void ConfigureSamplingTimer(void)
     ROM_TimerEnable(TIMER0_BASE, TIMER_A);
 }
 
-void process_data(int16_t* ADC_Out)
+//*****************************************************************************
+// Print decoded characters and status messages on the UART
+//*****************************************************************************
+void decoder_output(void* ctx, enum DECODER_EVENT event, int value)
 {
-    int sum = 0, n_loop = 0, reset_flags = 0, amplitude = 0;
-
-    //use FFT to calculate magnitude for a single bin
-    //The start condition is an out-of-band 21khz byte
-    if (byte_sync == COMPLETE) {
-        amplitude = (goertzel(ADC_Out, NUM_SAMPLES, twenty_khz) >= 100) ? 1 : 0;
-    }
-    else {
-        amplitude = (goertzel(ADC_Out, NUM_SAMPLES, twenty_one_khz) >= 100) ? 1 : 0;
-    }
-
-    //if we detect a high bit (transmission starts with double "1")
-    if (amplitude && !transfer_status)
-        transfer_status = 1;
-
-    //Transfer mode - store moving sum of bits
-    if (transfer_status) {
-
-        //calculate sum/buffer of last 5 frames (5 frames = 1 bit = 100 ms)
-        for (n_loop = 0; n_loop < 4; n_loop++) {
-            amplitude_buffer[n_loop] = amplitude_buffer[n_loop + 1];
-            sum += amplitude_buffer[n_loop];
-        }
-        amplitude_buffer[4] = amplitude; // add latest value to end of buffer
-        sum += amplitude;
-
-        //determine if next bit can be determined (5 frames have been received)
-        if (!((frame_count + 1) % 5)) {
-            if (byte_sync != COMPLETE) {
-                if (byte_sync == ONE && sum == 5) {
-                    byte_sync = ZERO;
-                }
-                else if (byte_sync == ZERO && sum == 0) {
-                    byte_sync = ONE;
-                }
-                else if (byte_sync != FAILED) {
-                    byte_sync = FAILED;
-                    UARTprintf("Synchronization Failed.. Trying Again \n");
-                }
-            }
-
-            if (sum > 2)
-                data_byte |= 1;
-
-            if (!((bit_output_index + 1) % 8)) {
-                if (!data_byte) { // stop condition
-                    reset_flags = 1;
-                    UARTprintf("\n\n");
-                } else if (byte_sync == ONE) {
-                    byte_sync = COMPLETE;
-                } else if (byte_sync == COMPLETE){
-                    UARTprintf("%c", data_byte);
-                }
-                data_byte = 0;
-            }
-
-            bit_output_index++;
-            data_byte <<= 1;
-        }
-        frame_count++;
-
-        if (reset_flags == 1) {
-            byte_sync = ONE;
-            transfer_status = 0;
-            frame_count = 0;
-            bit_output_index = 0;
+    int i = 0, c;
+
+    recorder_event(&recorder, event);
+
+    switch (event) {
+    case DECODER_CHAR:
+        ConsolePrintf("%c", value);
+        break;
+    case DECODER_END:
+        ConsolePrintf("\n\n");
+        break;
+    case DECODER_SYNC_FAILED:
+        ConsolePrintf("Synchronization Failed.. Trying Again \n");
+        break;
+    case DECODER_RATE:
+        ConsolePrintf("[profile %d] ", value);
+        break;
+    case DECODER_PACKET:
+        ConsolePrintf("#%u ", decoder.packet.sequence);
+        for (i = 0; i < value; i++) {
+            c = decoder.packet.payload[i];
+            ConsolePrintf("%c", (c >= 0x20 && c < 0x7f) ? c : '.');
         }
+        ConsolePrintf("\n\n");
+        break;
+    case DECODER_PACKET_REJECTED:
+        ConsolePrintf("Packet rejected (%u so far)\n",
+            decoder.packet.sync_errors + decoder.packet.header_errors + decoder.packet.crc_errors);
+        break;
+    default:
+        break;
     }
 }
 
@@ -319,6 +457,10 @@ void process_data(int16_t* ADC_Out)
 //*****************************************************************************
 int main(void)
 {
+    const int16_t* frame;
+    uint32_t sequence, expected = 0, started;
+    int selected = 0;
+
     // Enable lazy stacking for interrupt handlers.  This allows floating-point
     // instructions to be used within interrupt handlers, but at the expense of
     // extra stack usage.
@@ -338,23 +480,59 @@ int main(void)
     // Enable processor interrupts.
     ROM_IntMasterEnable();
 
-    // Configure ADC8, UART and Sampling Timer
-    ConfigureUART();
+    // Tone coefficients and buffers must be ready before the first frame arrives
+    decoder_init(&decoder, sampling_rate, OOK, decoder_output, 0);
+#if MIC_CHANNELS > 1
+    decoder_set_diversity(&decoder, &diversity, MIC_CHANNELS, MIC_DIVERSITY);
+#endif
+    recorder_init(&recorder);
+    frame_queue_init(&adc_queue, ADC_Frames, FRAME_READINGS, FRAME_DEPTH);
+
+    // Configure ADC8, UART and Sampling Timer. The UART uses the uDMA
+    // controller set up with the ADC.
     ConfigureADCuDMA();
+    ConfigureUART();
     ConfigureSamplingTimer();
 
-    BufferStatus[0] = FILLING;
-    BufferStatus[1] = EMPTY;
+    if (TELEMETRY) {
+        DEM_CR |= DEM_CR_TRCENA;
+        DWT_CYCCNT = 0;
+        DWT_CTRL |= DWT_CTRL_CYCCNTENA;
+    }
 
-    // Infinite loop, interrupts handle the logic
+    // Infinite loop, frames are decoded in the order they were sampled
     while (1) {
-        if (BufferStatus[0u] == FULL) {
-            process_data(ADC_Out1);
-            BufferStatus[0u] = EMPTY;
+        ServiceRecorder();
+
+        frame = frame_queue_peek(&adc_queue, &sequence);
+        if (!frame) {
+            // Sleep until the next interrupt. Interrupts are masked around
+            // the check so a frame completing in between still wakes the
+            // WFI, and the peripheral clocks keep running while asleep.
+            ROM_IntMasterDisable();
+            if (!frame_queue_peek(&adc_queue, &sequence))
+                ROM_SysCtlSleep();
+            ROM_IntMasterEnable();
+            continue;
         }
-        if (BufferStatus[1u] == FULL) {
-            process_data(ADC_Out2);
-            BufferStatus[1u] = EMPTY;
+
+        started = TELEMETRY ? DWT_CYCCNT : 0;
+        if (sequence != expected) {
+            ConsolePrintf("%u frames dropped\n", sequence - expected);
+            decoder_skip(&decoder, sequence - expected);
         }
+        // The frame is ours until it is released, sort the readings in place
+        diversity_deinterleave((int16_t*)frame, MIC_CHANNELS, NUM_SAMPLES);
+        decoder_process(&decoder, frame);
+#if MIC_CHANNELS > 1
+        selected = diversity.selected;
+#endif
+        recorder_frame(&recorder, &decoder, frame + selected * NUM_SAMPLES, sequence, sequence - expected);
+        frame_queue_release(&adc_queue);
+        if (recorder.trigger > RECORDER_REQUEST && recorder.trigger_sequence == sequence)
+            ConsolePrintf("Recorder frozen, send d to dump it\n");
+        if (TELEMETRY)
+            SendTelemetry(sequence, sequence - expected, DWT_CYCCNT - started);
+        expected = sequence + 1;
     }
 }
@@ -0,0 +1,51 @@
+//*****************************************************************************
+//
+// nco.h - Table based numerically controlled oscillator
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#ifndef NCO_H_
+#define NCO_H_
+
+#include <stdint.h>
+
+//*****************************************************************************
+// The phase is a 32 bit accumulator, a full turn wraps it around, so a
+// frequency is exact to sample_rate / 2^32 and changing it never makes the
+// phase jump. The top NCO_TABLE_BITS of the phase pick an entry of a quarter
+// wave sine table and the next 16 interpolate to the one after it, which
+// keeps spurs more than 90dB down.
+//*****************************************************************************
+#define NCO_TABLE_BITS 11
+#define NCO_QUARTER (1 << (NCO_TABLE_BITS - 2))
+
+struct nco {
+    uint32_t phase;
+    uint32_t step;                      // Phase advance per sample
+};
+
+//*****************************************************************************
+// Start at phase 0, not running
+//*****************************************************************************
+void nco_init(struct nco* nco);
+
+//*****************************************************************************
+// Change the frequency, the phase carries on from where it is
+//*****************************************************************************
+void nco_set_freq(struct nco* nco, uint32_t freq, uint32_t sample_rate);
+
+//*****************************************************************************
+// sin(2 pi phase / 2^32) in Q15
+//*****************************************************************************
+int32_t nco_sin(uint32_t phase);
+
+//*****************************************************************************
+// Write n samples of amplitude * sin into out (amplitude up to 32767) and
+// advance the phase. An amplitude of 0 writes silence but keeps the phase
+// running, so a keyed carrier comes back where it would have been.
+//*****************************************************************************
+void nco_generate(struct nco* nco, int16_t* out, int n, int amplitude);
+
+#endif // NCO_H_
@@ -0,0 +1,139 @@
+//*****************************************************************************
+//
+// noise_floor.c - Noise floor and SNR from off-carrier reference bins
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "noise_floor.h"
+
+void noise_floor_init(struct noise_floor* nf, int minimum)
+{
+    nf->num_refs = 0;
+    nf->level = 0;
+    nf->frame_level = 0;
+    nf->frames = 0;
+    nf->minimum = (uint32_t)minimum << NF_FRACTION_BITS;
+}
+
+int noise_floor_tune(struct noise_floor* nf, const int* coeffs, int num_refs)
+{
+    int ref = 0;
+
+    if (num_refs > NF_MAX_REFS)
+        return -1;
+
+    for (ref = 0; ref < num_refs; ref++)
+        nf->coeffs[ref] = coeffs[ref];
+    nf->num_refs = num_refs;
+
+    return 0;
+}
+
+//*****************************************************************************
+// The floor as used for decisions, never below the minimum
+//*****************************************************************************
+static uint32_t floor_level(const struct noise_floor* nf)
+{
+    if (nf->level < nf->minimum)
+        return nf->minimum ? nf->minimum : 1;
+
+    return nf->level ? nf->level : 1;
+}
+
+//*****************************************************************************
+// Power of one reference over the frame in 1 / (1 << NF_FRACTION_BITS). The
+// resonator runs on the raw readings with 32 bit state, and |X|^2 >> 17 puts
+// it on the scale of the sliding detectors.
+//*****************************************************************************
+static uint32_t ref_power(const int16_t* frame, int sz, int32_t coeff)
+{
+    int32_t delay, delay_1 = 0, delay_2 = 0;
+    int64_t power;
+    int i = 0;
+
+    for (i = 0; i < sz; i++) {
+        delay = frame[i] + (int32_t)(((int64_t)delay_1 * coeff) >> 14) - delay_2;
+        delay_2 = delay_1;
+        delay_1 = delay;
+    }
+
+    power = (int64_t)delay_1 * delay_1 + (int64_t)delay_2 * delay_2
+        - (((int64_t)delay_1 * coeff) >> 14) * delay_2;
+    power >>= 17 - NF_FRACTION_BITS;
+
+    return (power <= 0) ? 0 : (power > UINT32_MAX) ? UINT32_MAX : (uint32_t)power;
+}
+
+void noise_floor_update(struct noise_floor* nf, const int16_t* frame, int sz)
+{
+    uint64_t sum = 0, clip;
+    uint32_t power;
+    int ref = 0;
+
+    if (!nf->num_refs)
+        return;
+
+    // Nothing is clipped until there is a floor to clip to
+    clip = nf->frames ? (uint64_t)floor_level(nf) << NF_CLIP_SHIFT : UINT64_MAX;
+    for (ref = 0; ref < nf->num_refs; ref++) {
+        nf->power[ref] = ref_power(frame, sz, nf->coeffs[ref]);
+        sum += (nf->power[ref] < clip) ? nf->power[ref] : clip;
+    }
+    power = (uint32_t)(sum / nf->num_refs);
+    nf->frame_level = power;
+
+    if (nf->frames < (1u << NF_TRACK_SHIFT))
+        nf->frames++;
+    if (power < nf->level)
+        nf->level -= (nf->level - power) / nf->frames;
+    else
+        nf->level += (power - nf->level) / nf->frames;
+}
+
+int noise_floor_settled(const struct noise_floor* nf)
+{
+    return nf->frames >= (1u << NF_TRACK_SHIFT);
+}
+
+int noise_floor_threshold(const struct noise_floor* nf, int shift, bool with_frame)
+{
+    uint32_t level = floor_level(nf);
+    uint64_t threshold;
+
+    if (with_frame && nf->frame_level > level)
+        level = nf->frame_level;
+    threshold = ((uint64_t)level << shift) >> NF_FRACTION_BITS;
+
+    return (threshold < INT32_MAX) ? (int)threshold : INT32_MAX;
+}
+
+int noise_floor_snr_db(const struct noise_floor* nf, int power)
+{
+    uint64_t ratio;
+    int32_t log2 = 0;
+
+    if (power <= 0)
+        return -99;
+
+    // Power over the floor in Q16, then log2 in Q8 with a straight line
+    // between the powers of two
+    ratio = ((uint64_t)power << (16 + NF_FRACTION_BITS)) / floor_level(nf);
+    if (!ratio)
+        return -99;
+    while (ratio >= (2ULL << 16)) {
+        ratio >>= 1;
+        log2 += 256;
+    }
+    while (ratio < (1ULL << 16)) {
+        ratio <<= 1;
+        log2 -= 256;
+    }
+    log2 += (int32_t)((ratio - (1ULL << 16)) >> 8);
+
+    // 10 * log10(2) = 3.0103 is 771 / 256
+    return (log2 * 771 + (log2 >= 0 ? 32768 : -32768)) / 65536;
+}
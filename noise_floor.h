@@ -0,0 +1,82 @@
+//*****************************************************************************
+//
+// noise_floor.h - Noise floor and SNR from off-carrier reference bins
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#ifndef NOISE_FLOOR_H_
+#define NOISE_FLOOR_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//*****************************************************************************
+// Largest number of reference bins, and the fraction bits of the floor
+//*****************************************************************************
+#define NF_MAX_REFS 8
+#define NF_FRACTION_BITS 8
+
+//*****************************************************************************
+// The floor is an exponential average over frames with a weight of
+// 1 / (1 << NF_TRACK_SHIFT), a plain average until that many frames have been
+// seen. Before averaging each reference is clipped to
+// NF_CLIP_SHIFT (4x) above the floor, so a tone leaking into one of them or
+// a click from a keyed carrier hardly moves it.
+//*****************************************************************************
+#define NF_TRACK_SHIFT 4
+#define NF_CLIP_SHIFT 2
+
+//*****************************************************************************
+// Power per bin between the carriers, on the scale of the sliding detectors
+// (goertzel() rounds noise away, so the references keep every input bit).
+// Reference bins should sit a few bins away from every tone in use so a
+// carrier that is on does not raise the floor it is compared with.
+//*****************************************************************************
+struct noise_floor {
+    int32_t coeffs[NF_MAX_REFS];
+    uint32_t power[NF_MAX_REFS];    // Reference powers of the last frame, same format as level
+    int num_refs;
+    uint32_t level;                 // Floor in 1 / (1 << NF_FRACTION_BITS)
+    uint32_t frame_level;           // Clipped mean of the last frame, same format
+    uint32_t minimum;               // Lowest floor trusted, same format
+    uint32_t frames;                // Frames averaged so far
+};
+
+//*****************************************************************************
+// Start without a floor. minimum is in detector units and keeps a silent
+// input from making every spur look like a carrier.
+//*****************************************************************************
+void noise_floor_init(struct noise_floor* nf, int minimum);
+
+//*****************************************************************************
+// Measure at the reference bins with these Q14 Goertzel coefficients. The
+// floor is kept. Returns -1 if there are more than NF_MAX_REFS.
+//*****************************************************************************
+int noise_floor_tune(struct noise_floor* nf, const int* coeffs, int num_refs);
+
+//*****************************************************************************
+// Measure the references over one frame and fold them into the floor
+//*****************************************************************************
+void noise_floor_update(struct noise_floor* nf, const int16_t* frame, int sz);
+
+//*****************************************************************************
+// Nonzero once the floor averages a full 1 << NF_TRACK_SHIFT frames
+//*****************************************************************************
+int noise_floor_settled(const struct noise_floor* nf);
+
+//*****************************************************************************
+// Power a bin needs to be 1 << shift times the floor (3dB per step). With
+// with_frame set the references of the last frame count too when they are
+// higher, so a sudden burst of noise isn't taken for a carrier while the
+// average catches up.
+//*****************************************************************************
+int noise_floor_threshold(const struct noise_floor* nf, int shift, bool with_frame);
+
+//*****************************************************************************
+// Ratio of a bin's power to the floor in whole dB, accurate to about 0.3dB
+//*****************************************************************************
+int noise_floor_snr_db(const struct noise_floor* nf, int power);
+
+#endif // NOISE_FLOOR_H_
@@ -0,0 +1,104 @@
+//*****************************************************************************
+//
+// ofdm.c - Subcarrier mapping and pilot equalization of the OFDM mode
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include "goertzel.h"
+#include "fft.h"
+#include "nco.h"
+#include "ofdm.h"
+
+int ofdm_scramble(uint8_t* state, int bits)
+{
+    int value = 0, bit = 0, i = 0;
+
+    for (i = 0; i < bits; i++) {
+        bit = ((*state >> 6) ^ (*state >> 3)) & 1;
+        *state = (uint8_t)(((*state << 1) | bit) & 0x7F);
+        value = (value << 1) | bit;
+    }
+
+    return value;
+}
+
+void ofdm_map(const uint8_t* symbols, uint8_t* turns)
+{
+    uint8_t pilots = OFDM_PILOT_SEED;
+    int k = 0;
+
+    for (k = 0; k < OFDM_NUM_BINS; k++) {
+        if (OFDM_IS_PILOT(k)) {
+            turns[k] = (uint8_t)(ofdm_scramble(&pilots, 1) << 1);
+        } else {
+            turns[k] = (uint8_t)DPSK_GRAY(*symbols);
+            symbols++;
+        }
+    }
+}
+
+void ofdm_load(const int16_t* older, int count, const int16_t* newer, int offset, int16_t* data)
+{
+    uint32_t phase = 0, step = (uint32_t)offset << 14;  // 2^32 / (256 * NUM_SAMPLES) a step
+    int32_t sum = 0, value;
+    int i = 0;
+
+    for (i = 0; i < count; i++)
+        sum += older[i];
+    for (i = count; i < NUM_SAMPLES; i++)
+        sum += newer[i - count];
+    sum /= NUM_SAMPLES;
+
+    // Times exp(-j phase), a tone offset bins up lands on the bin below
+    for (i = 0; i < NUM_SAMPLES; i++) {
+        value = ((i < count) ? older[i] : newer[i - count]) - sum;
+        if (offset) {
+            data[2 * i] = (int16_t)((value * nco_sin(phase + 0x40000000u)) >> 12);
+            data[2 * i + 1] = (int16_t)(-(value * nco_sin(phase)) >> 12);
+            phase += step;
+        } else {
+            data[2 * i] = (int16_t)(value << 3);
+            data[2 * i + 1] = 0;
+        }
+    }
+}
+
+int ofdm_demodulate(const int16_t* spectrum, int first_bin, uint8_t* symbols)
+{
+    const int16_t* bin = spectrum + 2 * first_bin;
+    int32_t pilot_re[OFDM_NUM_PILOTS], pilot_im[OFDM_NUM_PILOTS];
+    int32_t re, im, h_re, h_im, power = 0;
+    uint8_t pilots = OFDM_PILOT_SEED;
+    int k = 0, p = 0, j = 0, d = 0;
+
+    // Channel on the pilots, turned back by their known half turns
+    for (p = 0; p < OFDM_NUM_PILOTS; p++) {
+        k = p * OFDM_PILOT_SPACING;
+        pilot_re[p] = bin[2 * k];
+        pilot_im[p] = bin[2 * k + 1];
+        if (ofdm_scramble(&pilots, 1)) {
+            pilot_re[p] = -pilot_re[p];
+            pilot_im[p] = -pilot_im[p];
+        }
+        power += fft_power(spectrum, first_bin + k);
+    }
+
+    for (k = 1; k < OFDM_NUM_BINS; k++) {
+        if (OFDM_IS_PILOT(k))
+            continue;
+        p = k / OFDM_PILOT_SPACING;
+        j = k % OFDM_PILOT_SPACING;
+        h_re = (pilot_re[p] * (OFDM_PILOT_SPACING - j) + pilot_re[p + 1] * j) / OFDM_PILOT_SPACING;
+        h_im = (pilot_im[p] * (OFDM_PILOT_SPACING - j) + pilot_im[p + 1] * j) / OFDM_PILOT_SPACING;
+        re = bin[2 * k];
+        im = bin[2 * k + 1];
+        d = goertzel_nearest_phase((int64_t)re * h_re + (int64_t)im * h_im,
+            (int64_t)im * h_re - (int64_t)re * h_im, 4);
+        *symbols++ = (uint8_t)DPSK_GRAY(d);
+    }
+
+    return power / OFDM_NUM_PILOTS;
+}
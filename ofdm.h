@@ -0,0 +1,64 @@
+//*****************************************************************************
+//
+// ofdm.h - Subcarrier mapping and pilot equalization of the OFDM mode
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#ifndef OFDM_H_
+#define OFDM_H_
+
+#include <stdint.h>
+#include "freq_plan.h"
+
+//*****************************************************************************
+// Layout of a symbol from the channel plan in freq_plan.h. Subcarrier k is
+// a pilot when k is a multiple of OFDM_PILOT_SPACING, the rest carry data
+// in order of frequency.
+//*****************************************************************************
+#define OFDM_NUM_PILOTS ((OFDM_NUM_BINS - 1) / OFDM_PILOT_SPACING + 1)
+#define OFDM_NUM_DATA (OFDM_NUM_BINS - OFDM_NUM_PILOTS)
+#define OFDM_BITS_PER_CARRIER 2
+#define OFDM_BITS_PER_SYMBOL (OFDM_NUM_DATA * OFDM_BITS_PER_CARRIER)
+#define OFDM_IS_PILOT(K) (!((K) % OFDM_PILOT_SPACING))
+
+//*****************************************************************************
+// Pilots are turned by half a turn or not from a fixed pseudo random
+// sequence, and the data is XORed with another one before it is mapped, so
+// the subcarriers of a symbol never line up in phase. Lined up they would
+// add to a peak far above the rest of the symbol. Both come from the
+// x^7 + x^4 + 1 scrambler, started at these states.
+//*****************************************************************************
+#define OFDM_PILOT_SEED 0x7F
+#define OFDM_DATA_SEED 0x5D
+
+//*****************************************************************************
+// The next bits bits of the scrambler sequence at state, as a number
+//*****************************************************************************
+int ofdm_scramble(uint8_t* state, int bits);
+
+//*****************************************************************************
+// Quarter turns of the OFDM_NUM_BINS subcarriers of a symbol whose data
+// carriers hold the OFDM_NUM_DATA symbols (already scrambled)
+//*****************************************************************************
+void ofdm_map(const uint8_t* symbols, uint8_t* turns);
+
+//*****************************************************************************
+// Load a window of NUM_SAMPLES ADC readings that starts count readings from
+// the end of the older frame and carries on into the newer one, as fft_load()
+// does for a single frame, and move it down in frequency by offset 1/256ths
+// of a bin
+//*****************************************************************************
+void ofdm_load(const int16_t* older, int count, const int16_t* newer, int offset, int16_t* data);
+
+//*****************************************************************************
+// Decide the OFDM_NUM_DATA symbols of a transformed window whose first
+// subcarrier is on first_bin. The channel is measured on the pilots and
+// worked out in between them by straight lines through their values, then
+// every data carrier is turned back by it and rounded to the nearest quarter
+// turn. Returns the mean power of the pilots, on the scale of fft_power().
+//*****************************************************************************
+int ofdm_demodulate(const int16_t* spectrum, int first_bin, uint8_t* symbols);
+
+#endif // OFDM_H_
@@ -0,0 +1,115 @@
+//*****************************************************************************
+//
+// packet.h - Length prefixed packets with a CRC
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#ifndef PACKET_H_
+#define PACKET_H_
+
+#include <stdint.h>
+
+//*****************************************************************************
+// Layout of a packet, sent on the data carrier after the start byte
+//   sync word   PACKET_SYNC_HIGH, PACKET_SYNC_LOW
+//   flags       PACKET_FLAG_* bits, the others must be 0
+//   length      payload bytes, 0 to PACKET_MAX_PAYLOAD
+//   sequence    counts up by one per packet sent, wraps at 255
+//   rate        only with PACKET_FLAG_RATE, the transmitter's bit rate code
+//   payload     any bytes, zero included
+//   crc         CRC-16/CCITT-FALSE, or CRC-32 with PACKET_FLAG_CRC32, over
+//               flags to the end of the payload, most significant byte first
+// A zero byte after the CRC terminates the convolutional code if one is used.
+//*****************************************************************************
+#define PACKET_SYNC_HIGH 0x2D
+#define PACKET_SYNC_LOW 0xD4
+#define PACKET_FLAG_CRC32 0x01
+#define PACKET_FLAG_RATE 0x02
+#define PACKET_FLAGS_KNOWN (PACKET_FLAG_CRC32 | PACKET_FLAG_RATE)
+#define PACKET_MAX_PAYLOAD 255
+
+//*****************************************************************************
+// Longest packet on the air: sync, flags, length, sequence, rate, payload and
+// a 32 bit CRC
+//*****************************************************************************
+#define PACKET_MAX_SIZE (6 + PACKET_MAX_PAYLOAD + 4)
+
+//*****************************************************************************
+// What packet_parser_push() made of the byte it was given. Anything but
+// PACKET_INCOMPLETE ends the packet.
+//*****************************************************************************
+enum PACKET_STATUS {
+    PACKET_INCOMPLETE,
+    PACKET_OK,
+    PACKET_BAD_SYNC,
+    PACKET_BAD_HEADER,
+    PACKET_BAD_CRC
+};
+
+enum PACKET_FIELD {
+    PACKET_SYNC_1,
+    PACKET_SYNC_2,
+    PACKET_FLAGS,
+    PACKET_LENGTH,
+    PACKET_SEQUENCE,
+    PACKET_RATE,
+    PACKET_PAYLOAD,
+    PACKET_CRC
+};
+
+//*****************************************************************************
+// Parses a packet one byte at a time as the bits come in. The CRC is
+// updated on every byte, so nothing is left to do once the last one arrives.
+// The counters survive packet_parser_start().
+//*****************************************************************************
+struct packet_parser {
+    enum PACKET_FIELD field;
+    uint8_t flags;
+    uint8_t length;
+    uint8_t sequence;
+    uint8_t rate;
+    uint8_t payload[PACKET_MAX_PAYLOAD];
+    int count;                      // Bytes of the current field received
+    uint32_t crc;
+    uint32_t received_crc;
+
+    uint32_t packets;
+    uint32_t sync_errors;
+    uint32_t header_errors;
+    uint32_t crc_errors;
+};
+
+//*****************************************************************************
+// Clear the counters and wait for a packet
+//*****************************************************************************
+void packet_parser_init(struct packet_parser* parser);
+
+//*****************************************************************************
+// Wait for the sync word of a new packet
+//*****************************************************************************
+void packet_parser_start(struct packet_parser* parser);
+
+//*****************************************************************************
+// Add the next byte. With PACKET_OK the header fields and payload hold the
+// packet until more bytes are pushed. After any status but PACKET_INCOMPLETE
+// the parser waits for the next sync word.
+//*****************************************************************************
+enum PACKET_STATUS packet_parser_push(struct packet_parser* parser, uint8_t byte);
+
+//*****************************************************************************
+// Write a whole packet to out (PACKET_MAX_SIZE bytes at most), returns its
+// length or -1 if the payload is too long. rate is sent only with
+// PACKET_FLAG_RATE.
+//*****************************************************************************
+int packet_build(uint8_t* out, uint8_t flags, uint8_t sequence, uint8_t rate, const uint8_t* payload, int length);
+
+//*****************************************************************************
+// Table driven CRCs. Start with crc16_update(0xFFFF, ...) and
+// crc32_update(0xFFFFFFFF, ...) and invert the CRC-32 at the end.
+//*****************************************************************************
+uint16_t crc16_update(uint16_t crc, const uint8_t* data, int length);
+uint32_t crc32_update(uint32_t crc, const uint8_t* data, int length);
+
+#endif // PACKET_H_
@@ -0,0 +1,181 @@
+//*****************************************************************************
+//
+// recorder.c - Flight recorder of the last raw frames and decoder decisions
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "recorder.h"
+#include "packet.h"
+#include "cobs.h"
+
+void recorder_init(struct recorder* rec)
+{
+    memset(rec, 0, sizeof(*rec));
+    rec->dump_block = -1;
+}
+
+void recorder_arm(struct recorder* rec)
+{
+    rec->frame_count = 0;
+    rec->decision_count = 0;
+    rec->events = 0;
+    rec->pending = RECORDER_RUNNING;
+    rec->trigger = RECORDER_RUNNING;
+    rec->dump_block = -1;
+}
+
+void recorder_event(struct recorder* rec, enum DECODER_EVENT event)
+{
+    if (rec->trigger != RECORDER_RUNNING)
+        return;
+
+    rec->events |= 1 << event;
+    if (rec->pending == RECORDER_RUNNING && event == DECODER_SYNC_FAILED)
+        rec->pending = RECORDER_SYNC_FAILED;
+    else if (rec->pending == RECORDER_RUNNING && event == DECODER_PACKET_REJECTED)
+        rec->pending = RECORDER_PACKET_REJECTED;
+}
+
+//*****************************************************************************
+// Two 12 bit samples in three bytes, low sample first
+//*****************************************************************************
+void recorder_pack(const int16_t* frame, uint8_t* packed)
+{
+    uint16_t a, b;
+    int i = 0;
+
+    for (i = 0; i < NUM_SAMPLES; i += 2) {
+        a = (uint16_t)frame[i] & 0xFFF;
+        b = (uint16_t)frame[i + 1] & 0xFFF;
+        *packed++ = (uint8_t)a;
+        *packed++ = (uint8_t)((a >> 8) | (b << 4));
+        *packed++ = (uint8_t)(b >> 4);
+    }
+}
+
+void recorder_unpack(const uint8_t* packed, int16_t* frame)
+{
+    int i = 0;
+
+    for (i = 0; i < NUM_SAMPLES; i += 2) {
+        frame[i] = (int16_t)(packed[0] | ((packed[1] & 0x0F) << 8));
+        frame[i + 1] = (int16_t)((packed[1] >> 4) | (packed[2] << 4));
+        packed += 3;
+    }
+}
+
+void recorder_frame(struct recorder* rec, const struct decoder* dec, const int16_t* frame, uint32_t sequence, uint32_t skipped)
+{
+    struct recorder_decision* decision;
+    int slot;
+
+    if (rec->trigger != RECORDER_RUNNING)
+        return;
+
+    slot = rec->frame_count++ % RECORDER_FRAMES;
+    recorder_pack(frame, rec->frames[slot]);
+    rec->frame_sequence[slot] = sequence;
+
+    decision = &rec->decisions[rec->decision_count++ % RECORDER_DECISIONS];
+    decision->sequence = sequence;
+    decision->bit_index = (uint16_t)dec->bit_output_index;
+    decision->snr_db = (int8_t)((dec->snr_db > 127) ? 127 : (dec->snr_db < -128) ? -128 : dec->snr_db);
+    decision->byte_sync = (int8_t)dec->byte_sync;
+    decision->flags = (dec->transfer_status ? RECORDER_RECEIVING : 0) | (dec->gated ? RECORDER_GATED : 0) | (skipped ? RECORDER_SKIPPED : 0);
+    decision->events = rec->events;
+    rec->events = 0;
+
+    if (rec->pending != RECORDER_RUNNING) {
+        rec->trigger = rec->pending;
+        rec->trigger_sequence = sequence;
+    }
+}
+
+void recorder_dump_start(struct recorder* rec)
+{
+    if (rec->trigger == RECORDER_RUNNING) {
+        rec->trigger = RECORDER_REQUEST;
+        rec->trigger_sequence = rec->frame_count ? rec->frame_sequence[(rec->frame_count - 1) % RECORDER_FRAMES] : 0;
+    }
+    rec->dump_block = 0;
+}
+
+static uint8_t* put16(uint8_t* out, uint32_t value)
+{
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    return out + 2;
+}
+
+static uint8_t* put32(uint8_t* out, uint32_t value)
+{
+    return put16(put16(out, value), value >> 16);
+}
+
+int recorder_dump_next(struct recorder* rec, const struct decoder* dec, uint8_t* out)
+{
+    uint8_t raw[RECORDER_MAX_BLOCK];
+    uint8_t* pos = raw + 3;
+    const struct recorder_decision* decision;
+    uint32_t frames = (rec->frame_count < RECORDER_FRAMES) ? rec->frame_count : RECORDER_FRAMES;
+    uint32_t decisions = (rec->decision_count < RECORDER_DECISIONS) ? rec->decision_count : RECORDER_DECISIONS;
+    uint32_t decision_blocks = (decisions + RECORDER_DECISIONS_PER_BLOCK - 1) / RECORDER_DECISIONS_PER_BLOCK;
+    uint32_t block, index, first, i = 0;
+    uint16_t crc;
+
+    if (rec->dump_block < 0)
+        return 0;
+    block = rec->dump_block++;
+
+    raw[0] = RECORDER_MAGIC;
+    raw[1] = RECORDER_VERSION;
+    if (block == 0) {
+        raw[2] = RECORDER_HEADER;
+        pos = put32(pos, dec->sample_rate);
+        pos = put16(pos, NUM_SAMPLES);
+        *pos++ = (uint8_t)frames;
+        *pos++ = (uint8_t)decisions;
+        *pos++ = (uint8_t)rec->trigger;
+        pos = put32(pos, rec->trigger_sequence);
+        *pos++ = (uint8_t)dec->modulation;
+        *pos++ = (uint8_t)dec->coding;
+        *pos++ = (uint8_t)dec->packets;
+    } else if (block <= frames * RECORDER_PARTS) {
+        // Frames oldest first, each in RECORDER_PARTS blocks
+        index = (block - 1) / RECORDER_PARTS;
+        first = (rec->frame_count - frames + index) % RECORDER_FRAMES;
+        raw[2] = RECORDER_FRAME;
+        *pos++ = (uint8_t)index;
+        *pos++ = (uint8_t)((block - 1) % RECORDER_PARTS);
+        pos = put32(pos, rec->frame_sequence[first]);
+        memcpy(pos, &rec->frames[first][((block - 1) % RECORDER_PARTS) * RECORDER_PART_SIZE], RECORDER_PART_SIZE);
+        pos += RECORDER_PART_SIZE;
+    } else if (block <= frames * RECORDER_PARTS + decision_blocks) {
+        raw[2] = RECORDER_DECISIONS_BLOCK;
+        first = (block - 1 - frames * RECORDER_PARTS) * RECORDER_DECISIONS_PER_BLOCK;
+        for (i = first; i < decisions && i < first + RECORDER_DECISIONS_PER_BLOCK; i++) {
+            decision = &rec->decisions[(rec->decision_count - decisions + i) % RECORDER_DECISIONS];
+            pos = put32(pos, decision->sequence);
+            pos = put16(pos, decision->bit_index);
+            *pos++ = (uint8_t)decision->snr_db;
+            *pos++ = (uint8_t)decision->byte_sync;
+            *pos++ = decision->flags;
+            *pos++ = decision->events;
+        }
+    } else {
+        raw[2] = RECORDER_END;
+        pos = put16(pos, block);
+        rec->dump_block = -1;
+    }
+
+    crc = crc16_update(0xFFFF, raw, pos - raw);
+    *pos++ = (uint8_t)(crc >> 8);
+    *pos++ = (uint8_t)crc;
+
+    return cobs_encode(raw, pos - raw, out);
+}
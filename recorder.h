@@ -0,0 +1,141 @@
+//*****************************************************************************
+//
+// recorder.h - Flight recorder of the last raw frames and decoder decisions
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#ifndef RECORDER_H_
+#define RECORDER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "decoder.h"
+
+//*****************************************************************************
+// The last RECORDER_FRAMES frames are kept as packed 12 bit samples (3 bytes
+// for 2), with what the decoder made of the last RECORDER_DECISIONS frames.
+// SRAM holds the frame queue and the decoder as well, which leaves room for
+// 80ms of audio on the TM4C123.
+//*****************************************************************************
+#ifndef RECORDER_FRAMES
+#define RECORDER_FRAMES 4
+#endif
+#ifndef RECORDER_DECISIONS
+#define RECORDER_DECISIONS 64
+#endif
+#define RECORDER_PACKED_SIZE (NUM_SAMPLES * 3 / 2)
+
+//*****************************************************************************
+// A dump is a series of blocks, each COBS encoded and ended by a zero so it
+// can share the UART with the console text. Every block is
+//   magic       RECORDER_MAGIC
+//   version     RECORDER_VERSION
+//   type        enum RECORDER_BLOCK
+//   body        depends on the type, multi byte fields little endian
+//   crc         CRC-16/CCITT-FALSE of everything before it, MSB first
+// and the blocks come in this order:
+//   HEADER      sample rate (4), samples per frame (2), frames (1),
+//               decisions (1), trigger (1), trigger sequence (4),
+//               modulation (1), coding (1), packets (1)
+//   FRAME       frame (1), part (1), sequence (4), RECORDER_PART_SIZE bytes
+//               of packed samples, RECORDER_PARTS parts per frame, oldest
+//               frame first
+//   DECISIONS   up to RECORDER_DECISIONS_PER_BLOCK decisions of
+//               RECORDER_DECISION_SIZE bytes, oldest first
+//   END         number of blocks before it (2)
+//*****************************************************************************
+#define RECORDER_MAGIC 0x52
+#define RECORDER_VERSION 1
+#define RECORDER_PARTS 8
+#define RECORDER_PART_SIZE (RECORDER_PACKED_SIZE / RECORDER_PARTS)
+#define RECORDER_DECISION_SIZE 10
+#define RECORDER_DECISIONS_PER_BLOCK 16
+#define RECORDER_MAX_BLOCK (3 + 6 + RECORDER_PART_SIZE + 2)
+
+enum RECORDER_BLOCK {
+    RECORDER_HEADER,
+    RECORDER_FRAME,
+    RECORDER_DECISIONS_BLOCK,
+    RECORDER_END
+};
+
+//*****************************************************************************
+// Why the recorder stopped. It freezes at the end of the frame in which the
+// decoder lost sync or rejected a packet, or when a dump is asked for, and
+// stays frozen until recorder_arm().
+//*****************************************************************************
+enum RECORDER_TRIGGER {
+    RECORDER_RUNNING,
+    RECORDER_REQUEST,
+    RECORDER_SYNC_FAILED,
+    RECORDER_PACKET_REJECTED
+};
+
+//*****************************************************************************
+// Decision flags, events is a bit per DECODER_EVENT raised in the frame
+//*****************************************************************************
+#define RECORDER_RECEIVING 0x01
+#define RECORDER_GATED 0x02
+#define RECORDER_SKIPPED 0x04
+
+struct recorder_decision {
+    uint32_t sequence;
+    uint16_t bit_index;
+    int8_t snr_db;
+    int8_t byte_sync;
+    uint8_t flags;
+    uint8_t events;
+};
+
+struct recorder {
+    uint8_t frames[RECORDER_FRAMES][RECORDER_PACKED_SIZE];
+    uint32_t frame_sequence[RECORDER_FRAMES];
+    struct recorder_decision decisions[RECORDER_DECISIONS];
+    uint32_t frame_count;               // Frames recorded since armed
+    uint32_t decision_count;
+    uint8_t events;                     // Raised since the last frame
+    enum RECORDER_TRIGGER pending;      // Trigger seen in the current frame
+    enum RECORDER_TRIGGER trigger;
+    uint32_t trigger_sequence;
+    int dump_block;                     // Next block of the dump, -1 if none
+};
+
+//*****************************************************************************
+// Start recording, clears what was recorded before
+//*****************************************************************************
+void recorder_init(struct recorder* rec);
+void recorder_arm(struct recorder* rec);
+
+//*****************************************************************************
+// Note a decoder event. Call from the decoder callback, before the frame
+// that raised it is recorded.
+//*****************************************************************************
+void recorder_event(struct recorder* rec, enum DECODER_EVENT event);
+
+//*****************************************************************************
+// Keep a frame after the decoder is done with it, frame can still be the
+// DMA buffer. skipped is the number of frames dropped before it.
+//*****************************************************************************
+void recorder_frame(struct recorder* rec, const struct decoder* dec, const int16_t* frame, uint32_t sequence, uint32_t skipped);
+
+//*****************************************************************************
+// Freeze the recorder (if it is not already) and start a dump
+//*****************************************************************************
+void recorder_dump_start(struct recorder* rec);
+
+//*****************************************************************************
+// Encode the next block of the dump into out, which must hold
+// COBS_ENCODED_SIZE(RECORDER_MAX_BLOCK) bytes. Returns its length, 0 once
+// the dump is over.
+//*****************************************************************************
+int recorder_dump_next(struct recorder* rec, const struct decoder* dec, uint8_t* out);
+
+//*****************************************************************************
+// Packed samples of one frame
+//*****************************************************************************
+void recorder_pack(const int16_t* frame, uint8_t* packed);
+void recorder_unpack(const uint8_t* packed, int16_t* frame);
+
+#endif // RECORDER_H_
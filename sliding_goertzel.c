@@ -0,0 +1,164 @@
+//*****************************************************************************
+//
+// sliding_goertzel.c - Hop based streaming Goertzel detector
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <math.h>
+#include "sliding_goertzel.h"
+
+int sliding_goertzel_init(struct sliding_goertzel* sg, uint32_t target_freq, uint32_t sample_rate, int hop, int hops)
+{
+    int32_t rot_re[SG_MAX_HOPS], rot_im[SG_MAX_HOPS];
+    double w, phase;
+    int slot = 0;
+
+    if (hop <= 0 || hops <= 0 || hops > SG_MAX_HOPS)
+        return -1;
+
+    // Only bin centred tones line the hop rotations up with the window
+    if (((uint64_t)target_freq * hop * hops) % sample_rate)
+        return -1;
+
+    w = (2.0 * 3.14159265358979 * target_freq) / sample_rate;
+    for (slot = 0; slot < hops; slot++) {
+        phase = -w * hop * slot;
+        rot_re[slot] = (int32_t)floor(cos(phase) * (1 << 14) + 0.5);
+        rot_im[slot] = (int32_t)floor(sin(phase) * (1 << 14) + 0.5);
+    }
+
+    return sliding_goertzel_load(sg, (int32_t)floor(2.0 * cos(w) * (1 << 14) + 0.5), (int32_t)floor(cos(w) * (1 << 14) + 0.5),
+        (int32_t)floor(sin(w) * (1 << 14) + 0.5), rot_re, rot_im, hop, hops);
+}
+
+int sliding_goertzel_load(struct sliding_goertzel* sg, int32_t coeff, int32_t cos_w, int32_t sin_w,
+    const int32_t* rot_re, const int32_t* rot_im, int hop, int hops)
+{
+    int slot = 0;
+
+    if (hop <= 0 || hops <= 0 || hops > SG_MAX_HOPS)
+        return -1;
+
+    sg->coeff = coeff;
+    sg->cos_w = cos_w;
+    sg->sin_w = sin_w;
+    for (slot = 0; slot < hops; slot++) {
+        sg->rot_re[slot] = rot_re[slot];
+        sg->rot_im[slot] = rot_im[slot];
+    }
+
+    sg->hop = hop;
+    sg->hops = hops;
+    sliding_goertzel_reset(sg);
+
+    return 0;
+}
+
+void sliding_goertzel_reset(struct sliding_goertzel* sg)
+{
+    int slot = 0;
+
+    for (slot = 0; slot < SG_MAX_HOPS; slot++) {
+        sg->part_re[slot] = 0;
+        sg->part_im[slot] = 0;
+    }
+    sg->sum_re = 0;
+    sg->sum_im = 0;
+    sg->delay_1 = 0;
+    sg->delay_2 = 0;
+    sg->fill = 0;
+    sg->slot = 0;
+}
+
+int sliding_goertzel_update(struct sliding_goertzel* sg, const int16_t* data, int sz, int* trace)
+{
+    int32_t delay;
+    int32_t delay_1 = sg->delay_1;
+    int32_t delay_2 = sg->delay_2;
+    int32_t hop_re, hop_im, part_re, part_im;
+    int64_t energy;
+    int count = 0, i = 0;
+
+    for (i = 0; i < sz; i++) {
+        delay = data[i] + (int32_t)(((int64_t)delay_1 * sg->coeff) >> 14) - delay_2;
+        delay_2 = delay_1;
+        delay_1 = delay;
+
+        if (++sg->fill < sg->hop)
+            continue;
+
+        // Complex result of this hop, then rotate it onto the window's time base
+        hop_re = delay_1 - (int32_t)(((int64_t)delay_2 * sg->cos_w) >> 14);
+        hop_im = (int32_t)(((int64_t)delay_2 * sg->sin_w) >> 14);
+        part_re = (int32_t)(((int64_t)hop_re * sg->rot_re[sg->slot] - (int64_t)hop_im * sg->rot_im[sg->slot]) >> 14);
+        part_im = (int32_t)(((int64_t)hop_re * sg->rot_im[sg->slot] + (int64_t)hop_im * sg->rot_re[sg->slot]) >> 14);
+
+        // Swap the oldest hop out of the running sum
+        sg->sum_re += part_re - sg->part_re[sg->slot];
+        sg->sum_im += part_im - sg->part_im[sg->slot];
+        sg->part_re[sg->slot] = part_re;
+        sg->part_im[sg->slot] = part_im;
+
+        if (++sg->slot == sg->hops)
+            sg->slot = 0;
+
+        energy = (sg->sum_re * sg->sum_re + sg->sum_im * sg->sum_im) >> 17;
+        trace[count++] = (energy > INT32_MAX) ? INT32_MAX : (int)energy;
+
+        delay_1 = 0;
+        delay_2 = 0;
+        sg->fill = 0;
+    }
+
+    sg->delay_1 = delay_1;
+    sg->delay_2 = delay_2;
+
+    return count;
+}
+
+void sliding_goertzel_phasor(const struct sliding_goertzel* sg, int32_t* re, int32_t* im)
+{
+    *re = (sg->sum_re > INT32_MAX) ? INT32_MAX : (sg->sum_re < INT32_MIN) ? INT32_MIN : (int32_t)sg->sum_re;
+    *im = (sg->sum_im > INT32_MAX) ? INT32_MAX : (sg->sum_im < INT32_MIN) ? INT32_MIN : (int32_t)sg->sum_im;
+}
+
+int sliding_goertzel_edge(const int* trace, int count, int threshold)
+{
+    int i = 0;
+
+    for (i = 0; i < count; i++) {
+        if (trace[i] >= threshold)
+            return i;
+    }
+
+    return -1;
+}
+
+int sliding_goertzel_align(const int* trace, int edge, int hops)
+{
+    int i = 0, peak = 0, half = edge;
+    int first = (edge >= hops) ? edge - hops + 1 : 0;
+
+    for (i = edge; i <= edge + hops; i++) {
+        if (trace[i] > peak)
+            peak = trace[i];
+    }
+
+    // Energy goes with the square of the magnitude, half magnitude is 1/4
+    for (i = first; i <= edge + hops; i++) {
+        if (4 * (int64_t)trace[i] >= peak) {
+            half = i;
+            break;
+        }
+    }
+
+    // Round to the nearest hop, the window at half covers between hops / 2
+    // and hops / 2 + 1 hops of the tone
+    if ((int64_t)trace[half] * (4 * hops * hops) < (int64_t)peak * ((hops + 1) * (hops + 1)))
+        return half + hops / 2;
+
+    return half + hops / 2 - 1;
+}
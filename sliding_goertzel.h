@@ -0,0 +1,88 @@
+//*****************************************************************************
+//
+// sliding_goertzel.h - Hop based streaming Goertzel detector
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#ifndef SLIDING_GOERTZEL_H_
+#define SLIDING_GOERTZEL_H_
+
+#include <stdint.h>
+
+//*****************************************************************************
+// Largest number of hops that can make up one detection window
+//*****************************************************************************
+#define SG_MAX_HOPS 16
+
+//*****************************************************************************
+// The window of hop * hops samples is split into hops. Each hop is run through
+// a Goertzel resonator, rotated onto a common time reference and added to a
+// running complex sum, while the hop that leaves the window is subtracted.
+// Every hop therefore gives the full window magnitude for the cost of hop
+// samples, and the integer running sum never drifts.
+//*****************************************************************************
+struct sliding_goertzel {
+    int32_t coeff;                   // 2*cos(w) in Q14
+    int32_t cos_w, sin_w;            // Q14, turn the resonator into a complex bin
+    int32_t rot_re[SG_MAX_HOPS];     // Q14 phase correction for each hop slot
+    int32_t rot_im[SG_MAX_HOPS];
+    int32_t part_re[SG_MAX_HOPS];    // Rotated hop results inside the window
+    int32_t part_im[SG_MAX_HOPS];
+    int64_t sum_re, sum_im;
+    int32_t delay_1, delay_2;        // Resonator state for the hop being filled
+    int hop;                         // Samples per hop
+    int hops;                        // Hops per window
+    int fill;                        // Samples collected for the current hop
+    int slot;                        // Next slot of the window to replace
+};
+
+//*****************************************************************************
+// The tone has to sit on a bin of the full window (for 1024 samples at
+// 51.2kHz that is a multiple of 50Hz). Returns -1 if it does not.
+//*****************************************************************************
+int sliding_goertzel_init(struct sliding_goertzel* sg, uint32_t target_freq, uint32_t sample_rate, int hop, int hops);
+
+//*****************************************************************************
+// Same as sliding_goertzel_init() with the Q14 coefficients worked out
+// already (see freq_plan.h), rot_re and rot_im have hops entries
+//*****************************************************************************
+int sliding_goertzel_load(struct sliding_goertzel* sg, int32_t coeff, int32_t cos_w, int32_t sin_w,
+    const int32_t* rot_re, const int32_t* rot_im, int hop, int hops);
+
+//*****************************************************************************
+// Clear the window, energy ramps up again over the next hops
+//*****************************************************************************
+void sliding_goertzel_reset(struct sliding_goertzel* sg);
+
+//*****************************************************************************
+// Stream samples through the detector. The window energy after every
+// completed hop is written to trace (same scale as goertzel()) and the number
+// of hops written is returned.
+//*****************************************************************************
+int sliding_goertzel_update(struct sliding_goertzel* sg, const int16_t* data, int sz, int* trace);
+
+//*****************************************************************************
+// Complex bin of the window that ended with the last completed hop, its
+// energy is (re^2 + im^2) >> 17. The hops are rotated onto one time base, so
+// a phase continuous tone has the same phase in every window and a change of
+// phase shows as the difference between two windows.
+//*****************************************************************************
+void sliding_goertzel_phasor(const struct sliding_goertzel* sg, int32_t* re, int32_t* im);
+
+//*****************************************************************************
+// Index of the first hop in a trace at or above the threshold, -1 if none
+//*****************************************************************************
+int sliding_goertzel_edge(const int* trace, int count, int threshold);
+
+//*****************************************************************************
+// Locate the first window that holds a whole frame of a tone which switched
+// on near trace[edge]. trace has to extend hops entries past the edge. Window
+// magnitude rises linearly while the tone slides in, so the window reaching
+// half of the final magnitude ends half a frame after the tone started, which
+// gives the start to within half a hop regardless of signal level.
+//*****************************************************************************
+int sliding_goertzel_align(const int* trace, int edge, int hops);
+
+#endif // SLIDING_GOERTZEL_H_
@@ -0,0 +1,206 @@
+//*****************************************************************************
+//
+// symbol_sync.c - Symbol timing recovery on hop energies
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include "goertzel.h"
+#include "symbol_sync.h"
+
+//*****************************************************************************
+// Loop gains as right shifts of the timing error, and the furthest the symbol
+// length may be pulled from nominal (1/64 = 1.5%)
+//*****************************************************************************
+#define SS_PHASE_SHIFT 2
+#define SS_FREQ_SHIFT 5
+#define SS_MAX_PULL_SHIFT 6
+
+//*****************************************************************************
+// Magnitude of the window that ended j hops before the newest one
+//*****************************************************************************
+static int ring_mag(struct symbol_sync* ss, int j)
+{
+    return ss->mag[(ss->head - j) & (SS_RING_HOPS - 1)];
+}
+
+//*****************************************************************************
+// Find where the magnitude crossed mid closest to expected, both relative to
+// now. Returns 0 and leaves crossing untouched if there is no crossing.
+//*****************************************************************************
+static int find_crossing(struct symbol_sync* ss, int mid, int rising, int32_t expected, int32_t* crossing)
+{
+    int32_t hop_time = ss->hop * 256;
+    int32_t t_new, t_found = 0, dist, best = INT32_MAX;
+    int j = 0, m_old, m_new;
+
+    for (j = 0; j + 1 < ss->count; j++) {
+        t_new = -j * hop_time;
+        if (t_new > expected + ss->window * 128 + hop_time)
+            continue;
+        if (t_new < expected - ss->window * 128)
+            break;
+
+        m_new = ring_mag(ss, j);
+        m_old = ring_mag(ss, j + 1);
+        if (rising ? (m_old >= mid || m_new < mid) : (m_old < mid || m_new >= mid))
+            continue;
+
+        t_found = t_new - hop_time + (int32_t)(((int64_t)hop_time * (mid - m_old)) / (m_new - m_old));
+        dist = (t_found > expected) ? t_found - expected : expected - t_found;
+        if (dist < best) {
+            best = dist;
+            *crossing = t_found;
+        }
+    }
+
+    return best != INT32_MAX;
+}
+
+//*****************************************************************************
+// Place a symbol between the averaged levels (or around the threshold before
+// both are known) and fold it into the level it is closer to
+//*****************************************************************************
+static void update_soft(struct symbol_sync* ss, int level, int threshold)
+{
+    int32_t soft, span, mid;
+
+    if (ss->one_level > ss->zero_level && ss->zero_level >= 0) {
+        span = ss->one_level - ss->zero_level;
+        soft = (int32_t)(((int64_t)2 * level - ss->one_level - ss->zero_level) * SS_SOFT_LEVEL / span);
+    } else {
+        mid = goertzel_isqrt(threshold > 0 ? threshold : 0);
+        soft = mid ? (int32_t)((int64_t)(level - mid) * SS_SOFT_LEVEL / mid) : (level ? SS_SOFT_LEVEL : -SS_SOFT_LEVEL);
+    }
+
+    if (soft > 2 * SS_SOFT_LEVEL)
+        soft = 2 * SS_SOFT_LEVEL;
+    if (soft < -2 * SS_SOFT_LEVEL)
+        soft = -2 * SS_SOFT_LEVEL;
+    ss->soft = soft;
+
+    if (soft >= 0)
+        ss->one_level = (ss->one_level < 0) ? level : ss->one_level + (level - ss->one_level) / 4;
+    else
+        ss->zero_level = (ss->zero_level < 0) ? level : ss->zero_level + (level - ss->zero_level) / 4;
+}
+
+void symbol_sync_init(struct symbol_sync* ss, int hop, int window, int frames_per_symbol, int threshold)
+{
+    ss->hop = hop;
+    ss->window = window;
+    ss->threshold = threshold;
+    ss->hold_threshold = threshold;
+    ss->nominal = window * frames_per_symbol * 256;
+    symbol_sync_start(ss, 0);
+}
+
+void symbol_sync_start(struct symbol_sync* ss, int offset)
+{
+    ss->period = ss->nominal;
+    ss->to_end = offset * 256 + ss->period;
+    ss->error = 0;
+    ss->head = 0;
+    ss->count = 0;
+    ss->last_bit = -1;
+    ss->last_level = 0;
+    ss->hold = 0;
+    ss->one_level = -1;
+    ss->zero_level = -1;
+    ss->soft = 0;
+}
+
+void symbol_sync_rate(struct symbol_sync* ss, int frames_per_symbol)
+{
+    int32_t nominal = ss->window * frames_per_symbol * 256;
+    int32_t period = (int32_t)((int64_t)ss->period * nominal / ss->nominal);
+
+    ss->to_end += period - ss->period;
+    ss->period = period;
+    ss->nominal = nominal;
+}
+
+void symbol_sync_threshold(struct symbol_sync* ss, int threshold, int hold_threshold)
+{
+    ss->threshold = threshold;
+    ss->hold_threshold = hold_threshold;
+}
+
+void symbol_sync_hold(struct symbol_sync* ss)
+{
+    ss->hold = 1;
+}
+
+int symbol_sync_push(struct symbol_sync* ss, int energy)
+{
+    int32_t hop_time = ss->hop * 256;
+    int32_t start, first, last, crossing, t, pull;
+    int j = 0, n = 0, level = 0, bit = 0, mid = 0, threshold;
+    int32_t sum = 0;
+
+    ss->head = (ss->head + 1) & (SS_RING_HOPS - 1);
+    ss->mag[ss->head] = goertzel_isqrt((energy > 0) ? energy : 0);
+    if (ss->count < SS_RING_HOPS)
+        ss->count++;
+    ss->to_end -= hop_time;
+
+    if (ss->to_end > 0)
+        return -1;
+
+    // Average the windows that lie fully inside the symbol, keeping a hop of
+    // margin on both sides for timing error
+    start = ss->to_end - ss->period;
+    first = start + ss->window * 256 + hop_time;
+    last = ss->to_end - hop_time;
+    for (j = 0; j < ss->count; j++) {
+        t = -j * hop_time;
+        if (t < first)
+            break;
+        if (t <= last) {
+            sum += ring_mag(ss, j);
+            n++;
+        }
+    }
+
+    // Symbols shorter than window plus margins only have the window at the end
+    if (!n) {
+        j = (-ss->to_end + hop_time / 2) / hop_time;
+        sum = ring_mag(ss, (j < ss->count) ? j : ss->count - 1);
+        n = -1;
+    }
+
+    level = sum / (n < 0 ? 1 : n);
+    threshold = (ss->last_bit == 1) ? ss->hold_threshold : ss->threshold;
+    bit = ((int64_t)level * level >= threshold) ? 1 : 0;
+
+    // That window is up to half a hop off the symbol and takes in part of
+    // its neighbours, so a 1 also has to clear halfway between the levels
+    if (n < 0 && ss->one_level > ss->zero_level && ss->zero_level >= 0 && 2 * level < ss->one_level + ss->zero_level)
+        bit = 0;
+    update_soft(ss, level, threshold);
+
+    // Magnitude is half way between the two levels half a window after the
+    // boundary if our timing is right
+    ss->error = 0;
+    if (!ss->hold && ss->last_bit >= 0 && bit != ss->last_bit) {
+        mid = (level + ss->last_level) / 2;
+        if (find_crossing(ss, mid, bit, start + ss->window * 128, &crossing))
+            ss->error = crossing - (start + ss->window * 128);
+    }
+
+    ss->period += ss->error >> SS_FREQ_SHIFT;
+    pull = ss->nominal >> SS_MAX_PULL_SHIFT;
+    if (ss->period > ss->nominal + pull)
+        ss->period = ss->nominal + pull;
+    if (ss->period < ss->nominal - pull)
+        ss->period = ss->nominal - pull;
+    ss->to_end += ss->period + (ss->error >> SS_PHASE_SHIFT);
+
+    ss->hold = 0;
+    ss->last_bit = bit;
+    ss->last_level = level;
+
+    return bit;
+}
@@ -0,0 +1,97 @@
+//*****************************************************************************
+//
+// symbol_sync.h - Symbol timing recovery on hop energies
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#ifndef SYMBOL_SYNC_H_
+#define SYMBOL_SYNC_H_
+
+#include <stdint.h>
+
+//*****************************************************************************
+// Number of hop magnitudes kept, has to cover one symbol plus one window
+// (decoder.c checks it against FRAMES_PER_BIT). A power of two.
+//*****************************************************************************
+#define SS_RING_HOPS 64
+
+//*****************************************************************************
+// Soft value of a symbol that sits exactly on the one or the zero level
+//*****************************************************************************
+#define SS_SOFT_LEVEL 8
+
+//*****************************************************************************
+// Tracks where symbols start and end while the transmitter clock drifts.
+// Every symbol is decided on the mean magnitude of the windows that lie fully
+// inside it. On every 0/1 transition the point where the magnitude crosses
+// halfway between the two levels is measured to a fraction of a hop; it
+// should sit half a window after the boundary. The difference steers the
+// boundary (phase) and the symbol length (frequency) of a second order loop.
+// Times are relative to the end of the newest hop in 1/256 samples.
+//*****************************************************************************
+struct symbol_sync {
+    int hop;                    // Samples between magnitudes
+    int window;                 // Samples per detector window
+    int threshold;              // Energy a symbol needs to be a 1
+    int hold_threshold;         // Energy it needs to stay a 1 after a 1
+    int32_t nominal;            // Symbol length the transmitter should use
+    int32_t period;             // Current estimate of the symbol length
+    int32_t to_end;             // Time left until the current symbol ends
+    int32_t error;              // Timing error of the last transition
+    int mag[SS_RING_HOPS];
+    int head;
+    int count;
+    int last_bit;
+    int last_level;
+    int hold;
+    int one_level;              // Averaged magnitude of ones, -1 until the first
+    int zero_level;             // Same for zeros
+    int soft;                   // Confidence of the last symbol, positive for a 1
+};
+
+//*****************************************************************************
+// Configure the loop for symbols of frames_per_symbol windows
+//*****************************************************************************
+void symbol_sync_init(struct symbol_sync* ss, int hop, int window, int frames_per_symbol, int threshold);
+
+//*****************************************************************************
+// Change to symbols of frames_per_symbol windows from the next symbol on.
+// The length is scaled by the clock error measured so far, and the end of
+// the next symbol moves with it.
+//*****************************************************************************
+void symbol_sync_rate(struct symbol_sync* ss, int frames_per_symbol);
+
+//*****************************************************************************
+// Change the decision levels. A symbol after a 1 only needs hold_threshold,
+// set it below threshold for hysteresis.
+//*****************************************************************************
+void symbol_sync_threshold(struct symbol_sync* ss, int threshold, int hold_threshold);
+
+//*****************************************************************************
+// Start tracking a new transmission. The first symbol began offset samples
+// after the end of the last hop pushed (negative if it already began).
+//*****************************************************************************
+void symbol_sync_start(struct symbol_sync* ss, int offset);
+
+//*****************************************************************************
+// Add the energy of the next hop. Returns the value of a symbol once it ends,
+// -1 otherwise. The value is 1 when the squared mean magnitude reaches the
+// threshold (hold_threshold after a 1). A symbol too short to hold a window
+// plus margins is read from the window at its end only, and once both levels
+// are known it also has to reach halfway between them to be a 1. soft then
+// holds where the symbol lay between the averaged zero (-SS_SOFT_LEVEL) and
+// one (SS_SOFT_LEVEL) levels, or relative to the threshold until both have
+// been seen. The symbol is averaged into the level on the side of soft, so
+// the levels split halfway between them, not at the threshold.
+//*****************************************************************************
+int symbol_sync_push(struct symbol_sync* ss, int energy);
+
+//*****************************************************************************
+// Skip the timing update on the next transition, used when the detector tone
+// changes so the two levels cannot be compared
+//*****************************************************************************
+void symbol_sync_hold(struct symbol_sync* ss);
+
+#endif // SYMBOL_SYNC_H_
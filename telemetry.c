@@ -0,0 +1,153 @@
+//*****************************************************************************
+//
+// telemetry.c - Binary per frame records of what the decoder saw and did
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <string.h>
+#include "telemetry.h"
+#include "packet.h"
+#include "cobs.h"
+
+static int strongest(const int* energy, int count)
+{
+    int peak = 0, i = 0;
+
+    for (i = 0; i < count; i++) {
+        if (energy[i] > peak)
+            peak = energy[i];
+    }
+
+    return peak;
+}
+
+void telemetry_capture(struct telemetry_record* rec, const struct decoder* dec)
+{
+    rec->sync_power = strongest(&dec->sync_history[SYNC_HISTORY_HOPS - HOPS_PER_FRAME], HOPS_PER_FRAME);
+    rec->data_power = dec->transfer_status ? strongest(dec->data_energy, HOPS_PER_FRAME) : 0;
+    rec->noise = dec->noise.level;
+    rec->snr_db = (int8_t)((dec->snr_db > 127) ? 127 : (dec->snr_db < -128) ? -128 : dec->snr_db);
+    rec->byte_sync = (int8_t)dec->byte_sync;
+    rec->flags = 0;
+    if (dec->transfer_status)
+        rec->flags |= TELEMETRY_RECEIVING;
+    if (dec->gated)
+        rec->flags |= TELEMETRY_GATED;
+    if (!noise_floor_settled(&dec->noise) || dec->settling)
+        rec->flags |= TELEMETRY_SETTLING;
+    rec->bit_index = (uint16_t)dec->bit_output_index;
+}
+
+static uint8_t* put32(uint8_t* out, uint32_t value)
+{
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+    return out + 4;
+}
+
+static uint32_t get32(const uint8_t* in)
+{
+    return in[0] | ((uint32_t)in[1] << 8) | ((uint32_t)in[2] << 16) | ((uint32_t)in[3] << 24);
+}
+
+int telemetry_encode(const struct telemetry_record* rec, uint8_t* out)
+{
+    uint8_t raw[TELEMETRY_RAW_SIZE];
+    uint8_t* pos = raw;
+    uint16_t crc;
+
+    *pos++ = TELEMETRY_VERSION;
+    pos = put32(pos, rec->sequence);
+    pos = put32(pos, rec->cycles);
+    pos = put32(pos, rec->sync_power);
+    pos = put32(pos, rec->data_power);
+    pos = put32(pos, rec->noise);
+    *pos++ = (uint8_t)rec->snr_db;
+    *pos++ = (uint8_t)rec->byte_sync;
+    *pos++ = rec->flags;
+    *pos++ = rec->dropped;
+    *pos++ = (uint8_t)rec->bit_index;
+    *pos++ = (uint8_t)(rec->bit_index >> 8);
+    crc = crc16_update(0xFFFF, raw, TELEMETRY_RAW_SIZE - 2);
+    *pos++ = (uint8_t)(crc >> 8);
+    *pos++ = (uint8_t)crc;
+
+    return cobs_encode(raw, TELEMETRY_RAW_SIZE, out);
+}
+
+//*****************************************************************************
+// Undo the COBS encoding of a window and check the record in it
+//*****************************************************************************
+static int decode_window(const uint8_t* window, struct telemetry_record* rec)
+{
+    uint8_t raw[TELEMETRY_RAW_SIZE];
+    const uint8_t* pos = raw + 1;
+
+    if (cobs_decode(window, TELEMETRY_COBS_SIZE, raw) != TELEMETRY_RAW_SIZE)
+        return 0;
+
+    if (raw[0] != TELEMETRY_VERSION
+        || crc16_update(0xFFFF, raw, TELEMETRY_RAW_SIZE - 2) != ((raw[TELEMETRY_RAW_SIZE - 2] << 8) | raw[TELEMETRY_RAW_SIZE - 1]))
+        return 0;
+
+    rec->sequence = get32(pos);
+    rec->cycles = get32(pos + 4);
+    rec->sync_power = get32(pos + 8);
+    rec->data_power = get32(pos + 12);
+    rec->noise = get32(pos + 16);
+    pos += 20;
+    rec->snr_db = (int8_t)pos[0];
+    rec->byte_sync = (int8_t)pos[1];
+    rec->flags = pos[2];
+    rec->dropped = pos[3];
+    rec->bit_index = (uint16_t)(pos[4] | (pos[5] << 8));
+
+    return 1;
+}
+
+void telemetry_parser_init(struct telemetry_parser* parser)
+{
+    memset(parser, 0, sizeof(*parser));
+}
+
+int telemetry_parser_push(struct telemetry_parser* parser, uint8_t byte, struct telemetry_record* rec, int* text)
+{
+    *text = -1;
+
+    if (!byte) {
+        if (parser->count == TELEMETRY_COBS_SIZE && decode_window(parser->window, rec)) {
+            parser->count = 0;
+            parser->records++;
+            return 1;
+        }
+
+        // Text has no zeros, so whatever was held back was a damaged record
+        parser->count = 0;
+        parser->errors++;
+        return 0;
+    }
+
+    if (parser->count == TELEMETRY_COBS_SIZE) {
+        *text = parser->window[0];
+        memmove(parser->window, parser->window + 1, TELEMETRY_COBS_SIZE - 1);
+        parser->count--;
+    }
+    parser->window[parser->count++] = byte;
+
+    return 0;
+}
+
+int telemetry_parser_flush(struct telemetry_parser* parser, uint8_t* text)
+{
+    int count = parser->count;
+
+    memcpy(text, parser->window, count);
+    parser->count = 0;
+
+    return count;
+}
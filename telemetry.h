@@ -0,0 +1,91 @@
+//*****************************************************************************
+//
+// telemetry.h - Binary per frame records of what the decoder saw and did
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#ifndef TELEMETRY_H_
+#define TELEMETRY_H_
+
+#include <stdint.h>
+#include "decoder.h"
+
+//*****************************************************************************
+// Records are 29 bytes (version, fields little endian, CRC-16 of the rest
+// most significant byte first), COBS encoded so they contain no zero byte and
+// followed by a zero. Console text never has a zero in it either, so both
+// can share the UART and a reader splits them at the zeros.
+//*****************************************************************************
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_RAW_SIZE 29
+#define TELEMETRY_COBS_SIZE (TELEMETRY_RAW_SIZE + 1)
+#define TELEMETRY_ENCODED_SIZE (TELEMETRY_COBS_SIZE + 1)
+
+//*****************************************************************************
+// Record flags
+//   RECEIVING      a start sequence has been found, bits are being decoded
+//   GATED          the energy gate kept the detectors off for this frame
+//   SETTLING       the noise floor is not trusted yet
+//   OVERRUN        frames were dropped right before this one
+//   TEXT_DROPPED   console messages were lost since the last record
+//*****************************************************************************
+#define TELEMETRY_RECEIVING 0x01
+#define TELEMETRY_GATED 0x02
+#define TELEMETRY_SETTLING 0x04
+#define TELEMETRY_OVERRUN 0x08
+#define TELEMETRY_TEXT_DROPPED 0x10
+
+struct telemetry_record {
+    uint32_t sequence;              // Frame sequence number from the frame queue
+    uint32_t cycles;                // Time spent decoding the frame
+    uint32_t sync_power;            // Strongest hop on the sync carrier
+    uint32_t data_power;            // Strongest hop on the data carrier while receiving
+    uint32_t noise;                 // Noise floor, 1 / (1 << NF_FRACTION_BITS) units
+    int8_t snr_db;
+    int8_t byte_sync;               // enum SYNCHRONIZATION
+    uint8_t flags;
+    uint8_t dropped;                // Frames dropped before this one, at most 255
+    uint16_t bit_index;             // Bits of the current message so far
+};
+
+//*****************************************************************************
+// Fill in the fields that come from the decoder after it processed a frame.
+// sequence, cycles, dropped and the OVERRUN and TEXT_DROPPED flags are left
+// to the caller.
+//*****************************************************************************
+void telemetry_capture(struct telemetry_record* rec, const struct decoder* dec);
+
+//*****************************************************************************
+// Encode a record with its trailing zero, always TELEMETRY_ENCODED_SIZE bytes
+//*****************************************************************************
+int telemetry_encode(const struct telemetry_record* rec, uint8_t* out);
+
+//*****************************************************************************
+// Splits a byte stream into records and the text around them. The last
+// TELEMETRY_COBS_SIZE bytes are held back until it is clear whether they
+// belong to a record.
+//*****************************************************************************
+struct telemetry_parser {
+    uint8_t window[TELEMETRY_COBS_SIZE];
+    int count;
+    uint32_t records;
+    uint32_t errors;                // Zeros that did not end a valid record
+};
+
+void telemetry_parser_init(struct telemetry_parser* parser);
+
+//*****************************************************************************
+// Add the next byte. Returns 1 when it completed a record, which is written
+// to rec. text is set to a byte of console text that is now known not to be
+// part of a record, or -1.
+//*****************************************************************************
+int telemetry_parser_push(struct telemetry_parser* parser, uint8_t byte, struct telemetry_record* rec, int* text);
+
+//*****************************************************************************
+// Text still held back at the end of the stream, returns its length
+//*****************************************************************************
+int telemetry_parser_flush(struct telemetry_parser* parser, uint8_t* text);
+
+#endif // TELEMETRY_H_
@@ -0,0 +1,476 @@
+//*****************************************************************************
+//
+// baseband_bench.c - Cost and detection results of the baseband front-end
+//
+// Compares detecting the tones of the channel plan with the detectors the
+// decoder runs at the full rate against mixing the ADC readings down and
+// decimating them with baseband_process() first and detecting the tones with
+// baseband_amplitude() on the decimated samples. For each decimation:
+//   amplitude  worst difference of a lone tone of each plan tone within the
+//              decimated band from goertzel_window() at the full rate
+//   ook        bit errors on random keying of the data and sync carriers in
+//              uniform noise, of the decoder's sliding detectors (the window
+//              that ends with the frame, against the energy of a carrier at
+//              half the amplitude) and of the front-end, and the bits they
+//              decide differently
+//   mfsk       symbol errors on random MFSK symbols of goertzel_bank16() and
+//              of the front-end, both picking the strongest tone, and the
+//              symbols they decide differently (when all of the tones are
+//              in the band)
+//   timing     time per frame of the decoder's detectors and of the
+//              front-end plus the decimated detectors for the same tones,
+//              for the OOK carriers, the MFSK tones and every plan tone in
+//              the band (goertzel(), goertzel_bank16() and goertzel_window()
+//              there)
+// Times are in ns and in cycles. On x86 the cycles are read from the time
+// stamp counter, elsewhere they are the ns at the clock given with -f. These
+// are host figures, not the M4's. With -S the run fails if an amplitude is
+// more than 2% apart or the front-end makes more than a quarter more errors
+// than the decoder's detectors plus 1% of the frames. Noise from outside the
+// band that the CIC filter lets through adds to that inside it, most towards
+// the band edges.
+//
+// Build (from this directory):
+//   cc -O2 -I.. -o baseband_bench baseband_bench.c ../baseband.c ../freq_plan.c ../goertzel.c ../nco.c ../sliding_goertzel.c -lm
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include "baseband.h"
+#include "freq_plan.h"
+#include "goertzel.h"
+#include "sliding_goertzel.h"
+
+#define CENTRE_FREQ 20800
+#define NUM_FRAMES 400
+#define TONE_AMPLITUDE 100
+#define THRESHOLD (TONE_AMPLITUDE / 2)
+#define MAX_DECIMATED (NUM_SAMPLES + 1)
+
+static const uint32_t plan_tones[] = { PLAN_TONES(PLAN_FREQ) };
+static const int decimations[] = { 8, 16, 32 };
+static const int noise_levels[] = { 0, 600, 900, 1200 };
+
+#define NUM_PLAN_TONES (int)(sizeof(plan_tones) / sizeof(plan_tones[0]))
+#define NUM_DECIMATIONS (int)(sizeof(decimations) / sizeof(decimations[0]))
+#define NUM_NOISE_LEVELS (int)(sizeof(noise_levels) / sizeof(noise_levels[0]))
+
+//*****************************************************************************
+// The plan tones in the band of a decimation and their detectors at both
+// rates
+//*****************************************************************************
+struct detectors {
+    struct baseband bb;
+    struct baseband_tone tones[PLAN_NUM_TONES];
+    int coeffs[PLAN_NUM_TONES];
+    int plan_index[PLAN_NUM_TONES];
+    int num_tones;
+    int data, sync;                     // Index of the carriers, -1 if out of band
+    bool mfsk;                          // All MFSK tones in band
+    int mfsk_tones[MFSK_NUM_TONES];     // Index of each MFSK tone
+    struct sliding_goertzel carriers[2];  // The decoder's data and sync detectors
+    int mfsk_coeffs[MFSK_NUM_TONES];    // and its MFSK bank
+};
+
+//*****************************************************************************
+// Time of one frame through a set of detectors
+//*****************************************************************************
+struct timing {
+    double ns;
+    double cycles;
+};
+
+static uint32_t rng_state;
+static double clock_hz = 1e9;
+
+//*****************************************************************************
+// xorshift32, so every run sees the same frames
+//*****************************************************************************
+static uint32_t rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static int noise(int amplitude)
+{
+    return amplitude ? (int)(rng() % (2 * amplitude + 1)) - amplitude : 0;
+}
+
+static double seconds(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//*****************************************************************************
+// Time stamp counter, 0 where there is none
+//*****************************************************************************
+static uint64_t cycle_count(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+//*****************************************************************************
+// Window energy, on the scale of goertzel(), of a tone of amplitude ADC
+// counts on a bin of the frame
+//*****************************************************************************
+static int tone_energy(int amplitude)
+{
+    double bin = amplitude * NUM_SAMPLES / 2.0;
+
+    return (int)(bin * bin / (1 << 17));
+}
+
+static int setup(struct detectors* d, int decimation)
+{
+    int tone = 0;
+
+    if (baseband_init(&d->bb, CENTRE_FREQ, PLAN_SAMPLE_RATE, decimation))
+        return -1;
+
+    d->num_tones = 0;
+    d->data = d->sync = -1;
+    d->mfsk = true;
+    for (tone = 0; tone < NUM_PLAN_TONES; tone++) {
+        if (baseband_tone(&d->bb, &d->tones[d->num_tones], plan_tones[tone])) {
+            if (tone >= PLAN_MFSK_0 && tone < PLAN_MFSK_0 + MFSK_NUM_TONES)
+                d->mfsk = false;
+            continue;
+        }
+        if (tone == PLAN_DATA)
+            d->data = d->num_tones;
+        if (tone == PLAN_SYNC)
+            d->sync = d->num_tones;
+        if (tone >= PLAN_MFSK_0 && tone < PLAN_MFSK_0 + MFSK_NUM_TONES)
+            d->mfsk_tones[tone - PLAN_MFSK_0] = d->num_tones;
+        d->coeffs[d->num_tones] = goertzel_coeff(plan_tones[tone], PLAN_SAMPLE_RATE);
+        d->plan_index[d->num_tones] = tone;
+        d->num_tones++;
+    }
+
+    for (tone = 0; tone < MFSK_NUM_TONES; tone++)
+        d->mfsk_coeffs[tone] = freq_plan_coeff(plan_tones[PLAN_MFSK_0 + tone], PLAN_SAMPLE_RATE);
+
+    return freq_plan_detector(&d->carriers[0], DATA_TONE_FREQ, PLAN_SAMPLE_RATE, HOP_SIZE, HOPS_PER_FRAME)
+        || freq_plan_detector(&d->carriers[1], SYNC_TONE_FREQ, PLAN_SAMPLE_RATE, HOP_SIZE, HOPS_PER_FRAME) ? -1 : 0;
+}
+
+//*****************************************************************************
+// Next frame of a phase continuous stream: DC biased like the ADC, the
+// tones given with their amplitudes, uniform noise, clipped to 12 bits
+//*****************************************************************************
+static void make_frame(int16_t* data, long frame, const uint32_t* freqs, const int* amplitudes, int num_freqs,
+    int noise_amplitude)
+{
+    double value, t;
+    int i = 0, k = 0, sample = 0;
+
+    for (i = 0; i < NUM_SAMPLES; i++) {
+        t = ((double)frame * NUM_SAMPLES + i) / PLAN_SAMPLE_RATE;
+        value = 2048;
+        for (k = 0; k < num_freqs; k++)
+            value += amplitudes[k] * sin(2 * M_PI * freqs[k] * t + k);
+        sample = (int)floor(value + 0.5) + noise(noise_amplitude);
+        data[i] = (sample < 0) ? 0 : (sample > 4095) ? 4095 : sample;
+    }
+}
+
+//*****************************************************************************
+// Worst relative difference of the two amplitudes of a lone tone, measured
+// a few frames in so the filter has settled
+//*****************************************************************************
+static double amplitude_error(struct detectors* d)
+{
+    static int16_t data[NUM_SAMPLES];
+    int16_t re[MAX_DECIMATED], im[MAX_DECIMATED];
+    int amplitude = 300, n = 0, k = 0;
+    double full, decimated, err, worst = 0;
+    long frame = 0;
+
+    for (k = 0; k < d->num_tones; k++) {
+        baseband_reset(&d->bb);
+        for (frame = 0; frame < 4; frame++) {
+            make_frame(data, frame, &plan_tones[d->plan_index[k]], &amplitude, 1, 0);
+            n = baseband_process(&d->bb, data, NUM_SAMPLES, re, im);
+        }
+        full = goertzel_window(data, NUM_SAMPLES, d->coeffs[k], NULL);
+        decimated = baseband_amplitude(re, im, n, &d->tones[k]);
+        err = fabs(decimated - full) / full;
+        if (err > worst)
+            worst = err;
+    }
+
+    return worst;
+}
+
+//*****************************************************************************
+// Random OOK bits on both carriers, returns bit errors of the decoder's
+// detectors and of the front-end and the bits they decide differently
+//*****************************************************************************
+static void run_ook(struct detectors* d, int noise_amplitude, int* full_errors, int* decimated_errors, int* differ)
+{
+    static int16_t data[NUM_SAMPLES];
+    int16_t re[MAX_DECIMATED], im[MAX_DECIMATED];
+    uint32_t freqs[2] = { DATA_TONE_FREQ, SYNC_TONE_FREQ };
+    int carriers[2], amplitudes[2], energy[HOPS_PER_FRAME], n = 0, c = 0, full, decimated;
+    long frame = 0;
+
+    carriers[0] = d->data;
+    carriers[1] = d->sync;
+    *full_errors = *decimated_errors = *differ = 0;
+    baseband_reset(&d->bb);
+    sliding_goertzel_reset(&d->carriers[0]);
+    sliding_goertzel_reset(&d->carriers[1]);
+    for (frame = 0; frame < NUM_FRAMES; frame++) {
+        amplitudes[0] = (rng() & 1) ? TONE_AMPLITUDE : 0;
+        amplitudes[1] = (rng() & 1) ? TONE_AMPLITUDE : 0;
+        make_frame(data, frame, freqs, amplitudes, 2, noise_amplitude);
+        n = baseband_process(&d->bb, data, NUM_SAMPLES, re, im);
+        for (c = 0; c < 2; c++) {
+            sliding_goertzel_update(&d->carriers[c], data, NUM_SAMPLES, energy);
+            full = energy[HOPS_PER_FRAME - 1] >= tone_energy(THRESHOLD);
+            decimated = baseband_amplitude(re, im, n, &d->tones[carriers[c]])
+                >= (THRESHOLD << GOERTZEL_AMPLITUDE_SHIFT);
+            *full_errors += (full != (amplitudes[c] > 0));
+            *decimated_errors += (decimated != (amplitudes[c] > 0));
+            *differ += (full != decimated);
+        }
+    }
+}
+
+//*****************************************************************************
+// Random MFSK symbols, returns symbol errors of goertzel_bank16() and of the
+// front-end and the symbols they decide differently
+//*****************************************************************************
+static void run_mfsk(struct detectors* d, int noise_amplitude, int* full_errors, int* decimated_errors, int* differ)
+{
+    static int16_t data[NUM_SAMPLES];
+    int16_t re[MAX_DECIMATED], im[MAX_DECIMATED];
+    int full[MFSK_NUM_TONES], decimated[MFSK_NUM_TONES];
+    int amplitude = TONE_AMPLITUDE, n = 0, k = 0, symbol = 0, full_symbol, decimated_symbol;
+    uint32_t freq;
+    long frame = 0;
+
+    *full_errors = *decimated_errors = *differ = 0;
+    baseband_reset(&d->bb);
+    for (frame = 0; frame < NUM_FRAMES; frame++) {
+        symbol = rng() % MFSK_NUM_TONES;
+        freq = plan_tones[PLAN_MFSK_0 + symbol];
+        make_frame(data, frame, &freq, &amplitude, 1, noise_amplitude);
+        n = baseband_process(&d->bb, data, NUM_SAMPLES, re, im);
+        goertzel_bank16(data, NUM_SAMPLES, d->mfsk_coeffs, full, MFSK_NUM_TONES);
+        for (k = 0; k < MFSK_NUM_TONES; k++)
+            decimated[k] = baseband_amplitude(re, im, n, &d->tones[d->mfsk_tones[k]]);
+        full_symbol = goertzel_strongest(full, MFSK_NUM_TONES, 0);
+        decimated_symbol = goertzel_strongest(decimated, MFSK_NUM_TONES, 0);
+        *full_errors += (full_symbol != symbol);
+        *decimated_errors += (decimated_symbol != symbol);
+        *differ += (full_symbol != decimated_symbol);
+    }
+}
+
+//*****************************************************************************
+// What time_path() times on every frame
+//*****************************************************************************
+enum PATH {
+    SLIDING,            // The decoder's OOK carriers
+    FRONT_END_OOK,      // Front-end and the same carriers decimated
+    MFSK_BANK16,        // The decoder's MFSK bank
+    FRONT_END_MFSK,     // Front-end and the MFSK tones decimated
+    GOERTZEL,           // Every plan tone in the band, goertzel()
+    BANK16,             // goertzel_bank16()
+    WINDOW,             // goertzel_window()
+    FRONT_END,          // front-end and decimated detectors
+    NUM_PATHS
+};
+
+static void time_path(struct detectors* d, int16_t* data, int path, double min_time, struct timing* t)
+{
+    int16_t re[MAX_DECIMATED], im[MAX_DECIMATED];
+    int power[GOERTZEL_MAX_BINS], energy[HOPS_PER_FRAME];
+    volatile int32_t sink = 0;
+    unsigned long passes = 0;
+    uint64_t started = cycle_count(), cycles;
+    double start = seconds(), elapsed;
+    int n = 0, k = 0;
+
+    do {
+        switch (path) {
+        case SLIDING:
+            sliding_goertzel_update(&d->carriers[0], data, NUM_SAMPLES, energy);
+            sink += energy[HOPS_PER_FRAME - 1];
+            sliding_goertzel_update(&d->carriers[1], data, NUM_SAMPLES, energy);
+            sink += energy[HOPS_PER_FRAME - 1];
+            break;
+        case FRONT_END_OOK:
+            n = baseband_process(&d->bb, data, NUM_SAMPLES, re, im);
+            sink += baseband_amplitude(re, im, n, &d->tones[d->data]);
+            sink += baseband_amplitude(re, im, n, &d->tones[d->sync]);
+            break;
+        case MFSK_BANK16:
+            goertzel_bank16(data, NUM_SAMPLES, d->mfsk_coeffs, power, MFSK_NUM_TONES);
+            sink += goertzel_strongest(power, MFSK_NUM_TONES, 0);
+            break;
+        case FRONT_END_MFSK:
+            n = baseband_process(&d->bb, data, NUM_SAMPLES, re, im);
+            for (k = 0; k < MFSK_NUM_TONES; k++)
+                power[k] = baseband_amplitude(re, im, n, &d->tones[d->mfsk_tones[k]]);
+            sink += goertzel_strongest(power, MFSK_NUM_TONES, 0);
+            break;
+        case GOERTZEL:
+            for (k = 0; k < d->num_tones; k++)
+                sink += goertzel(data, NUM_SAMPLES, d->coeffs[k]);
+            break;
+        case BANK16:
+            goertzel_bank16(data, NUM_SAMPLES, d->coeffs, power, d->num_tones);
+            sink += power[0];
+            break;
+        case WINDOW:
+            for (k = 0; k < d->num_tones; k++)
+                sink += goertzel_window(data, NUM_SAMPLES, d->coeffs[k], NULL);
+            break;
+        default:
+            n = baseband_process(&d->bb, data, NUM_SAMPLES, re, im);
+            for (k = 0; k < d->num_tones; k++)
+                sink += baseband_amplitude(re, im, n, &d->tones[k]);
+        }
+        passes++;
+        elapsed = seconds() - start;
+    } while (elapsed < min_time);
+
+    cycles = cycle_count() - started;
+    t->ns = elapsed * 1e9 / passes;
+    t->cycles = cycles ? (double)cycles / passes : t->ns * clock_hz / 1e9;
+}
+
+//*****************************************************************************
+// One timing line, the decoder's detectors against the front-end
+//*****************************************************************************
+static void print_timing(const char* name, const char* detector, const struct timing* full,
+    const struct timing* decimated)
+{
+    printf("  timing     %-5s %-8s %7.0f ns %8.0f cycles, front-end %7.0f ns %8.0f cycles (%.2f of the time)\n",
+        name, detector, full->ns, full->cycles, decimated->ns, decimated->cycles, decimated->ns / full->ns);
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "usage: baseband_bench [-t seconds] [-f clock_hz] [-S]\n"
+        "  -t  minimum timing run per path (default 0.2)\n"
+        "  -f  clock to turn ns into cycles without a time stamp counter (default 1e9)\n"
+        "  -S  self-test, fail if the decimated path falls behind\n");
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    static struct detectors d;
+    static int16_t data[NUM_SAMPLES];
+    struct timing t[NUM_PATHS];
+    double min_time = 0.2, err;
+    bool self_test = false;
+    int opt, i = 0, level = 0, path = 0, failures = 0;
+    int full_errors, decimated_errors, differ, allowed;
+    int amplitudes[PLAN_NUM_TONES];
+
+    while ((opt = getopt(argc, argv, "t:f:Sh")) != -1) {
+        switch (opt) {
+        case 't':
+            min_time = atof(optarg);
+            break;
+        case 'f':
+            clock_hz = atof(optarg);
+            break;
+        case 'S':
+            self_test = true;
+            break;
+        default:
+            usage();
+        }
+    }
+
+    printf("%d sample frames at %d Hz, mixed down from %d Hz, %d CIC stages\n", NUM_SAMPLES, PLAN_SAMPLE_RATE,
+        CENTRE_FREQ, BASEBAND_CIC_STAGES);
+    if (!self_test)
+        printf("cycles are %s\n", cycle_count() ? "time stamp counter ticks" : "ns at the -f clock");
+
+    for (i = 0; i < NUM_DECIMATIONS; i++) {
+        if (setup(&d, decimations[i])) {
+            fprintf(stderr, "decimation %d not supported\n", decimations[i]);
+            return 1;
+        }
+        printf("\ndecimation %d: %d samples a frame at %d Hz, %d of %d plan tones in band\n", decimations[i],
+            NUM_SAMPLES / decimations[i], PLAN_SAMPLE_RATE / decimations[i], d.num_tones, NUM_PLAN_TONES);
+
+        err = amplitude_error(&d);
+        printf("  amplitude  worst difference from goertzel_window() %.3f%%%s\n", 100 * err,
+            (err > 0.02) ? " - FAIL" : "");
+        failures += (err > 0.02);
+
+        rng_state = 0x2545F491;
+        for (level = 0; d.data >= 0 && d.sync >= 0 && level < NUM_NOISE_LEVELS; level++) {
+            run_ook(&d, noise_levels[level], &full_errors, &decimated_errors, &differ);
+            allowed = full_errors + full_errors / 4 + NUM_FRAMES / 100;
+            printf("  ook        noise %4d: errors sliding %3d front-end %3d of %d bits, %3d differ%s\n",
+                noise_levels[level], full_errors, decimated_errors, 2 * NUM_FRAMES, differ,
+                (decimated_errors > allowed) ? " - FAIL" : "");
+            failures += (decimated_errors > allowed);
+        }
+
+        for (level = 0; d.mfsk && level < NUM_NOISE_LEVELS; level++) {
+            run_mfsk(&d, noise_levels[level], &full_errors, &decimated_errors, &differ);
+            allowed = full_errors + full_errors / 4 + NUM_FRAMES / 100;
+            printf("  mfsk       noise %4d: errors bank16 %3d front-end %3d of %d symbols, %3d differ%s\n",
+                noise_levels[level], full_errors, decimated_errors, NUM_FRAMES, differ,
+                (decimated_errors > allowed) ? " - FAIL" : "");
+            failures += (decimated_errors > allowed);
+        }
+
+        if (self_test)
+            continue;
+
+        // Every tone in band at once for the timing
+        for (path = 0; path < NUM_PLAN_TONES; path++)
+            amplitudes[path] = TONE_AMPLITUDE;
+        make_frame(data, 0, plan_tones, amplitudes, NUM_PLAN_TONES, 50);
+        for (path = 0; path < NUM_PATHS; path++) {
+            if ((path == FRONT_END_OOK && (d.data < 0 || d.sync < 0)) || (path == FRONT_END_MFSK && !d.mfsk))
+                continue;
+            time_path(&d, data, path, min_time, &t[path]);
+        }
+        if (d.data >= 0 && d.sync >= 0)
+            print_timing("ook", "sliding", &t[SLIDING], &t[FRONT_END_OOK]);
+        if (d.mfsk)
+            print_timing("mfsk", "bank16", &t[MFSK_BANK16], &t[FRONT_END_MFSK]);
+        print_timing("all", "bank16", &t[BANK16], &t[FRONT_END]);
+        printf("  timing     all   goertzel %7.0f ns %8.0f cycles, window %7.0f ns %8.0f cycles\n", t[GOERTZEL].ns,
+            t[GOERTZEL].cycles, t[WINDOW].ns, t[WINDOW].cycles);
+    }
+
+    if (self_test)
+        printf("%s\n", failures ? "FAIL" : "PASS");
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,744 @@
+//*****************************************************************************
+//
+// channel_sim.c - Monte Carlo error rates of the receiver over a simulated
+// channel
+//
+// Every trial sends one random message with the reference transmitter
+// (transmitter.c) through the channel below and decodes it with a fresh
+// decoder:
+//   clock      the transmitter clock is -c ppm off, which moves the tones and
+//              stretches the bits together
+//   offset     every tone is -f Hz off
+//   multipath  echoes at -M delay_ms:gain,... added to the direct path
+//   noise      white Gaussian noise for the SNR of the point, which is the
+//              carrier power over the noise power in one detector bin as in
+//              snr_sweep (27dB above the SNR over the whole band)
+//   adc        gain -g in front of the 12 bit ADC, which is clipped and
+//              quantized to -b bits
+// With -R the transmitter announces a rate profile in the start sequence and
+// sends with it, while the decoder is set up for -m and -e as usual.
+// With -C 2 to 4 the decoder listens on that many microphones, combined by
+// selection or max ratio diversity (-D). Each has its own noise, a gain from
+// -A and, with -F clear_ms:blocked_ms, drops out: it stays clear for a
+// random time of clear_ms on average, then is blocked by -B dB for a random
+// time of blocked_ms on average. The readings go through the decoder
+// interleaved the way the ADC sequence delivers them.
+// Trials run on -j threads. Each trial has its own random generator seeded
+// from -r, the point and the trial, so the table does not depend on the
+// number of threads, and a change to the receiver can be compared against
+// the table from before it. Per SNR point:
+//   per        messages that did not come back exactly, out of all sent
+//   ber        bit errors in the messages that came back out of their bits,
+//              a missing or extra character counts as 8
+//   lost       messages that never came back
+//   false      sync failures and rejected packets
+//   latency    mean and worst time from the end of the transmission until
+//              the decoder handed the message over, negative when the
+//              message is complete before the ramp down of the last tone
+//
+// Build (from this directory):
+//   cc -O2 -I.. -o channel_sim channel_sim.c ../transmitter.c ../nco.c
+//      ../decoder.c ../goertzel.c ../sliding_goertzel.c ../symbol_sync.c
+//      ../fft.c ../energy_gate.c ../noise_floor.c ../fec.c ../packet.c
+//      ../freq_plan.c ../diversity.c ../ofdm.c -lm -lpthread
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "transmitter.h"
+#include "diversity.h"
+
+#define MAX_THREADS 256
+#define MAX_POINTS 256
+#define MAX_ECHOES 8
+#define MAX_LENGTH 200
+#define ECHO_HISTORY 4096                   // Longest echo delay in samples, a power of 2
+#define TAIL_SECONDS 1.0
+
+//*****************************************************************************
+// Channel and receiver settings, the same for every trial
+//*****************************************************************************
+struct echo {
+    int delay;                              // Samples after the direct path
+    double gain;
+};
+
+static const char* const modulation_names[] = { "ook", "mfsk", "dbpsk", "dqpsk", "ofdm" };
+static enum MODULATION modulation = OOK;
+static enum FEC_CODE coding = FEC_NONE;
+static int profile = RATE_DEFAULT;
+static bool packets = false;
+static bool gating = true;
+static bool adaptive = true;
+static int message_length = 12;
+static int32_t clock_ppm = 0;
+static int32_t freq_offset = 0;
+static struct echo echoes[MAX_ECHOES];
+static int num_echoes = 0;
+static int adc_bits = 12;
+static double adc_gain = 1.0;
+static uint64_t seed = 1;
+static int channels = 1;
+static enum DIVERSITY_MODE diversity_mode = DIVERSITY_MAX_RATIO;
+static double mic_gains[DIVERSITY_MAX_CHANNELS] = { 1.0, 1.0, 1.0, 1.0 };
+static double clear_ms = 0;
+static double blocked_ms = 0;
+static double blocked_db = 20;
+
+//*****************************************************************************
+// What one trial came to
+//*****************************************************************************
+struct trial {
+    bool received;
+    bool exact;
+    uint32_t bits;                          // Bits of the message that came back
+    uint32_t bit_errors;
+    int failures;
+    double latency;                         // Seconds, the sample it was handed over at until the trial ends
+};
+
+static double snrs[MAX_POINTS];
+static int num_points;
+static int trials_per_point = 200;
+static struct trial* trials;
+static int next_trial;
+static pthread_mutex_t trial_lock = PTHREAD_MUTEX_INITIALIZER;
+
+//*****************************************************************************
+// Per thread state of the trial being run
+//*****************************************************************************
+struct run {
+    struct decoder dec;
+    struct diversity div;
+    double fade[DIVERSITY_MAX_CHANNELS];    // Gain of each microphone at the start of the frame
+    bool blocked[DIVERSITY_MAX_CHANNELS];
+    struct trial* trial;
+    uint64_t random;
+    double spare;                           // Second value of the last Box-Muller pair
+    bool has_spare;
+    char sent[MAX_LENGTH + 1];
+    char text[PACKET_MAX_PAYLOAD + 1];
+    int length;
+    uint64_t end_sample;                    // First sample after the transmission
+    double history[ECHO_HISTORY];
+};
+
+//*****************************************************************************
+// xorshift64, seeded through splitmix64 so neighbouring trials are unrelated
+//*****************************************************************************
+static uint64_t splitmix64(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+static uint64_t random64(struct run* run)
+{
+    run->random ^= run->random << 13;
+    run->random ^= run->random >> 7;
+    run->random ^= run->random << 17;
+    return run->random;
+}
+
+static double uniform(struct run* run)
+{
+    return ((random64(run) >> 11) + 0.5) / 9007199254740992.0;
+}
+
+static double gaussian(struct run* run)
+{
+    double radius, angle;
+
+    if (run->has_spare) {
+        run->has_spare = false;
+        return run->spare;
+    }
+
+    radius = sqrt(-2.0 * log(uniform(run)));
+    angle = 2.0 * M_PI * uniform(run);
+    run->spare = radius * sin(angle);
+    run->has_spare = true;
+    return radius * cos(angle);
+}
+
+//*****************************************************************************
+// Bit errors between what was sent and what came back
+//*****************************************************************************
+static void score(struct run* run, const char* text, int length)
+{
+    struct trial* trial = run->trial;
+    int sent = strlen(run->sent), i = 0;
+    uint8_t diff;
+
+    if (trial->received) {
+        trial->failures++;
+        return;
+    }
+
+    trial->received = true;
+    trial->exact = (length == sent && !memcmp(text, run->sent, sent));
+    trial->bits = 8 * ((length > sent) ? length : sent);
+    trial->bit_errors = 8 * abs(length - sent);
+    for (i = 0; i < length && i < sent; i++) {
+        for (diff = (uint8_t)(text[i] ^ run->sent[i]); diff; diff &= diff - 1)
+            trial->bit_errors++;
+    }
+    trial->latency = (double)run->dec.frames * NUM_SAMPLES;
+}
+
+static void on_event(void* ctx, enum DECODER_EVENT event, int value)
+{
+    struct run* run = ctx;
+
+    switch (event) {
+    case DECODER_LOCK:
+        run->length = 0;
+        break;
+    case DECODER_CHAR:
+        if (run->length < PACKET_MAX_PAYLOAD)
+            run->text[run->length++] = (char)value;
+        break;
+    case DECODER_END:
+        score(run, run->text, run->length);
+        break;
+    case DECODER_PACKET:
+        score(run, (const char*)run->dec.packet.payload, value);
+        break;
+    case DECODER_SYNC_FAILED:
+    case DECODER_PACKET_REJECTED:
+        run->trial->failures++;
+        break;
+    case DECODER_RETUNE:
+    case DECODER_RATE:
+        break;
+    }
+}
+
+//*****************************************************************************
+// Send one message through the channel at this SNR and decode it
+//*****************************************************************************
+static void run_trial(struct run* run, int index)
+{
+    struct transmitter tx;
+    int16_t clean[NUM_SAMPLES], frame[DIVERSITY_MAX_CHANNELS * NUM_SAMPLES];
+    double amplitude, sigma, value, reading, step = (double)(1 << (12 - adc_bits));
+    double fade_to[DIVERSITY_MAX_CHANNELS], blocked_gain = pow(10.0, -blocked_db / 20.0);
+    uint64_t sample = 0, lead, tail = 0;
+    int i = 0, e = 0, c = 0, count = 0;
+    bool sending = false;
+
+    memset(run, 0, offsetof(struct run, history));
+    memset(run->history, 0, sizeof(run->history));
+    run->trial = &trials[index];
+    run->random = splitmix64(seed ^ splitmix64((uint64_t)index + 1)) | 1;
+
+    transmitter_init(&tx, PLAN_SAMPLE_RATE, modulation, coding);
+    transmitter_set_profile(&tx, profile);
+    tx.clock_ppm = clock_ppm;
+    tx.freq_offset = freq_offset;
+    decoder_init(&run->dec, PLAN_SAMPLE_RATE, modulation, on_event, run);
+    run->dec.energy_gating = gating;
+    run->dec.adaptive_threshold = adaptive;
+    run->dec.coding = coding;
+    run->dec.packets = packets;
+    if (channels > 1)
+        decoder_set_diversity(&run->dec, &run->div, channels, diversity_mode);
+    for (c = 0; c < channels; c++)
+        run->fade[c] = fade_to[c] = 1.0;
+
+    // Carrier power in a bin is A^2 N^2 / 4 and noise is sigma^2 N, with A
+    // the tone amplitude in ADC counts
+    amplitude = tx.amplitude / 16.0 * adc_gain;
+    sigma = amplitude * sqrt(NUM_SAMPLES / (4.0 * pow(10.0, snrs[index / trials_per_point] / 10.0)));
+
+    // Printable text, never the stop byte
+    for (i = 0; i < message_length; i++)
+        run->sent[i] = (char)(0x21 + random64(run) % 94);
+    run->sent[message_length] = 0;
+
+    // Half a second to a second and a half of noise first, so the floor has
+    // settled and the message starts anywhere in a frame. MFSK is read on
+    // the receiver's frames, so it starts on one. DPSK is read to the hop
+    // wherever it starts.
+    lead = PLAN_SAMPLE_RATE / 2 + random64(run) % PLAN_SAMPLE_RATE;
+    if (tx.modulation == MFSK)
+        lead += NUM_SAMPLES - (lead + TX_LEAD_SAMPLES) % NUM_SAMPLES;
+
+    while (!tail || sample < tail) {
+        if (sample < lead) {
+            count = (lead - sample < NUM_SAMPLES) ? (int)(lead - sample) : NUM_SAMPLES;
+            memset(clean, 0, count * sizeof(int16_t));
+        } else {
+            if (!sending && !tail) {
+                if (packets)
+                    transmitter_send_packet(&tx, 0, 0, 0, (const uint8_t*)run->sent, message_length);
+                else
+                    transmitter_send_text(&tx, run->sent, message_length);
+                sending = true;
+            }
+            count = sending ? transmitter_generate(&tx, clean, NUM_SAMPLES) : 0;
+            if (count < NUM_SAMPLES && sending) {
+                sending = false;
+                run->end_sample = sample + count;
+                tail = run->end_sample + (uint64_t)(TAIL_SECONDS * PLAN_SAMPLE_RATE);
+            }
+            if (count < NUM_SAMPLES) {
+                memset(clean + count, 0, (NUM_SAMPLES - count) * sizeof(int16_t));
+                count = NUM_SAMPLES;
+            }
+        }
+
+        // Echoes, dropouts, noise and the ADC, one frame of readings at a
+        // time. A microphone that is blocked or cleared fades over a frame.
+        for (i = 0; i < count; i++, sample++) {
+            if (clear_ms > 0 && !(sample % NUM_SAMPLES)) {
+                for (c = 0; c < channels; c++) {
+                    run->fade[c] = fade_to[c];
+                    if (uniform(run) < NUM_SAMPLES * 1000.0 / ((run->blocked[c] ? blocked_ms : clear_ms) * PLAN_SAMPLE_RATE))
+                        run->blocked[c] = !run->blocked[c];
+                    fade_to[c] = run->blocked[c] ? blocked_gain : 1.0;
+                }
+            }
+
+            value = clean[i];
+            run->history[sample & (ECHO_HISTORY - 1)] = value;
+            for (e = 0; e < num_echoes; e++)
+                value += echoes[e].gain * run->history[(sample - echoes[e].delay) & (ECHO_HISTORY - 1)];
+            for (c = 0; c < channels; c++) {
+                reading = value * mic_gains[c] * (run->fade[c] + (fade_to[c] - run->fade[c]) * (sample % NUM_SAMPLES) / NUM_SAMPLES);
+                reading = reading / 16.0 * adc_gain + sigma * gaussian(run);
+                reading = floor(reading / step + 0.5) * step + 2048.0;
+                frame[(sample % NUM_SAMPLES) * channels + c] = (int16_t)(reading < 0 ? 0 : reading > 4095 ? 4095 : reading);
+            }
+            if (sample % NUM_SAMPLES == NUM_SAMPLES - 1) {
+                diversity_deinterleave(frame, channels, NUM_SAMPLES);
+                decoder_process(&run->dec, frame);
+            }
+        }
+    }
+
+    // Messages can be handed over before the transmission ended
+    if (run->trial->received)
+        run->trial->latency = (run->trial->latency - (double)run->end_sample) / PLAN_SAMPLE_RATE;
+}
+
+static void* worker_main(void* arg)
+{
+    struct run* run;
+    int index;
+
+    (void)arg;
+    run = malloc(sizeof(*run));
+    if (!run)
+        return NULL;
+
+    for (;;) {
+        pthread_mutex_lock(&trial_lock);
+        index = next_trial++;
+        pthread_mutex_unlock(&trial_lock);
+        if (index >= num_points * trials_per_point)
+            break;
+        run_trial(run, index);
+    }
+
+    free(run);
+    return NULL;
+}
+
+//*****************************************************************************
+// One line of the table, adding the trials up in order so the result does
+// not depend on which thread ran them
+//*****************************************************************************
+static void print_point(int point)
+{
+    const struct trial* trial = &trials[point * trials_per_point];
+    unsigned long bits = 0, bit_errors = 0, wrong = 0, lost = 0, failures = 0;
+    double latency = 0, worst = 0;
+    int i = 0, received = 0;
+
+    for (i = 0; i < trials_per_point; i++, trial++) {
+        failures += trial->failures;
+        if (!trial->exact)
+            wrong++;
+        if (!trial->received) {
+            lost++;
+            continue;
+        }
+        received++;
+        bits += trial->bits;
+        bit_errors += trial->bit_errors;
+        latency += trial->latency;
+        if (received == 1 || trial->latency > worst)
+            worst = trial->latency;
+    }
+
+    printf("%5.1f | %5.3f  %8.2e  %5lu  %5lu |", snrs[point], (double)wrong / trials_per_point,
+        bits ? (double)bit_errors / bits : 0.0, lost, failures);
+    if (received)
+        printf(" %7.1f %7.1f\n", 1000.0 * latency / received, 1000.0 * worst);
+    else
+        printf("       -       -\n");
+}
+
+//*****************************************************************************
+// Run every trial of every point on the threads, returns the wall time
+//*****************************************************************************
+static double simulate(int num_threads)
+{
+    pthread_t threads[MAX_THREADS];
+    struct timespec start, end;
+    int i = 0;
+
+    next_trial = 0;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < num_threads; i++)
+        pthread_create(&threads[i], NULL, worker_main, NULL);
+    for (i = 0; i < num_threads; i++)
+        pthread_join(threads[i], NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    return (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+//*****************************************************************************
+// Clean messages must all come back, in noise far below the detectors most
+// must not, and the trials must come out the same on any number of threads.
+// OOK must also get through from a clock 500 ppm off either way.
+// Readings of 1 to 4 microphones must come out of the interleave in order,
+// and with the first of two microphones deaf both combiners must still
+// deliver every message.
+//*****************************************************************************
+static int self_test(void)
+{
+    static int16_t samples[DIVERSITY_MAX_CHANNELS * NUM_SAMPLES];
+    struct trial* first;
+    size_t size;
+    int i = 0, s = 0, c = 0, mode = 0, lost = 0;
+
+    for (channels = 1; channels <= DIVERSITY_MAX_CHANNELS; channels++) {
+        for (s = 0; s < NUM_SAMPLES; s++) {
+            for (c = 0; c < channels; c++)
+                samples[s * channels + c] = (int16_t)(c * NUM_SAMPLES + s);
+        }
+        diversity_deinterleave(samples, channels, NUM_SAMPLES);
+        for (i = 0; i < channels * NUM_SAMPLES; i++) {
+            if (samples[i] != i) {
+                printf("reading %d of %d microphones is %d after the interleave\n", i, channels, samples[i]);
+                return 1;
+            }
+        }
+    }
+    channels = 1;
+
+    snrs[0] = 30;
+    snrs[1] = -10;
+    num_points = 2;
+    trials_per_point = 12;
+    clock_ppm = 100;
+    freq_offset = 20;
+    echoes[0].delay = 40;
+    echoes[0].gain = 0.3;
+    num_echoes = 1;
+
+    size = (size_t)num_points * trials_per_point * sizeof(struct trial);
+    trials = calloc(1, size);
+    first = malloc(size);
+    if (!trials || !first) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    simulate(1);
+    memcpy(first, trials, size);
+    memset(trials, 0, size);
+    simulate(3);
+
+    for (i = 0; i < trials_per_point; i++) {
+        if (!trials[i].exact) {
+            printf("trial %d at 30dB did not come back\n", i);
+            return 1;
+        }
+        if (!trials[trials_per_point + i].received)
+            lost++;
+    }
+    if (lost < trials_per_point / 2) {
+        printf("only %d of %d messages lost at -10dB\n", lost, trials_per_point);
+        return 1;
+    }
+    if (memcmp(first, trials, size)) {
+        printf("trials differ between 1 and 3 threads\n");
+        return 1;
+    }
+
+    // Phase steps and OFDM with the clock error, offset and echo still on
+    num_points = 1;
+    for (mode = DBPSK; mode <= OFDM; mode++) {
+        modulation = (enum MODULATION)mode;
+        memset(trials, 0, size);
+        simulate(1);
+        for (i = 0; i < trials_per_point; i++) {
+            if (!trials[i].exact) {
+                printf("%s trial %d at 30dB did not come back\n", modulation_names[modulation], i);
+                return 1;
+            }
+        }
+    }
+    modulation = OOK;
+
+    // Every profile, switched to from OOK and back after the message
+    for (profile = 1; profile < RATE_NUM_PROFILES; profile++) {
+        if (!rate_profiles[profile].frames_per_bit)
+            continue;
+        memset(trials, 0, size);
+        simulate(1);
+        for (i = 0; i < trials_per_point; i++) {
+            if (!trials[i].exact) {
+                printf("profile %d trial %d at 30dB did not come back\n", profile, i);
+                return 1;
+            }
+        }
+    }
+    profile = RATE_DEFAULT;
+
+    // OOK from a transmitter clock 500 ppm slow and 500 ppm fast, the drift
+    // the symbol synchronizer has to follow
+    for (clock_ppm = -500; clock_ppm <= 500; clock_ppm += 1000) {
+        memset(trials, 0, size);
+        simulate(1);
+        for (i = 0; i < trials_per_point; i++) {
+            if (!trials[i].exact) {
+                printf("trial %d at %+d ppm did not come back\n", i, (int)clock_ppm);
+                return 1;
+            }
+        }
+    }
+    clock_ppm = 100;
+
+    channels = 2;
+    mic_gains[0] = 0;
+    for (mode = DIVERSITY_SELECTION; mode <= DIVERSITY_MAX_RATIO; mode++) {
+        diversity_mode = (enum DIVERSITY_MODE)mode;
+        memset(trials, 0, size);
+        simulate(1);
+        for (i = 0; i < trials_per_point; i++) {
+            if (!trials[i].exact) {
+                printf("trial %d with %s diversity did not come back\n", i, mode ? "max ratio" : "selection");
+                return 1;
+            }
+        }
+    }
+
+    free(first);
+    free(trials);
+    printf("self-test passed\n");
+    return 0;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "usage: channel_sim [-l snr] [-h snr] [-s step] [-t trials] [-j threads] [-L length]\n"
+        "                   [-m ook|mfsk|dbpsk|dqpsk|ofdm] [-e none|hamming|conv] [-R profile] [-p] [-c ppm] [-f Hz] [-M delay_ms:gain,...] [-b bits]\n"
+        "                   [-g gain] [-r seed] [-C mics] [-D sel|mrc] [-A gain,...] [-F ms:ms] [-B dB] [-G] [-T] [-S]\n"
+        "  -l, -h, -s  lowest and highest SNR in a detector bin and the step, in dB (default 3 to 30 by 3)\n"
+        "  -t  trials per SNR point (default 200)\n"
+        "  -j  threads (default one per core)\n"
+        "  -L  characters per message (default 12)\n"
+        "  -m  modulation after the start sequence (default ook)\n"
+        "  -e  error correcting code on OOK data (default none)\n"
+        "  -R  rate profile 1-15 the transmitter announces and sends with, see decoder.h\n"
+        "  -p  send packets with a CRC instead of text ended by a zero byte\n"
+        "  -c  transmitter clock error in ppm (default 0)\n"
+        "  -f  offset of every tone in Hz (default 0)\n"
+        "  -M  echoes, delay in ms and gain relative to the direct path\n"
+        "  -b  ADC resolution in bits (default 12)\n"
+        "  -g  gain in front of the ADC, 1 puts the tones at 256 counts (default 1)\n"
+        "  -r  random seed (default 1)\n"
+        "  -C  microphones, 1 to 4 (default 1), DBPSK, DQPSK and OFDM only have one\n"
+        "  -D  combine microphones by selection or max ratio (default mrc)\n"
+        "  -A  gain of each microphone (default 1)\n"
+        "  -F  mean time in ms a microphone stays clear and blocked (default never blocked)\n"
+        "  -B  attenuation of a blocked microphone in dB (default 20)\n"
+        "  -G  run the detectors on every frame instead of only when the energy gate opens\n"
+        "  -T  detect carriers at a fixed level instead of relative to the noise floor\n"
+        "  -S  run the self-test\n");
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    double min_snr = 3, max_snr = 30, step = 3, snr, wall, delay;
+    char* token;
+    int opt, num_threads = (int)sysconf(_SC_NPROCESSORS_ONLN), point = 0, i = 0;
+
+    while ((opt = getopt(argc, argv, "l:h:s:t:j:L:m:e:R:pc:f:M:b:g:r:C:D:A:F:B:GTS")) != -1) {
+        switch (opt) {
+        case 'l':
+            min_snr = atof(optarg);
+            break;
+        case 'h':
+            max_snr = atof(optarg);
+            break;
+        case 's':
+            step = atof(optarg);
+            break;
+        case 't':
+            trials_per_point = atoi(optarg);
+            break;
+        case 'j':
+            num_threads = atoi(optarg);
+            break;
+        case 'L':
+            message_length = atoi(optarg);
+            break;
+        case 'm':
+            for (i = 0; i < 5 && strcmp(optarg, modulation_names[i]); i++)
+                ;
+            if (i == 5)
+                usage();
+            modulation = (enum MODULATION)i;
+            break;
+        case 'e':
+            if (!strcmp(optarg, "hamming"))
+                coding = FEC_HAMMING;
+            else if (!strcmp(optarg, "conv"))
+                coding = FEC_CONVOLUTIONAL;
+            else if (strcmp(optarg, "none"))
+                usage();
+            break;
+        case 'R':
+            profile = atoi(optarg);
+            break;
+        case 'p':
+            packets = true;
+            break;
+        case 'c':
+            clock_ppm = atoi(optarg);
+            break;
+        case 'f':
+            freq_offset = atoi(optarg);
+            break;
+        case 'M':
+            for (token = strtok(optarg, ","); token; token = strtok(NULL, ",")) {
+                if (num_echoes == MAX_ECHOES || sscanf(token, "%lf:%lf", &delay, &echoes[num_echoes].gain) != 2)
+                    usage();
+                echoes[num_echoes].delay = (int)(delay * PLAN_SAMPLE_RATE / 1000.0 + 0.5);
+                if (echoes[num_echoes].delay < 1 || echoes[num_echoes].delay >= ECHO_HISTORY)
+                    usage();
+                num_echoes++;
+            }
+            break;
+        case 'b':
+            adc_bits = atoi(optarg);
+            break;
+        case 'g':
+            adc_gain = atof(optarg);
+            break;
+        case 'r':
+            seed = strtoull(optarg, NULL, 0);
+            break;
+        case 'C':
+            channels = atoi(optarg);
+            break;
+        case 'D':
+            if (!strcmp(optarg, "sel"))
+                diversity_mode = DIVERSITY_SELECTION;
+            else if (strcmp(optarg, "mrc"))
+                usage();
+            break;
+        case 'A':
+            i = 0;
+            for (token = strtok(optarg, ","); token; token = strtok(NULL, ",")) {
+                if (i == DIVERSITY_MAX_CHANNELS)
+                    usage();
+                mic_gains[i++] = atof(token);
+            }
+            break;
+        case 'F':
+            if (sscanf(optarg, "%lf:%lf", &clear_ms, &blocked_ms) != 2 || clear_ms <= 0 || blocked_ms <= 0)
+                usage();
+            break;
+        case 'B':
+            blocked_db = atof(optarg);
+            break;
+        case 'G':
+            gating = false;
+            break;
+        case 'T':
+            adaptive = false;
+            break;
+        case 'S':
+            return self_test();
+        default:
+            usage();
+        }
+    }
+    if (step <= 0 || trials_per_point < 1 || message_length < 1 || message_length > MAX_LENGTH
+        || (packets && message_length > PACKET_MAX_PAYLOAD) || adc_bits < 1 || adc_bits > 12 || adc_gain <= 0
+        || channels < 1 || channels > DIVERSITY_MAX_CHANNELS || (channels > 1 && modulation >= DBPSK)
+        || profile < 0 || profile >= RATE_NUM_PROFILES || (profile && !rate_profiles[profile].frames_per_bit)
+        || (channels > 1 && rate_profiles[profile].modulation >= DBPSK))
+        usage();
+    if (num_threads < 1)
+        num_threads = 1;
+    if (num_threads > MAX_THREADS)
+        num_threads = MAX_THREADS;
+
+    for (snr = min_snr; snr <= max_snr + 1e-9 && num_points < MAX_POINTS; snr += step)
+        snrs[num_points++] = snr;
+    trials = calloc((size_t)num_points * trials_per_point, sizeof(struct trial));
+    if (!trials) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    printf("# %s, %s code, %s of %d characters, %d frames per bit, %d trials per point, seed %llu\n",
+        modulation_names[modulation], (coding == FEC_HAMMING) ? "hamming" : (coding == FEC_CONVOLUTIONAL) ? "conv" : "no",
+        packets ? "packets" : "text", message_length, FRAMES_PER_BIT, trials_per_point, (unsigned long long)seed);
+    if (profile)
+        printf("# sent with rate profile %d, %s, %s code, %d frame(s) per OOK bit\n", profile,
+            modulation_names[rate_profiles[profile].modulation],
+            (rate_profiles[profile].coding == FEC_HAMMING) ? "hamming" : (rate_profiles[profile].coding == FEC_CONVOLUTIONAL) ? "conv" : "no",
+            rate_profiles[profile].frames_per_bit);
+    printf("# clock %+d ppm, offset %+d Hz, %d echo(s)", (int)clock_ppm, (int)freq_offset, num_echoes);
+    for (i = 0; i < num_echoes; i++)
+        printf(" %.2fms:%g", echoes[i].delay * 1000.0 / PLAN_SAMPLE_RATE, echoes[i].gain);
+    printf(", %d bit ADC, gain %g, %s threshold%s\n", adc_bits, adc_gain, adaptive ? "adaptive" : "fixed",
+        gating ? "" : ", no energy gate");
+    if (channels > 1 || clear_ms > 0) {
+        printf("# %d microphone(s)", channels);
+        for (i = 0; i < channels; i++)
+            printf("%s%g", i ? "," : " at ", mic_gains[i]);
+        if (channels > 1)
+            printf(", %s diversity", (diversity_mode == DIVERSITY_SELECTION) ? "selection" : "max ratio");
+        if (clear_ms > 0)
+            printf(", blocked by %gdB for %gms every %gms on average", blocked_db, blocked_ms, clear_ms + blocked_ms);
+        printf("\n");
+    }
+    printf("  snr |   per       ber   lost  false | latency ms mean   max\n");
+    fflush(stdout);
+
+    wall = simulate(num_threads);
+
+    for (point = 0; point < num_points; point++)
+        print_point(point);
+    fflush(stdout);
+
+    fprintf(stderr, "%d trials in %.1f s on %d thread(s)\n", num_points * trials_per_point, wall, num_threads);
+    free(trials);
+
+    return 0;
+}
@@ -0,0 +1,169 @@
+//*****************************************************************************
+//
+// console_stress.c - Check the console ring against a slow transmitter
+//
+// First the formatter is compared with the C library's snprintf on a table
+// of formats. Then a producer thread prints numbered lines as fast as it can
+// while the main thread drains the ring in random sized blocks at a limited
+// rate, like the UART DMA would. The text received must consist of whole
+// lines in order, and every gap in the numbering must be announced by a
+// "messages dropped" note of the right count.
+//
+// Build (from this directory):
+//   cc -O2 -I.. -o console_stress console_stress.c ../console.c -lpthread
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "console.h"
+
+static struct console console;
+static uint32_t num_lines = 200000;
+static volatile bool producer_done;
+
+static void* producer(void* arg)
+{
+    uint32_t line = 0;
+
+    (void)arg;
+    for (line = 0; line < num_lines; line++)
+        console_printf(&console, "line %u %c %s %08x\n", line, 'a' + line % 26, "payload", line * 2654435761u);
+
+    producer_done = true;
+    return NULL;
+}
+
+static int check_format(void)
+{
+    char expected[CONSOLE_LINE_SIZE], got[CONSOLE_LINE_SIZE];
+    const char* data;
+    int errors = 0, len = 0, i = 0;
+
+    struct {
+        const char* format;
+        int value;
+    } cases[] = {
+        { "%d", 0 }, { "%d", -1 }, { "%d", 2147483647 }, { "%d", -2147483647 - 1 },
+        { "%5d", 42 }, { "%05d", -42 }, { "%u", -1 }, { "%x", 0xBEEF }, { "%08x", 0xBEEF },
+        { "%c", 'Z' }, { "[%3u]", 7 }, { "100%%", 0 },
+    };
+
+    for (i = 0; i < (int)(sizeof(cases) / sizeof(cases[0])); i++) {
+        snprintf(expected, sizeof(expected), cases[i].format, cases[i].value);
+        console_init(&console);
+        console_printf(&console, cases[i].format, cases[i].value);
+        len = console_pending(&console, &data);
+        memcpy(got, data, len);
+        got[len] = 0;
+        if (strcmp(got, expected)) {
+            printf("format \"%s\": \"%s\", expected \"%s\"\n", cases[i].format, got, expected);
+            errors++;
+        }
+    }
+
+    return errors;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "usage: console_stress [-n lines] [-b max_block] [-d drain_delay_us]\n"
+        "  defaults: 200000 lines, blocks of up to 64 bytes, 1us between blocks\n");
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    pthread_t thread;
+    struct timespec delay = { 0, 1000 };
+    static char text[1 << 16];
+    char expected[CONSOLE_LINE_SIZE];
+    const char* data;
+    char* line;
+    char* end;
+    uint32_t next = 0, number, received = 0, announced = 0, missing = 0;
+    int opt, max_block = 64, block, len = 0, fill = 0, errors = 0;
+
+    while ((opt = getopt(argc, argv, "n:b:d:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            num_lines = strtoul(optarg, NULL, 0);
+            break;
+        case 'b':
+            max_block = atoi(optarg);
+            break;
+        case 'd':
+            delay.tv_nsec = atol(optarg) * 1000;
+            break;
+        default:
+            usage();
+        }
+    }
+    if (max_block < 1)
+        usage();
+
+    errors = check_format();
+
+    console_init(&console);
+    srand(1);
+    pthread_create(&thread, NULL, producer, NULL);
+
+    while (!producer_done || console.head != console.tail) {
+        len = console_pending(&console, &data);
+        block = 1 + rand() % max_block;
+        if (len > block)
+            len = block;
+        if (len > (int)sizeof(text) - 1 - fill)
+            len = sizeof(text) - 1 - fill;
+        memcpy(text + fill, data, len);
+        console_consume(&console, len);
+        fill += len;
+        nanosleep(&delay, NULL);
+
+        // Check every complete line received so far
+        text[fill] = 0;
+        line = text;
+        while ((end = strchr(line, '\n'))) {
+            *end = 0;
+            if (sscanf(line, "%u messages dropped", &number) == 1 && strstr(line, "dropped")) {
+                announced += number;
+            } else if (sscanf(line, "line %u", &number) == 1) {
+                snprintf(expected, sizeof(expected), "line %u %c %s %08x", number, 'a' + number % 26, "payload", number * 2654435761u);
+                if (strcmp(line, expected) || number < next || number - next != announced) {
+                    if (errors++ < 10)
+                        printf("line %u after %u with %u announced: \"%s\"\n", number, next, announced, line);
+                }
+                missing += number - next;
+                next = number + 1;
+                announced = 0;
+                received++;
+            } else if (errors++ < 10) {
+                printf("garbage: \"%s\"\n", line);
+            }
+            line = end + 1;
+        }
+        fill -= line - text;
+        memmove(text, line, fill);
+    }
+    pthread_join(thread, NULL);
+
+    missing += num_lines - next;
+    if (console.dropped_messages != missing) {
+        printf("%u lines missing but %u counted as dropped\n", missing, console.dropped_messages);
+        errors++;
+    }
+
+    printf("%u lines, %u received, %u dropped (%u bytes), %d errors\n",
+        num_lines, received, console.dropped_messages, console.dropped_bytes, errors);
+
+    return errors ? 1 : 0;
+}
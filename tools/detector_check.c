@@ -0,0 +1,261 @@
+//*****************************************************************************
+//
+// detector_check.c - Synthetic tone checks of the Goertzel detectors
+//
+// Runs the detectors over fixed seed synthetic frames, DC biased like the
+// ADC with tones and noise, and checks them against what they stand in for:
+//   bank       goertzel_bank() has to give exactly what goertzel() gives on
+//              every bin, over tones from silence to full scale
+//   bank16     goertzel_bank16() (SMLAD, SSE2/AVX2 or NEON, as built) has to
+//              give exactly what goertzel_bank16_scalar() gives for 1 to
+//              GOERTZEL_MAX_BINS bins at any level, and both what goertzel()
+//              gives while the states fit 16 bits (tones up to 300 counts)
+//   mfsk       a stream of random MFSK symbols, one a frame, has to come out
+//              of goertzel_bank() and goertzel_bank16() with
+//              goertzel_strongest() as it went in, in noise up to about
+//              twice the tone amplitude
+//   sliding    sliding_goertzel_update() fed in pieces of random length has
+//              to give the energy of a direct DFT over the last window after
+//              every hop, for a carrier switching on at several offsets, and
+//              sliding_goertzel_align() has to put the start of the tone
+//              within half a hop
+// Any check that fails is printed and the exit status is 1. The whole
+// receiver is checked on MFSK messages by ultragen -S.
+//
+// Build (from this directory):
+//   cc -O2 -I.. -o detector_check detector_check.c ../goertzel.c ../sliding_goertzel.c -lm
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <unistd.h>
+#include "freq_plan.h"
+#include "goertzel.h"
+#include "sliding_goertzel.h"
+
+#define NUM_FRAMES 2000
+#define STREAM_SAMPLES (4 * NUM_SAMPLES)
+
+static uint32_t rng_state = 0x2545F491;
+static int failures;
+
+//*****************************************************************************
+// xorshift32, so every run sees the same frames
+//*****************************************************************************
+static uint32_t rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static int noise(int amplitude)
+{
+    return amplitude ? (int)(rng() % (2 * amplitude + 1)) - amplitude : 0;
+}
+
+//*****************************************************************************
+// count readings from start samples into a phase continuous stream of a tone
+// of amplitude on freq, plus uniform noise, clipped to 12 bits
+//*****************************************************************************
+static void make_tone(int16_t* data, int count, long start, double freq, int amplitude, int noise_amplitude)
+{
+    double value;
+    int i = 0, sample = 0;
+
+    for (i = 0; i < count; i++) {
+        value = 2048 + amplitude * sin(2 * M_PI * freq * (start + i) / PLAN_SAMPLE_RATE + 0.7);
+        sample = (int)floor(value + 0.5) + noise(noise_amplitude);
+        data[i] = (sample < 0) ? 0 : (sample > 4095) ? 4095 : sample;
+    }
+}
+
+//*****************************************************************************
+// goertzel_bank() against goertzel() on the MFSK tones, the carriers and the
+// noise references, with one of them or a tone between bins switched on
+//*****************************************************************************
+static void check_bank(void)
+{
+    static const uint32_t freqs[] = { PLAN_TONES(PLAN_FREQ) };
+    int16_t data[NUM_SAMPLES];
+    int coeffs[GOERTZEL_MAX_BINS], power[GOERTZEL_MAX_BINS];
+    int num_bins = PLAN_NUM_TONES, frame = 0, bin = 0, expected, wrong = 0;
+    double freq;
+
+    for (bin = 0; bin < num_bins; bin++)
+        coeffs[bin] = goertzel_coeff(freqs[bin], PLAN_SAMPLE_RATE);
+
+    for (frame = 0; frame < NUM_FRAMES; frame++) {
+        freq = (frame & 1) ? freqs[rng() % num_bins] : 17000 + rng() % 7000;
+        make_tone(data, NUM_SAMPLES, 0, freq, rng() % 2048, rng() % 50);
+        goertzel_bank(data, NUM_SAMPLES, coeffs, power, num_bins);
+        for (bin = 0; bin < num_bins; bin++) {
+            expected = goertzel(data, NUM_SAMPLES, coeffs[bin]);
+            if (power[bin] != expected && wrong++ < 10)
+                printf("  frame %d bin %u Hz: bank %d, goertzel %d\n", frame, (unsigned)freqs[bin], power[bin], expected);
+        }
+    }
+
+    printf("bank   %d frames of %d bins, %d differ from goertzel()\n", NUM_FRAMES, num_bins, wrong);
+    failures += (wrong != 0);
+}
+
+//*****************************************************************************
+// The 16 bit state bank on GOERTZEL_MAX_BINS bins 250Hz apart from 17 kHz,
+// with every number of bins in turn
+//*****************************************************************************
+static void check_bank16(void)
+{
+    int16_t data[NUM_SAMPLES];
+    int coeffs[GOERTZEL_MAX_BINS], power[GOERTZEL_MAX_BINS], scalar[GOERTZEL_MAX_BINS];
+    int frame = 0, bin = 0, num_bins, amplitude, vector_wrong = 0, scalar_wrong = 0;
+
+    for (bin = 0; bin < GOERTZEL_MAX_BINS; bin++)
+        coeffs[bin] = goertzel_coeff(17000 + 250 * bin, PLAN_SAMPLE_RATE);
+
+    for (frame = 0; frame < NUM_FRAMES; frame++) {
+        num_bins = 1 + frame % GOERTZEL_MAX_BINS;
+        amplitude = (frame & 1) ? rng() % 300 : rng() % 2048;
+        make_tone(data, NUM_SAMPLES, 0, 17000 + rng() % 4000, amplitude, rng() % 20);
+        goertzel_bank16(data, NUM_SAMPLES, coeffs, power, num_bins);
+        goertzel_bank16_scalar(data, NUM_SAMPLES, coeffs, scalar, num_bins);
+        for (bin = 0; bin < num_bins; bin++) {
+            if (power[bin] != scalar[bin] && vector_wrong++ < 10)
+                printf("  frame %d bin %d: bank16 %d, scalar %d\n", frame, bin, power[bin], scalar[bin]);
+            if (amplitude < 300 && scalar[bin] != goertzel(data, NUM_SAMPLES, coeffs[bin]) && scalar_wrong++ < 10)
+                printf("  frame %d bin %d: scalar %d, goertzel %d\n", frame, bin, scalar[bin],
+                    goertzel(data, NUM_SAMPLES, coeffs[bin]));
+        }
+    }
+
+    printf("bank16 %d frames, %d outputs differ from the scalar version, %d below 300 counts from goertzel()\n",
+        NUM_FRAMES, vector_wrong, scalar_wrong);
+    failures += (vector_wrong != 0 || scalar_wrong != 0);
+}
+
+//*****************************************************************************
+// A stream of random symbols at each noise level, decoded the way the
+// decoder reads an MFSK frame
+//*****************************************************************************
+static void check_mfsk(void)
+{
+    static const int noise_levels[] = { 0, 100, 200 };
+    int16_t data[NUM_SAMPLES];
+    int coeffs[MFSK_NUM_TONES], power[MFSK_NUM_TONES], power16[MFSK_NUM_TONES];
+    int level = 0, frame = 0, tone = 0, symbol, wrong, wrong16;
+
+    for (tone = 0; tone < MFSK_NUM_TONES; tone++)
+        coeffs[tone] = goertzel_coeff(MFSK_BASE_FREQ + tone * MFSK_TONE_SPACING, PLAN_SAMPLE_RATE);
+
+    for (level = 0; level < (int)(sizeof(noise_levels) / sizeof(noise_levels[0])); level++) {
+        wrong = wrong16 = 0;
+        for (frame = 0; frame < NUM_FRAMES; frame++) {
+            symbol = rng() % MFSK_NUM_TONES;
+            make_tone(data, NUM_SAMPLES, (long)frame * NUM_SAMPLES, MFSK_BASE_FREQ + symbol * MFSK_TONE_SPACING, 100,
+                noise_levels[level]);
+            goertzel_bank(data, NUM_SAMPLES, coeffs, power, MFSK_NUM_TONES);
+            goertzel_bank16(data, NUM_SAMPLES, coeffs, power16, MFSK_NUM_TONES);
+            wrong += (goertzel_strongest(power, MFSK_NUM_TONES, 1) != symbol);
+            wrong16 += (goertzel_strongest(power16, MFSK_NUM_TONES, 1) != symbol);
+        }
+        printf("mfsk   noise %3d: %d symbols, %d wrong from the bank, %d from bank16\n", noise_levels[level],
+            NUM_FRAMES, wrong, wrong16);
+        failures += (wrong != 0 || wrong16 != 0);
+    }
+}
+
+//*****************************************************************************
+// Energy of the window of NUM_SAMPLES readings that ends at end, in double
+// precision on the scale of the sliding detector. Readings before the
+// stream count as zero, as they do for a detector that was just reset.
+//*****************************************************************************
+static double reference_energy(const int16_t* data, int end, double freq)
+{
+    double w = 2 * M_PI * freq / PLAN_SAMPLE_RATE, re = 0, im = 0;
+    int i = 0;
+
+    for (i = (end > NUM_SAMPLES) ? end - NUM_SAMPLES : 0; i < end; i++) {
+        re += data[i] * cos(w * i);
+        im -= data[i] * sin(w * i);
+    }
+
+    return (re * re + im * im) / (1 << 17);
+}
+
+//*****************************************************************************
+// Silence, then the data carrier switched on at start for the rest of the
+// stream
+//*****************************************************************************
+static void check_sliding(void)
+{
+    static const int starts[] = { 0, 1, 37, 64, 127, 128, 300, 511, 777, 1023, 1500 };
+    static int16_t data[STREAM_SAMPLES];
+    int trace[STREAM_SAMPLES / HOP_SIZE];
+    struct sliding_goertzel sg;
+    int k = 0, i = 0, fed = 0, piece, count = 0, edge, window, wrong = 0, full;
+    double ref, worst = 0, err;
+    long found;
+
+    for (k = 0; k < (int)(sizeof(starts) / sizeof(starts[0])); k++) {
+        make_tone(data, starts[k], 0, DATA_TONE_FREQ, 0, 2);
+        make_tone(data + starts[k], STREAM_SAMPLES - starts[k], starts[k], DATA_TONE_FREQ, 200, 2);
+        sliding_goertzel_init(&sg, DATA_TONE_FREQ, PLAN_SAMPLE_RATE, HOP_SIZE, HOPS_PER_FRAME);
+
+        // Pieces that end anywhere in a hop, as ADC frames and echoes do
+        count = 0;
+        for (fed = 0; fed < STREAM_SAMPLES; fed += piece) {
+            piece = 1 + rng() % (2 * HOP_SIZE);
+            if (piece > STREAM_SAMPLES - fed)
+                piece = STREAM_SAMPLES - fed;
+            count += sliding_goertzel_update(&sg, data + fed, piece, trace + count);
+        }
+
+        full = (int)reference_energy(data, STREAM_SAMPLES, DATA_TONE_FREQ);
+        for (i = 0; i < count; i++) {
+            ref = reference_energy(data, (i + 1) * HOP_SIZE, DATA_TONE_FREQ);
+            err = fabs(trace[i] - ref) / full;
+            if (err > worst)
+                worst = err;
+        }
+
+        // The first window that holds a whole frame of the tone
+        edge = sliding_goertzel_edge(trace, count, full / 16);
+        window = (edge < 0 || edge + HOPS_PER_FRAME >= count) ? -1 : sliding_goertzel_align(trace, edge, HOPS_PER_FRAME);
+        found = (long)(window + 1) * HOP_SIZE - NUM_SAMPLES;
+        if (window < 0 || labs(found - starts[k]) > HOP_SIZE / 2) {
+            printf("  tone from sample %d found from %ld\n", starts[k], found);
+            wrong++;
+        }
+    }
+
+    printf("sliding %d start offsets, energy at most %.4f%% of the tone off the DFT, %d aligned wrong\n",
+        (int)(sizeof(starts) / sizeof(starts[0])), 100 * worst, wrong);
+    failures += (worst > 0.001 || wrong != 0);
+}
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "usage: %s\n", name);
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    if (getopt(argc, argv, "h") != -1)
+        usage(argv[0]);
+
+    check_bank();
+    check_bank16();
+    check_mfsk();
+    check_sliding();
+
+    printf("%s\n", failures ? "FAILED" : "passed");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,217 @@
+//*****************************************************************************
+//
+// fec_test.c - Bit error rate of the error correcting codes against Eb/N0
+//
+// Random bytes are encoded with each code and sent over a simulated OOK
+// channel: a channel bit of 1 puts a carrier into the detector bin, a 0
+// leaves only noise, and the bin power is turned into a soft value the way
+// the symbol synchronizer does it, from the mean power of ones and zeros.
+// Hard decisions are the same soft values pushed to the limits. Eb/N0 is
+// the carrier power over the bin noise power per data bit, so a code that
+// sends more channel bits per byte is charged for the extra time on air.
+// At the end the Eb/N0 each code needs for the target bit error rate is
+// listed with its gain over sending the bits uncoded.
+//
+// Build (from this directory):
+//   cc -O2 -I.. -o fec_test fec_test.c ../fec.c -lm
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "fec.h"
+
+#define NUM_CASES 5
+#define MESSAGE_BYTES 32
+#define SOFT_LEVEL 8
+
+//*****************************************************************************
+// One column of the table
+//*****************************************************************************
+struct test_case {
+    const char* name;
+    enum FEC_CODE code;
+    bool hard;
+    double rate;
+    double needed;              // Lowest Eb/N0 that reached the target
+};
+
+static struct test_case cases[NUM_CASES] = {
+    { "none", FEC_NONE, true, 1.0, 0 },
+    { "hamming hard", FEC_HAMMING, true, 4.0 / 7.0, 0 },
+    { "hamming soft", FEC_HAMMING, false, 4.0 / 7.0, 0 },
+    { "conv hard", FEC_CONVOLUTIONAL, true, 0.5, 0 },
+    { "conv soft", FEC_CONVOLUTIONAL, false, 0.5, 0 },
+};
+
+static uint64_t rng_state = 1;
+
+//*****************************************************************************
+// xorshift64 and Box-Muller, so every run sees the same noise
+//*****************************************************************************
+static double uniform(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return ((rng_state >> 11) + 0.5) / 9007199254740992.0;
+}
+
+static double gaussian(void)
+{
+    return sqrt(-2.0 * log(uniform())) * cos(2.0 * M_PI * uniform());
+}
+
+//*****************************************************************************
+// Detector bin power of one channel bit. Noise power in the bin is 1 and a
+// carrier adds snr, the carrier phase does not matter.
+//*****************************************************************************
+static double bin_power(int bit, double snr)
+{
+    double re = gaussian() * M_SQRT1_2, im = gaussian() * M_SQRT1_2;
+
+    if (bit)
+        re += sqrt(snr);
+    return re * re + im * im;
+}
+
+//*****************************************************************************
+// Soft value as the symbol synchronizer computes it, the levels of a one and
+// a zero are known from the start sequence
+//*****************************************************************************
+static int soft_value(double power, double snr, bool hard)
+{
+    double one = snr + 1.0, zero = 1.0;
+    int soft = (int)floor((2.0 * power - one - zero) * SOFT_LEVEL / (one - zero) + 0.5);
+
+    if (hard)
+        return (soft > 0) ? FEC_SOFT_MAX : -FEC_SOFT_MAX;
+    if (soft > FEC_SOFT_MAX)
+        return FEC_SOFT_MAX;
+    if (soft < -FEC_SOFT_MAX)
+        return -FEC_SOFT_MAX;
+    return soft;
+}
+
+//*****************************************************************************
+// Send one message of random bytes ended by the stop byte and count the data
+// bits that come back wrong or not at all
+//*****************************************************************************
+static int run_message(const struct test_case* test, double snr, long* bits_sent)
+{
+    struct fec_encoder enc;
+    struct fec_decoder dec;
+    uint8_t message[MESSAGE_BYTES + 1], channel[16], decoded[FEC_MAX_BITS];
+    int received[8 * (MESSAGE_BYTES + 1)];
+    int num_received = 0, num_channel, num_decoded, byte = 0, bit = 0, errors = 0, i = 0;
+
+    for (byte = 0; byte < MESSAGE_BYTES; byte++)
+        message[byte] = 1 + (int)(uniform() * 255);
+    message[MESSAGE_BYTES] = 0;
+
+    fec_encoder_init(&enc, test->code);
+    fec_decoder_init(&dec, test->code);
+
+    // The silence after the stop byte reads as more zero bytes
+    for (byte = 0; byte <= MESSAGE_BYTES + FEC_TRACEBACK / 8; byte++) {
+        num_channel = fec_encode_byte(&enc, (byte < MESSAGE_BYTES) ? message[byte] : 0, channel);
+        for (bit = 0; bit < num_channel; bit++) {
+            num_decoded = fec_decode(&dec, soft_value(bin_power(channel[bit], snr), snr, test->hard), decoded);
+            for (i = 0; i < num_decoded && num_received < 8 * (MESSAGE_BYTES + 1); i++)
+                received[num_received++] = decoded[i];
+        }
+    }
+
+    for (i = 0; i < 8 * MESSAGE_BYTES; i++)
+        errors += (i >= num_received) || received[i] != ((message[i / 8] >> (7 - i % 8)) & 1);
+    *bits_sent += 8 * MESSAGE_BYTES;
+
+    return errors;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "usage: fec_test [-l min_ebn0] [-h max_ebn0] [-s step] [-b bits] [-t target_ber] [-r seed]\n"
+        "  defaults: 4 to 20dB in 1dB steps, 200000 data bits per point, target 1e-4\n");
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    double min_ebn0 = 4, max_ebn0 = 20, step = 1, target = 1e-4, ebn0, snr, ber;
+    long num_bits = 200000, bits_sent;
+    long errors;
+    int opt, c = 0;
+
+    while ((opt = getopt(argc, argv, "l:h:s:b:t:r:")) != -1) {
+        switch (opt) {
+        case 'l':
+            min_ebn0 = atof(optarg);
+            break;
+        case 'h':
+            max_ebn0 = atof(optarg);
+            break;
+        case 's':
+            step = atof(optarg);
+            break;
+        case 'b':
+            num_bits = atol(optarg);
+            break;
+        case 't':
+            target = atof(optarg);
+            break;
+        case 'r':
+            rng_state = strtoull(optarg, NULL, 0) | 1;
+            break;
+        default:
+            usage();
+        }
+    }
+    if (step <= 0 || num_bits < 8 * MESSAGE_BYTES || target <= 0)
+        usage();
+
+    printf("bit error rate, %ld data bits per point\n", num_bits);
+    printf("Eb/N0");
+    for (c = 0; c < NUM_CASES; c++)
+        printf(" | %12s", cases[c].name);
+    printf("\n");
+
+    for (ebn0 = min_ebn0; ebn0 <= max_ebn0 + 1e-9; ebn0 += step) {
+        printf("%5.1f", ebn0);
+        for (c = 0; c < NUM_CASES; c++) {
+            // Channel bits get their share of the energy of a data bit
+            snr = pow(10.0, ebn0 / 10.0) * cases[c].rate;
+            errors = 0;
+            bits_sent = 0;
+            while (bits_sent < num_bits)
+                errors += run_message(&cases[c], snr, &bits_sent);
+
+            ber = (double)errors / bits_sent;
+            printf(" | %12.2e", ber);
+            if (ber <= target && !cases[c].needed)
+                cases[c].needed = ebn0;
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+
+    printf("\nEb/N0 for a bit error rate of %.0e\n", target);
+    for (c = 0; c < NUM_CASES; c++) {
+        if (!cases[c].needed)
+            printf("%12s  not reached\n", cases[c].name);
+        else if (!cases[0].needed)
+            printf("%12s  %5.1f dB\n", cases[c].name, cases[c].needed);
+        else
+            printf("%12s  %5.1f dB, %+.1f dB coding gain\n", cases[c].name, cases[c].needed, cases[0].needed - cases[c].needed);
+    }
+
+    return 0;
+}
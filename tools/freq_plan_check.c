@@ -0,0 +1,136 @@
+//*****************************************************************************
+//
+// freq_plan_check.c - Compare the compiled frequency plan with the run time
+// math
+//
+// The tables in freq_plan.c are worked out by the compiler from a Taylor
+// series. This lists every tone of the plan with its bin and Q14 Goertzel
+// coefficient and checks each table entry against
+//   ref        floor(x * 2^14 + 0.5) of the libm value in double precision
+//   runtime    goertzel_coeff() and sliding_goertzel_init(), which the
+//              decoder used before the tables and still uses for retuned
+//              carriers
+// Any entry that differs is printed and the exit status is 1. -v also lists
+// the hop rotations of the carriers.
+//
+// Build (from this directory):
+//   cc -O2 -I.. -o freq_plan_check freq_plan_check.c ../freq_plan.c
+//      ../goertzel.c ../sliding_goertzel.c -lm
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <unistd.h>
+#include "freq_plan.h"
+#include "goertzel.h"
+#include "sliding_goertzel.h"
+
+#define TWO_PI (2.0 * 3.14159265358979)
+
+static const char* tone_names[PLAN_NUM_TONES] = {
+#define PLAN_TONE_NAME(NAME, FREQ) #NAME,
+    PLAN_TONES(PLAN_TONE_NAME)
+#undef PLAN_TONE_NAME
+};
+
+static bool verbose;
+static int mismatches;
+
+static void usage(const char* name)
+{
+    fprintf(stderr, "usage: %s [-v]\n", name);
+    fprintf(stderr, "  -v  list the hop rotations of the carriers too\n");
+    exit(2);
+}
+
+static int32_t q14(double x)
+{
+    return (int32_t)floor(x * 16384.0 + 0.5);
+}
+
+static void check(const char* tone, const char* entry, int32_t table, int32_t ref, int32_t runtime)
+{
+    if (table == ref && table == runtime)
+        return;
+
+    printf("  %-6s %-10s table %6d  ref %6d  runtime %6d\n", tone, entry, (int)table, (int)ref, (int)runtime);
+    mismatches++;
+}
+
+//*****************************************************************************
+// Every value sliding_goertzel_load() gets for a carrier
+//*****************************************************************************
+static void check_carrier(const char* name, uint32_t freq, const struct plan_carrier* carrier)
+{
+    struct sliding_goertzel sg;
+    char entry[16];
+    double angle;
+    int slot = 0;
+
+    if (sliding_goertzel_init(&sg, freq, PLAN_SAMPLE_RATE, HOP_SIZE, HOPS_PER_FRAME) < 0) {
+        printf("  %-6s %u Hz is not on a bin\n", name, (unsigned)freq);
+        mismatches++;
+        return;
+    }
+
+    angle = TWO_PI * freq / PLAN_SAMPLE_RATE;
+    check(name, "coeff", carrier->coeff, q14(2.0 * cos(angle)), sg.coeff);
+    check(name, "cos_w", carrier->cos_w, q14(cos(angle)), sg.cos_w);
+    check(name, "sin_w", carrier->sin_w, q14(sin(angle)), sg.sin_w);
+
+    for (slot = 0; slot < HOPS_PER_FRAME; slot++) {
+        angle = TWO_PI * (double)(((uint64_t)freq * HOP_SIZE * slot) % PLAN_SAMPLE_RATE) / PLAN_SAMPLE_RATE;
+        sprintf(entry, "rot_re[%d]", slot);
+        check(name, entry, carrier->rot_re[slot], q14(cos(angle)), sg.rot_re[slot]);
+        sprintf(entry, "rot_im[%d]", slot);
+        check(name, entry, carrier->rot_im[slot], q14(-sin(angle)), sg.rot_im[slot]);
+        if (verbose)
+            printf("  %-6s slot %2d  %6d %6d\n", name, slot, (int)carrier->rot_re[slot], (int)carrier->rot_im[slot]);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int tone = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "vh")) != -1) {
+        switch (opt) {
+        case 'v':
+            verbose = true;
+            break;
+        default:
+            usage(argv[0]);
+        }
+    }
+    if (optind != argc)
+        usage(argv[0]);
+
+    printf("%u Hz, %d samples per frame (%u Hz bins), %d hops of %d\n\n", (unsigned)PLAN_SAMPLE_RATE, NUM_SAMPLES,
+        (unsigned)(PLAN_SAMPLE_RATE / NUM_SAMPLES), HOPS_PER_FRAME, HOP_SIZE);
+    printf("  %-6s %6s %4s %6s\n", "tone", "freq", "bin", "coeff");
+    for (tone = 0; tone < PLAN_NUM_TONES; tone++)
+        printf("  %-6s %6u %4d %6d\n", tone_names[tone], (unsigned)plan_freqs[tone], PLAN_BIN(plan_freqs[tone]),
+            (int)plan_coeffs[tone]);
+    printf("\n");
+
+    for (tone = 0; tone < PLAN_NUM_TONES; tone++)
+        check(tone_names[tone], "coeff", plan_coeffs[tone],
+            q14(2.0 * cos(TWO_PI * plan_freqs[tone] / PLAN_SAMPLE_RATE)),
+            goertzel_coeff(plan_freqs[tone], PLAN_SAMPLE_RATE));
+    check_carrier("DATA", DATA_TONE_FREQ, &plan_data_carrier);
+    check_carrier("SYNC", SYNC_TONE_FREQ, &plan_sync_carrier);
+
+    if (mismatches) {
+        printf("\n%d table entries differ\n", mismatches);
+        return 1;
+    }
+    printf("all table entries match\n");
+    return 0;
+}
@@ -0,0 +1,257 @@
+//*****************************************************************************
+//
+// goertzel_accuracy.c - Accuracy of the block floating point Goertzel
+//
+// Measures tones of known amplitude with goertzel_window() and goertzel()
+// and compares both with a double precision DFT of the same block, mean
+// taken off and window applied from its formula, on the frequency the Q14
+// coefficient actually tunes to. Amplitudes are in ADC counts:
+//   true     amplitude the tone was made with
+//   dft      2 |bin| / sum of the window weights, in double precision
+//   window   goertzel_window() with no window, the Hann or the Blackman table
+//   legacy   goertzel() power turned back into an amplitude (no window),
+//            "wrapped" where its power came out negative
+// and error columns against the DFT. Then times both kernels. With -S the
+// run fails if goertzel_window() is off the DFT by more than 0.2% plus
+// 0.02 counts anywhere.
+//
+// Build (from this directory):
+//   cc -O2 -I.. -o goertzel_accuracy goertzel_accuracy.c ../goertzel.c -lm
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "goertzel.h"
+
+#define SAMPLE_RATE 51200
+#define MAX_SIZE 16384
+#define TIMING_SIZE 1024
+
+enum WINDOW {
+    RECT,
+    HANN,
+    BLACKMAN,
+};
+
+struct test_case {
+    int sz;
+    int window;
+    int freq;               // detector
+    double tone_freq;       // tone measured
+    double amplitude;
+    double other_freq;      // a second tone, 0 for none
+    double other_amplitude;
+    int noise;              // uniform noise amplitude
+};
+
+static const struct test_case cases[] = {
+    { 1024, RECT, 20000, 20000, 1000, 0, 0, 0 },
+    { 1024, RECT, 20000, 20000, 100, 0, 0, 0 },
+    { 1024, RECT, 20000, 20000, 2, 0, 0, 0 },
+    { 1000, RECT, 21000, 21000, 500, 0, 0, 0 },
+    { 4096, RECT, 20000, 20000, 1500, 0, 0, 0 },
+    { 16384, RECT, 20000, 20000, 1800, 0, 0, 20 },
+    { 1024, HANN, 20000, 20000, 1000, 0, 0, 0 },
+    { 1536, HANN, 20000, 20000, 20, 0, 0, 5 },
+    { 3000, HANN, 18750, 18750, 700, 0, 0, 50 },
+    { 1024, BLACKMAN, 20000, 20000, 300, 0, 0, 0 },
+    { 1024, RECT, 20150, 20150, 3, 19880, 1500, 0 },
+    { 1024, HANN, 20150, 20150, 3, 19880, 1500, 0 },
+    { 1024, BLACKMAN, 20150, 20150, 3, 19880, 1500, 0 },
+};
+
+#define NUM_CASES (sizeof(cases) / sizeof(cases[0]))
+
+static const char* window_names[] = { "none", "hann", "blackman" };
+static const int16_t* window_tables[] = { NULL, goertzel_hann, goertzel_blackman };
+
+static uint32_t rng_state;
+
+//*****************************************************************************
+// xorshift32, so every run sees the same blocks
+//*****************************************************************************
+static uint32_t rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static int noise(int amplitude)
+{
+    return amplitude ? (int)(rng() % (2 * amplitude + 1)) - amplitude : 0;
+}
+
+//*****************************************************************************
+// A block of ADC readings: DC biased, the tones plus uniform noise, clipped
+// to 12 bits
+//*****************************************************************************
+static void make_block(const struct test_case* c, int16_t* data)
+{
+    double value;
+    int i = 0, sample = 0;
+
+    for (i = 0; i < c->sz; i++) {
+        value = 2048 + c->amplitude * sin(2 * M_PI * c->tone_freq * i / SAMPLE_RATE + 0.3);
+        if (c->other_freq)
+            value += c->other_amplitude * sin(2 * M_PI * c->other_freq * i / SAMPLE_RATE + 1.1);
+        sample = (int)floor(value + 0.5) + noise(c->noise);
+        data[i] = (sample < 0) ? 0 : (sample > 4095) ? 4095 : sample;
+    }
+}
+
+static double window_weight(int window, int i, int sz)
+{
+    double x = 2 * M_PI * i / sz;
+
+    if (window == HANN)
+        return 0.5 - 0.5 * cos(x);
+    if (window == BLACKMAN)
+        return 0.42 - 0.5 * cos(x) + 0.08 * cos(2 * x);
+
+    return 1;
+}
+
+static double reference_amplitude(const int16_t* data, int sz, int coeff, int window)
+{
+    double w = acos(coeff / 32768.0), mean = 0, re = 0, im = 0, gain = 0, value;
+    int i = 0;
+
+    for (i = 0; i < sz; i++)
+        mean += data[i];
+    mean /= sz;
+
+    for (i = 0; i < sz; i++) {
+        value = (data[i] - mean) * window_weight(window, i, sz);
+        re += value * cos(w * i);
+        im -= value * sin(w * i);
+        gain += window_weight(window, i, sz);
+    }
+
+    return 2 * sqrt(re * re + im * im) / gain;
+}
+
+//*****************************************************************************
+// goertzel() is power / 512 of the readings shifted down by 4. A state that
+// wrapped can leave it negative, then this is -1.
+//*****************************************************************************
+static double legacy_amplitude(int16_t* data, int sz, int coeff)
+{
+    int power = goertzel(data, sz, coeff);
+
+    return (power < 0) ? -1 : 2 * 16 * sqrt(512.0 * power) / sz;
+}
+
+static double seconds(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+//*****************************************************************************
+// Time per sample of a kernel on one block
+//*****************************************************************************
+static double time_kernel(int16_t* data, int coeff, int window, double min_time)
+{
+    volatile int32_t sink = 0;
+    unsigned long passes = 0;
+    double start = seconds(), elapsed;
+
+    do {
+        if (window < 0)
+            sink += goertzel(data, TIMING_SIZE, coeff);
+        else
+            sink += goertzel_window(data, TIMING_SIZE, coeff, window_tables[window]);
+        passes++;
+        elapsed = seconds() - start;
+    } while (elapsed < min_time);
+
+    return elapsed * 1e9 / ((double)passes * TIMING_SIZE);
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "usage: goertzel_accuracy [-t seconds] [-S]\n"
+        "  -t  minimum timing run per kernel (default 0.2)\n"
+        "  -S  self-test, fail if goertzel_window() is off the DFT\n");
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    static int16_t data[MAX_SIZE];
+    const struct test_case* c;
+    double ref, measured, legacy, err, allowed, min_time = 0.2;
+    bool self_test = false;
+    int opt, coeff, failures = 0;
+    unsigned k = 0;
+
+    while ((opt = getopt(argc, argv, "t:Sh")) != -1) {
+        switch (opt) {
+        case 't':
+            min_time = atof(optarg);
+            break;
+        case 'S':
+            self_test = true;
+            break;
+        default:
+            usage();
+        }
+    }
+
+    printf("%6s %-8s %6s %6s %8s %10s %10s %8s %10s %9s\n", "size", "window", "freq", "other", "true", "dft",
+        "window", "err", "legacy", "err");
+
+    rng_state = 0x2545F491;
+    for (k = 0; k < NUM_CASES; k++) {
+        c = &cases[k];
+        make_block(c, data);
+        coeff = goertzel_coeff(c->freq, SAMPLE_RATE);
+        ref = reference_amplitude(data, c->sz, coeff, c->window);
+        measured = goertzel_window(data, c->sz, coeff, window_tables[c->window]) / (double)(1 << GOERTZEL_AMPLITUDE_SHIFT);
+        err = measured - ref;
+        allowed = 0.002 * ref + 0.02;
+
+        printf("%6d %-8s %6d %6.0f %8.2f %10.3f %10.3f %+8.3f", c->sz, window_names[c->window], c->freq,
+            c->other_freq, c->amplitude, ref, measured, err);
+        if (c->window == RECT) {
+            legacy = legacy_amplitude(data, c->sz, coeff);
+            if (legacy < 0)
+                printf(" %10s %9s", "wrapped", "-");
+            else
+                printf(" %10.3f %+9.3f", legacy, legacy - ref);
+        } else {
+            printf(" %10s %9s", "-", "-");
+        }
+        printf("%s\n", (fabs(err) > allowed) ? "  FAIL" : "");
+        if (fabs(err) > allowed)
+            failures++;
+    }
+
+    if (self_test) {
+        printf("%s: %d of %u cases off the DFT\n", failures ? "FAIL" : "PASS", failures, (unsigned)NUM_CASES);
+        return failures ? 1 : 0;
+    }
+
+    rng_state = 0x2545F491;
+    make_block(&cases[0], data);
+    coeff = goertzel_coeff(cases[0].freq, SAMPLE_RATE);
+    printf("\n%d samples, ns/sample: goertzel %.3f, window none %.3f, hann %.3f, blackman %.3f\n", TIMING_SIZE,
+        time_kernel(data, coeff, -1, min_time), time_kernel(data, coeff, RECT, min_time),
+        time_kernel(data, coeff, HANN, min_time), time_kernel(data, coeff, BLACKMAN, min_time));
+
+    return failures ? 1 : 0;
+}
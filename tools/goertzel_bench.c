@@ -0,0 +1,374 @@
+//*****************************************************************************
+//
+// goertzel_bench.c - Cost and accuracy of the Goertzel kernels
+//
+// Runs the fixed point kernel and its candidate replacements over the same
+// fixed seed synthetic frames (and optionally frames from a recording) and
+// reports, per kernel and data set:
+//   ns/sample  time per input sample for all bins together
+//   Msamp/s    input samples per second for all bins together
+//   bins/frame bins that fit in one frame period of real time at this speed
+//   exact      outputs bit identical to goertzel()
+//   max err    worst |power - reference| relative to the strongest reference
+//              bin of the data set, the reference being a double precision
+//              Goertzel with the same Q14 coefficients and no input truncation
+// The run fails if the vectorized goertzel_bank16() differs from its scalar
+// version on any output.
+//
+// Build (from this directory):
+//   cc -O2 -I.. -o goertzel_bench goertzel_bench.c pcm_source.c ../goertzel.c -lm
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "goertzel.h"
+#include "pcm_source.h"
+
+#define FRAME_SIZE 1024
+#define NUM_FRAMES 64
+#define BIN_BASE_FREQ 18000
+#define BIN_SPACING 750
+
+typedef void (*kernel_fn)(const int16_t* data, int sz, const int* coeffs, int* power, int num_bins);
+
+struct kernel {
+    const char* name;
+    kernel_fn run;
+};
+
+struct data_set {
+    const char* name;
+    int16_t frames[NUM_FRAMES][FRAME_SIZE];
+    int num_frames;
+};
+
+static uint32_t rng_state;
+static int mismatches;
+
+//*****************************************************************************
+// xorshift32, so every run sees the same frames
+//*****************************************************************************
+static uint32_t rng(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static int noise(int amplitude)
+{
+    return amplitude ? (int)(rng() % (2 * amplitude + 1)) - amplitude : 0;
+}
+
+//*****************************************************************************
+// Kernels under test. All take ADC readings and return goertzel() scaled
+// power so they can be compared directly.
+//*****************************************************************************
+static void kernel_exact(const int16_t* data, int sz, const int* coeffs, int* power, int num_bins)
+{
+    int bin = 0;
+
+    for (bin = 0; bin < num_bins; bin++)
+        power[bin] = goertzel((int16_t*)data, sz, coeffs[bin]);
+}
+
+// Same arithmetic as goertzel(), two samples per iteration
+static void kernel_unrolled(const int16_t* data, int sz, const int* coeffs, int* power, int num_bins)
+{
+    int32_t delay_1, delay_2, coeff;
+    int prod1, prod2, prod3;
+    int i = 0, bin = 0;
+
+    for (bin = 0; bin < num_bins; bin++) {
+        delay_1 = delay_2 = 0;
+        coeff = coeffs[bin];
+        for (i = 0; i + 1 < sz; i += 2) {
+            delay_2 = (data[i] >> 4) + (short)((delay_1 * coeff) >> 14) - delay_2;
+            delay_1 = (data[i + 1] >> 4) + (short)((delay_2 * coeff) >> 14) - delay_1;
+        }
+        if (i < sz) {
+            prod1 = (data[i] >> 4) + (short)((delay_1 * coeff) >> 14) - delay_2;
+            delay_2 = delay_1;
+            delay_1 = prod1;
+        }
+
+        prod1 = (delay_1 * delay_1);
+        prod2 = (delay_2 * delay_2);
+        prod3 = (delay_1 * coeff) >> 14;
+        prod3 = prod3 * delay_2;
+        power[bin] = ((prod1 + prod2 - prod3) >> 15) << 6;
+    }
+}
+
+// No 16 bit truncation of the feedback term, 64 bit power
+static void kernel_wide(const int16_t* data, int sz, const int* coeffs, int* power, int num_bins)
+{
+    int32_t delay, delay_1, delay_2, coeff;
+    int64_t value;
+    int i = 0, bin = 0;
+
+    for (bin = 0; bin < num_bins; bin++) {
+        delay_1 = delay_2 = 0;
+        coeff = coeffs[bin];
+        for (i = 0; i < sz; i++) {
+            delay = (data[i] >> 4) + (int32_t)(((int64_t)delay_1 * coeff) >> 14) - delay_2;
+            delay_2 = delay_1;
+            delay_1 = delay;
+        }
+
+        value = (int64_t)delay_1 * delay_1 + (int64_t)delay_2 * delay_2
+            - (((int64_t)delay_1 * coeff) >> 14) * delay_2;
+        value = (value >> 15) << 6;
+        power[bin] = (value > INT32_MAX) ? INT32_MAX : (int)value;
+    }
+}
+
+static void kernel_float(const int16_t* data, int sz, const int* coeffs, int* power, int num_bins)
+{
+    float delay, delay_1, delay_2, coeff, value;
+    int i = 0, bin = 0;
+
+    for (bin = 0; bin < num_bins; bin++) {
+        delay_1 = delay_2 = 0;
+        coeff = coeffs[bin] / 16384.0f;
+        for (i = 0; i < sz; i++) {
+            delay = data[i] * (1.0f / 16) + coeff * delay_1 - delay_2;
+            delay_2 = delay_1;
+            delay_1 = delay;
+        }
+
+        value = (delay_1 * delay_1 + delay_2 * delay_2 - coeff * delay_1 * delay_2) * (64.0f / 32768);
+        power[bin] = (value > (float)INT32_MAX) ? INT32_MAX : (int)value;
+    }
+}
+
+static const struct kernel kernels[] = {
+    { "goertzel", kernel_exact },
+    { "unrolled", kernel_unrolled },
+    { "bank", goertzel_bank },
+    { "bank16", goertzel_bank16 },
+    { "bank16 C", goertzel_bank16_scalar },
+    { "wide", kernel_wide },
+    { "float", kernel_float },
+};
+
+#define NUM_KERNELS (sizeof(kernels) / sizeof(kernels[0]))
+
+static double reference_power(const int16_t* data, int sz, int coeff)
+{
+    double delay, delay_1 = 0, delay_2 = 0, c = coeff / 16384.0;
+    int i = 0;
+
+    for (i = 0; i < sz; i++) {
+        delay = data[i] / 16.0 + c * delay_1 - delay_2;
+        delay_2 = delay_1;
+        delay_1 = delay;
+    }
+
+    return (delay_1 * delay_1 + delay_2 * delay_2 - c * delay_1 * delay_2) * 64.0 / 32768.0;
+}
+
+//*****************************************************************************
+// Synthetic frames: DC biased like the ADC, tones on the given bins plus
+// uniform noise, clipped to 12 bits
+//*****************************************************************************
+static void make_tones(struct data_set* set, const char* name, const int* freqs, int num_freqs, int amplitude,
+    int noise_amplitude, uint32_t sample_rate)
+{
+    double value;
+    int frame = 0, i = 0, tone = 0, sample = 0;
+
+    set->name = name;
+    set->num_frames = NUM_FRAMES;
+    for (frame = 0; frame < NUM_FRAMES; frame++) {
+        for (i = 0; i < FRAME_SIZE; i++) {
+            value = 2048;
+            for (tone = 0; tone < num_freqs; tone++)
+                value += amplitude * sin(2 * M_PI * freqs[tone] * ((double)frame * FRAME_SIZE + i) / sample_rate);
+            sample = (int)floor(value + 0.5) + noise(noise_amplitude);
+            set->frames[frame][i] = (sample < 0) ? 0 : (sample > 4095) ? 4095 : sample;
+        }
+    }
+}
+
+static int load_recording(struct data_set* set, const char* path, uint32_t* sample_rate)
+{
+    struct pcm_source src;
+
+    if (pcm_open(&src, path, FORMAT_S16, *sample_rate))
+        return -1;
+
+    *sample_rate = src.sample_rate;
+    set->name = "recording";
+    set->num_frames = 0;
+    while (set->num_frames < NUM_FRAMES
+        && pcm_read_frame(&src, 0, set->frames[set->num_frames], FRAME_SIZE) == FRAME_SIZE)
+        set->num_frames++;
+    pcm_close(&src);
+
+    if (!set->num_frames) {
+        fprintf(stderr, "%s: shorter than one frame\n", path);
+        return -1;
+    }
+
+    return 0;
+}
+
+static double seconds(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void run_set(const struct data_set* set, const int* coeffs, int num_bins, double min_time, uint32_t sample_rate)
+{
+    static double reference[NUM_FRAMES][GOERTZEL_MAX_BINS];
+    static int exact[NUM_FRAMES][GOERTZEL_MAX_BINS];
+    int power[GOERTZEL_MAX_BINS], scalar[GOERTZEL_MAX_BINS];
+    double start, elapsed, ns, strongest, err, max_err;
+    double frame_ns = 1e9 * FRAME_SIZE / sample_rate;
+    unsigned long passes, same, total;
+    volatile int sink = 0;
+    unsigned k = 0;
+    int frame = 0, bin = 0;
+
+    strongest = 1;
+    for (frame = 0; frame < set->num_frames; frame++) {
+        kernel_exact(set->frames[frame], FRAME_SIZE, coeffs, exact[frame], num_bins);
+        for (bin = 0; bin < num_bins; bin++) {
+            reference[frame][bin] = reference_power(set->frames[frame], FRAME_SIZE, coeffs[bin]);
+            if (reference[frame][bin] > strongest)
+                strongest = reference[frame][bin];
+        }
+    }
+
+    printf("\n%s (%d frames)\n", set->name, set->num_frames);
+    printf("  %-10s %10s %10s %11s %8s %10s\n", "kernel", "ns/sample", "Msamp/s", "bins/frame", "exact", "max err");
+
+    for (k = 0; k < NUM_KERNELS; k++) {
+        same = total = 0;
+        max_err = 0;
+        for (frame = 0; frame < set->num_frames; frame++) {
+            kernels[k].run(set->frames[frame], FRAME_SIZE, coeffs, power, num_bins);
+            for (bin = 0; bin < num_bins; bin++) {
+                same += (power[bin] == exact[frame][bin]);
+                total++;
+                err = fabs(power[bin] - reference[frame][bin]) / strongest;
+                if (err > max_err)
+                    max_err = err;
+            }
+        }
+
+        passes = 0;
+        start = seconds();
+        do {
+            for (frame = 0; frame < set->num_frames; frame++) {
+                kernels[k].run(set->frames[frame], FRAME_SIZE, coeffs, power, num_bins);
+                sink += power[0];
+            }
+            passes++;
+            elapsed = seconds() - start;
+        } while (elapsed < min_time);
+
+        ns = elapsed * 1e9 / ((double)passes * set->num_frames * FRAME_SIZE);
+        printf("  %-10s %10.3f %10.2f %11.0f %7.2f%% %10.2e\n", kernels[k].name, ns, 1e3 / ns,
+            frame_ns / (ns * FRAME_SIZE / num_bins), 100.0 * same / total, max_err);
+    }
+
+    // The vector bank has to agree with its portable version bit for bit
+    same = total = 0;
+    for (frame = 0; frame < set->num_frames; frame++) {
+        goertzel_bank16(set->frames[frame], FRAME_SIZE, coeffs, power, num_bins);
+        goertzel_bank16_scalar(set->frames[frame], FRAME_SIZE, coeffs, scalar, num_bins);
+        for (bin = 0; bin < num_bins; bin++) {
+            same += (power[bin] == scalar[bin]);
+            total++;
+        }
+    }
+    printf("  bank16 matches bank16 C on %lu of %lu outputs%s\n", same, total, (same == total) ? "" : " - MISMATCH");
+    if (same != total)
+        mismatches++;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "usage: goertzel_bench [-n bins] [-t seconds] [-r rate] [-w recording]\n"
+        "  -n  bins evaluated per frame, %d Hz apart from %d Hz (default 8, max %d)\n"
+        "  -t  minimum timing run per kernel and data set (default 0.2)\n"
+        "  -r  sampling rate (default 51200, WAV files carry their own)\n"
+        "  -w  also run over the first %d frames of a recording\n",
+        BIN_SPACING, BIN_BASE_FREQ, GOERTZEL_MAX_BINS, NUM_FRAMES);
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    static struct data_set set;
+    int coeffs[GOERTZEL_MAX_BINS];
+    int freqs[2];
+    uint32_t sample_rate = 51200;
+    const char* recording = NULL;
+    double min_time = 0.2;
+    int opt, num_bins = 8, bin = 0;
+
+    while ((opt = getopt(argc, argv, "n:t:r:w:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            num_bins = atoi(optarg);
+            break;
+        case 't':
+            min_time = atof(optarg);
+            break;
+        case 'r':
+            sample_rate = strtoul(optarg, NULL, 0);
+            break;
+        case 'w':
+            recording = optarg;
+            break;
+        default:
+            usage();
+        }
+    }
+    if (num_bins < 1 || num_bins > GOERTZEL_MAX_BINS || !sample_rate)
+        usage();
+
+    // The recording decides the sampling rate the coefficients are made for
+    if (recording && load_recording(&set, recording, &sample_rate))
+        return 1;
+
+    for (bin = 0; bin < num_bins; bin++)
+        coeffs[bin] = goertzel_coeff(BIN_BASE_FREQ + bin * BIN_SPACING, sample_rate);
+    freqs[0] = BIN_BASE_FREQ;
+    freqs[1] = BIN_BASE_FREQ + (num_bins / 2) * BIN_SPACING;
+
+    printf("%d bins, %d sample frames at %u Hz (%.1f ms)\n", num_bins, FRAME_SIZE, sample_rate,
+        1e3 * FRAME_SIZE / sample_rate);
+
+    if (recording)
+        run_set(&set, coeffs, num_bins, min_time, sample_rate);
+
+    rng_state = 0x2545F491;
+    make_tones(&set, "quiet tones", freqs, 2, 100, 20, sample_rate);
+    run_set(&set, coeffs, num_bins, min_time, sample_rate);
+
+    make_tones(&set, "loud tones", freqs, 2, 900, 20, sample_rate);
+    run_set(&set, coeffs, num_bins, min_time, sample_rate);
+
+    make_tones(&set, "noise", freqs, 0, 0, 2047, sample_rate);
+    run_set(&set, coeffs, num_bins, min_time, sample_rate);
+
+    return mismatches ? 1 : 0;
+}
@@ -0,0 +1,266 @@
+//*****************************************************************************
+//
+// packet_fuzz.c - Check the packet parser and CRCs against random input
+//
+// The CRCs are checked against their standard check values first. Then
+// random packets (any flags, any length, binary payloads) are built and fed
+// to the parser a byte at a time: each must come back whole on its last byte
+// and not before. The same packets are sent again with 1 to 3 bits flipped
+// after the sync word, and none of those may be accepted unless a flip hit
+// the length, which moves the CRC. Last the parser is fed random bytes with
+// packets mixed in, which must not break it and should almost never produce
+// a packet that was not sent.
+//
+// Build (from this directory):
+//   cc -O2 -I.. -o packet_fuzz packet_fuzz.c ../packet.c
+// or as a libFuzzer target:
+//   clang -g -O1 -fsanitize=fuzzer,address -DLIBFUZZER -I.. -o packet_fuzz
+//      packet_fuzz.c ../packet.c
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "packet.h"
+
+//*****************************************************************************
+// Whatever the input, the parser must stay inside its buffers
+//*****************************************************************************
+static int check_invariants(const struct packet_parser* parser)
+{
+    if (parser->field == PACKET_PAYLOAD && parser->count >= parser->length)
+        return 1;
+    if (parser->field == PACKET_CRC && parser->count >= 4)
+        return 1;
+    return parser->field > PACKET_CRC;
+}
+
+#ifdef LIBFUZZER
+
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size)
+{
+    static struct packet_parser parser;
+    size_t i = 0;
+
+    packet_parser_init(&parser);
+    for (i = 0; i < size; i++) {
+        packet_parser_push(&parser, data[i]);
+        if (check_invariants(&parser))
+            abort();
+    }
+
+    return 0;
+}
+
+#else
+
+static uint64_t rng_state = 1;
+
+static uint32_t random32(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t)(rng_state >> 32);
+}
+
+//*****************************************************************************
+// A random packet, returns its size
+//*****************************************************************************
+static int random_packet(uint8_t* out, uint8_t* payload, int* length, uint8_t* flags)
+{
+    int i = 0;
+
+    *flags = random32() & PACKET_FLAGS_KNOWN;
+    *length = random32() % (PACKET_MAX_PAYLOAD + 1);
+    for (i = 0; i < *length; i++)
+        payload[i] = (random32() & 3) ? (uint8_t)random32() : 0;
+
+    return packet_build(out, *flags, (uint8_t)random32(), (uint8_t)random32(), payload, *length);
+}
+
+static int check_crcs(void)
+{
+    const uint8_t check[] = "123456789";
+    uint16_t crc16 = crc16_update(0xFFFF, check, 9);
+    uint32_t crc32 = ~crc32_update(0xFFFFFFFF, check, 9);
+    int errors = 0;
+
+    if (crc16 != 0x29B1) {
+        printf("CRC-16 of \"123456789\" is %04x, expected 29b1\n", crc16);
+        errors++;
+    }
+    if (crc32 != 0xCBF43926) {
+        printf("CRC-32 of \"123456789\" is %08x, expected cbf43926\n", crc32);
+        errors++;
+    }
+
+    return errors;
+}
+
+//*****************************************************************************
+// Build and parse clean packets
+//*****************************************************************************
+static int check_round_trip(struct packet_parser* parser, int count)
+{
+    uint8_t packet[PACKET_MAX_SIZE], payload[PACKET_MAX_PAYLOAD], flags;
+    enum PACKET_STATUS status;
+    int size, length, errors = 0, n = 0, i = 0;
+
+    for (n = 0; n < count; n++) {
+        size = random_packet(packet, payload, &length, &flags);
+        packet_parser_start(parser);
+        for (i = 0; i < size; i++) {
+            status = packet_parser_push(parser, packet[i]);
+            if (status != ((i == size - 1) ? PACKET_OK : PACKET_INCOMPLETE))
+                break;
+        }
+
+        if (i != size || parser->length != length || parser->flags != flags
+            || parser->sequence != packet[4] || memcmp(parser->payload, payload, length)
+            || ((flags & PACKET_FLAG_RATE) && parser->rate != packet[5])) {
+            if (errors++ < 10)
+                printf("packet %d (flags %x, %d bytes) came back wrong at byte %d of %d\n", n, flags, length, i, size);
+        }
+    }
+
+    return errors;
+}
+
+//*****************************************************************************
+// Flip bits after the sync word, the parser has to reject the packet. Bytes
+// after the end are random in case the length grew.
+//*****************************************************************************
+static int check_corruption(struct packet_parser* parser, int count, long* undetected_length)
+{
+    uint8_t packet[PACKET_MAX_SIZE], payload[PACKET_MAX_PAYLOAD], flags;
+    enum PACKET_STATUS status = PACKET_INCOMPLETE;
+    int picked[3], size, length, flips, bit, errors = 0, n = 0, i = 0;
+    bool length_hit;
+
+    for (n = 0; n < count; n++) {
+        size = random_packet(packet, payload, &length, &flags);
+        flips = 1 + random32() % 3;
+        length_hit = false;
+        for (i = 0; i < flips; i++) {
+            // Distinct bits, flipping one twice would undo it
+            do {
+                bit = 16 + random32() % ((size - 2) * 8);
+            } while ((i > 0 && bit == picked[0]) || (i > 1 && bit == picked[1]));
+            picked[i] = bit;
+            packet[bit / 8] ^= 1 << (bit % 8);
+            length_hit = length_hit || bit / 8 == 3;
+        }
+
+        packet_parser_start(parser);
+        for (i = 0; status == PACKET_INCOMPLETE || i == 0; i++) {
+            status = packet_parser_push(parser, (i < size) ? packet[i] : (uint8_t)random32());
+            if (check_invariants(parser)) {
+                printf("parser state out of range after byte %d\n", i);
+                return errors + 1;
+            }
+        }
+
+        if (status == PACKET_OK) {
+            if (length_hit)
+                (*undetected_length)++;
+            else if (errors++ < 10)
+                printf("packet %d with %d bit(s) flipped was accepted\n", n, flips);
+        }
+        status = PACKET_INCOMPLETE;
+    }
+
+    return errors;
+}
+
+//*****************************************************************************
+// Random bytes with packets mixed in. Returns the number of packets accepted
+// that were not sent.
+//*****************************************************************************
+static long check_garbage(struct packet_parser* parser, long count, long* sent, long* received)
+{
+    uint8_t packet[PACKET_MAX_SIZE], payload[PACKET_MAX_PAYLOAD], flags;
+    int size = 0, position = 0, length;
+    long false_packets = 0, n = 0;
+    bool sending = false;
+
+    packet_parser_init(parser);
+    for (n = 0; n < count; n++) {
+        if (!sending && !(random32() % 512)) {
+            size = random_packet(packet, payload, &length, &flags);
+            position = 0;
+            sending = true;
+            packet_parser_start(parser);
+            (*sent)++;
+        }
+
+        if (packet_parser_push(parser, sending ? packet[position] : (uint8_t)random32()) == PACKET_OK) {
+            if (sending && position == size - 1)
+                (*received)++;
+            else
+                false_packets++;
+        }
+        if (check_invariants(parser)) {
+            printf("parser state out of range after %ld random bytes\n", n);
+            return false_packets + 1;
+        }
+
+        if (sending && ++position == size)
+            sending = false;
+    }
+
+    return false_packets;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "usage: packet_fuzz [-n packets] [-g garbage_bytes] [-r seed]\n"
+        "  defaults: 100000 packets, 10000000 random bytes\n");
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    static struct packet_parser parser;
+    long num_garbage = 10000000, undetected_length = 0, sent = 0, received = 0, false_packets;
+    int opt, num_packets = 100000, errors = 0;
+
+    while ((opt = getopt(argc, argv, "n:g:r:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            num_packets = atoi(optarg);
+            break;
+        case 'g':
+            num_garbage = atol(optarg);
+            break;
+        case 'r':
+            rng_state = strtoull(optarg, NULL, 0) | 1;
+            break;
+        default:
+            usage();
+        }
+    }
+
+    packet_parser_init(&parser);
+    errors += check_crcs();
+    errors += check_round_trip(&parser, num_packets);
+    errors += check_corruption(&parser, num_packets, &undetected_length);
+    false_packets = check_garbage(&parser, num_garbage, &sent, &received);
+
+    printf("%d packets round trip and corrupted, %ld accepted with a damaged length\n", num_packets, undetected_length);
+    printf("%ld random bytes: %ld of %ld packets received, %ld false packets\n", num_garbage, received, sent, false_packets);
+    printf("parser counted %u packets, %u without sync word, %u bad header, %u bad CRC\n",
+        parser.packets, parser.sync_errors, parser.header_errors, parser.crc_errors);
+    printf("%d errors\n", errors);
+
+    return errors ? 1 : 0;
+}
+
+#endif // LIBFUZZER
@@ -0,0 +1,117 @@
+//*****************************************************************************
+//
+// pcm_sink.c - WAV writer for recordings made or rebuilt on a PC
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "pcm_sink.h"
+
+#define HEADER_SIZE 44
+#define CHUNK_SAMPLES 1024
+
+static void put16(uint8_t* p, uint32_t value)
+{
+    p[0] = (uint8_t)value;
+    p[1] = (uint8_t)(value >> 8);
+}
+
+static void put32(uint8_t* p, uint32_t value)
+{
+    put16(p, value);
+    put16(p + 2, value >> 16);
+}
+
+static int write_header(struct pcm_sink* sink, uint32_t data_size)
+{
+    uint8_t header[HEADER_SIZE];
+
+    memcpy(header, "RIFF", 4);
+    put32(header + 4, data_size + HEADER_SIZE - 8);
+    memcpy(header + 8, "WAVEfmt ", 8);
+    put32(header + 16, 16);
+    put16(header + 20, 1);
+    put16(header + 22, sink->channels);
+    put32(header + 24, sink->sample_rate);
+    put32(header + 28, sink->sample_rate * sink->channels * 2);
+    put16(header + 32, sink->channels * 2);
+    put16(header + 34, 16);
+    memcpy(header + 36, "data", 4);
+    put32(header + 40, data_size);
+
+    return (fwrite(header, 1, HEADER_SIZE, sink->stream) == HEADER_SIZE) ? 0 : -1;
+}
+
+int pcm_create(struct pcm_sink* sink, const char* path, uint32_t sample_rate, int channels)
+{
+    memset(sink, 0, sizeof(*sink));
+    sink->channels = channels;
+    sink->sample_rate = sample_rate;
+
+    if (!path || !strcmp(path, "-")) {
+        sink->stream = stdout;
+    } else {
+        sink->stream = fopen(path, "wb");
+        if (!sink->stream) {
+            perror(path);
+            return -1;
+        }
+    }
+
+    // Sizes as large as they can be, in case the stream can't seek back
+    return write_header(sink, 0xFFFFFFFFu - HEADER_SIZE);
+}
+
+int pcm_write(struct pcm_sink* sink, const int16_t* samples, int frames)
+{
+    uint8_t bytes[2 * CHUNK_SAMPLES];
+    int total = frames * sink->channels, count, i = 0;
+
+    while (total > 0) {
+        count = (total < CHUNK_SAMPLES) ? total : CHUNK_SAMPLES;
+        for (i = 0; i < count; i++)
+            put16(bytes + 2 * i, (uint16_t)samples[i]);
+        if (fwrite(bytes, 2, count, sink->stream) != (size_t)count)
+            return -1;
+        samples += count;
+        total -= count;
+    }
+    sink->frames += frames;
+
+    return frames;
+}
+
+int pcm_write_adc(struct pcm_sink* sink, const int16_t* readings, int frames)
+{
+    int16_t samples[CHUNK_SAMPLES];
+    int count, done = 0, i = 0;
+
+    while (done < frames) {
+        count = (frames - done < CHUNK_SAMPLES) ? frames - done : CHUNK_SAMPLES;
+        for (i = 0; i < count; i++)
+            samples[i] = (int16_t)((readings[done + i] - 2048) * 16);
+        if (pcm_write(sink, samples, count) != count)
+            return -1;
+        done += count;
+    }
+
+    return frames;
+}
+
+int pcm_finish(struct pcm_sink* sink)
+{
+    int result = 0;
+
+    if (sink->stream != stdout && !fseek(sink->stream, 0, SEEK_SET))
+        result = write_header(sink, sink->frames * sink->channels * 2);
+    if (sink->stream == stdout)
+        result = fflush(stdout) ? -1 : result;
+    else if (fclose(sink->stream))
+        result = -1;
+
+    return result;
+}
@@ -0,0 +1,48 @@
+//*****************************************************************************
+//
+// pcm_sink.h - WAV writer for recordings made or rebuilt on a PC
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#ifndef PCM_SINK_H_
+#define PCM_SINK_H_
+
+#include <stdint.h>
+#include <stdio.h>
+
+//*****************************************************************************
+// 16 bit PCM WAV output. The header is written with the sizes filled in at
+// pcm_finish(), or left at their maximum when the output can't seek (stdout).
+//*****************************************************************************
+struct pcm_sink {
+    FILE* stream;
+    int channels;
+    uint32_t sample_rate;
+    uint32_t frames;                    // Samples per channel written
+};
+
+//*****************************************************************************
+// Create a WAV file (NULL or "-" for stdout). Returns -1 with a message on
+// stderr.
+//*****************************************************************************
+int pcm_create(struct pcm_sink* sink, const char* path, uint32_t sample_rate, int channels);
+
+//*****************************************************************************
+// Write frames samples per channel, interleaved signed 16 bit
+//*****************************************************************************
+int pcm_write(struct pcm_sink* sink, const int16_t* samples, int frames);
+
+//*****************************************************************************
+// Write 12 bit ADC readings of a mono sink, scaled the way pcm_read_frame()
+// scales them back, so they come out of FORMAT_S16 input unchanged
+//*****************************************************************************
+int pcm_write_adc(struct pcm_sink* sink, const int16_t* readings, int frames);
+
+//*****************************************************************************
+// Fill in the sizes and close. Returns -1 if anything failed to be written.
+//*****************************************************************************
+int pcm_finish(struct pcm_sink* sink);
+
+#endif // PCM_SINK_H_
@@ -0,0 +1,184 @@
+//*****************************************************************************
+//
+// pcm_source.c - Frame reader for WAV and raw sample recordings
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "pcm_source.h"
+
+static size_t source_read(struct pcm_source* src, void* buf, size_t len)
+{
+    if (src->map) {
+        if (len > src->map_size - src->map_pos)
+            len = src->map_size - src->map_pos;
+        memcpy(buf, src->map + src->map_pos, len);
+        src->map_pos += len;
+        return len;
+    }
+
+    return fread(buf, 1, len, src->stream);
+}
+
+static uint32_t le32(const uint8_t* p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+//*****************************************************************************
+// Skip a RIFF/WAVE header if there is one and take the format and the length
+// of the data from it. Leaves the source positioned on the first sample. A
+// data chunk of length 0xFFFFFFFF, as written by streaming recorders, runs to
+// the end of the input.
+//*****************************************************************************
+static int parse_header(struct pcm_source* src)
+{
+    uint8_t chunk[8], fmt[16];
+    uint32_t size;
+
+    src->pending_len = source_read(src, src->pending, 12);
+    if (src->pending_len < 12 || memcmp(src->pending, "RIFF", 4) || memcmp(src->pending + 8, "WAVE", 4))
+        return 0;
+    src->pending_len = 0;
+
+    while (source_read(src, chunk, 8) == 8) {
+        size = le32(chunk + 4);
+        if (!memcmp(chunk, "data", 4)) {
+            if (size != 0xFFFFFFFFu)
+                src->data_left = size;
+            return 0;
+        }
+
+        if (!memcmp(chunk, "fmt ", 4) && size >= 16) {
+            source_read(src, fmt, 16);
+            if ((fmt[0] | (fmt[1] << 8)) != 1 || (fmt[14] | (fmt[15] << 8)) != 16) {
+                fprintf(stderr, "only 16 bit PCM WAV files are supported\n");
+                return -1;
+            }
+            src->channels = fmt[2] | (fmt[3] << 8);
+            src->sample_rate = le32(fmt + 4);
+            size -= 16;
+        }
+
+        // Chunks are padded to an even length
+        size += size & 1;
+        if (src->map) {
+            src->map_pos += (size < src->map_size - src->map_pos) ? size : src->map_size - src->map_pos;
+        } else {
+            while (size--) {
+                if (source_read(src, chunk, 1) != 1)
+                    break;
+            }
+        }
+    }
+
+    fprintf(stderr, "WAV file has no data chunk\n");
+    return -1;
+}
+
+int pcm_open(struct pcm_source* src, const char* path, enum SAMPLE_FORMAT format, uint32_t sample_rate)
+{
+    struct stat st;
+
+    memset(src, 0, sizeof(*src));
+    src->fd = -1;
+    src->channels = 1;
+    src->sample_rate = sample_rate;
+    src->format = format;
+    src->data_left = (size_t)-1;
+
+    if (!path || !strcmp(path, "-")) {
+        src->stream = stdin;
+    } else {
+        src->fd = open(path, O_RDONLY);
+        if (src->fd < 0 || fstat(src->fd, &st)) {
+            perror(path);
+            pcm_close(src);
+            return -1;
+        }
+
+        // Empty files can't be mapped, they simply have no frames
+        src->map_size = st.st_size;
+        if (src->map_size) {
+            src->map = mmap(NULL, src->map_size, PROT_READ, MAP_PRIVATE, src->fd, 0);
+            if (src->map == MAP_FAILED) {
+                perror(path);
+                src->map = NULL;
+                pcm_close(src);
+                return -1;
+            }
+            madvise((void*)src->map, src->map_size, MADV_SEQUENTIAL);
+        }
+    }
+
+    if (parse_header(src)) {
+        pcm_close(src);
+        return -1;
+    }
+
+    if (src->channels < 1 || src->channels > PCM_MAX_CHANNELS) {
+        fprintf(stderr, "%s: %d channels, at most %d are supported\n", path ? path : "stdin", src->channels, PCM_MAX_CHANNELS);
+        pcm_close(src);
+        return -1;
+    }
+
+    return 0;
+}
+
+int pcm_read_frame(struct pcm_source* src, int channel, int16_t* frame, int frames)
+{
+    uint8_t raw[1024 * 2 * PCM_MAX_CHANNELS];
+    size_t stride = 2 * src->channels, want, got, n;
+    int16_t sample;
+    int done = 0, i = 0;
+
+    while (done < frames) {
+        want = (size_t)(frames - done) * stride;
+        if (want > sizeof(raw))
+            want = sizeof(raw) - sizeof(raw) % stride;
+        if (want > src->data_left)
+            want = src->data_left;
+
+        // Bytes already consumed while looking for a header belong to the data,
+        // what doesn't fit this call stays for the next
+        got = (src->pending_len < want) ? src->pending_len : want;
+        memcpy(raw, src->pending, got);
+        src->pending_len -= got;
+        memmove(src->pending, src->pending + got, src->pending_len);
+        while (got < want) {
+            n = source_read(src, raw + got, want - got);
+            if (!n)
+                break;
+            got += n;
+        }
+        src->data_left -= got;
+
+        for (i = 0; i < (int)(got / stride); i++) {
+            memcpy(&sample, raw + i * stride + channel * 2, 2);
+            frame[done++] = (src->format == FORMAT_S16) ? (sample >> 4) + 2048 : sample;
+        }
+
+        if (got < want || !src->data_left)
+            break;
+    }
+
+    return done;
+}
+
+void pcm_close(struct pcm_source* src)
+{
+    if (src->map)
+        munmap((void*)src->map, src->map_size);
+    if (src->fd >= 0)
+        close(src->fd);
+    src->map = NULL;
+    src->fd = -1;
+}
@@ -0,0 +1,60 @@
+//*****************************************************************************
+//
+// pcm_source.h - Frame reader for WAV and raw sample recordings
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#ifndef PCM_SOURCE_H_
+#define PCM_SOURCE_H_
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stddef.h>
+
+#define PCM_MAX_CHANNELS 8
+
+//*****************************************************************************
+// Samples in the input are either signed 16 bit audio, scaled down to what the
+// 12 bit ADC would have produced, or raw ADC readings (0 to 4095)
+//*****************************************************************************
+enum SAMPLE_FORMAT {
+    FORMAT_S16,
+    FORMAT_ADC
+};
+
+//*****************************************************************************
+// Input is either a memory mapped file or a stream read in frame sized chunks.
+// channels and sample_rate are taken from a WAV header when there is one, and
+// reading stops at the end of its data chunk.
+//*****************************************************************************
+struct pcm_source {
+    const uint8_t* map;
+    size_t map_size;
+    size_t map_pos;
+    int fd;
+    FILE* stream;
+    int channels;
+    uint32_t sample_rate;
+    enum SAMPLE_FORMAT format;
+    uint8_t pending[12];
+    size_t pending_len;
+    size_t data_left;               // Bytes of the data chunk not read yet
+};
+
+//*****************************************************************************
+// Open a file (NULL or "-" for stdin) and skip its WAV header, if any. The
+// defaults are used for raw input. Returns -1 with a message on stderr.
+//*****************************************************************************
+int pcm_open(struct pcm_source* src, const char* path, enum SAMPLE_FORMAT format, uint32_t sample_rate);
+
+//*****************************************************************************
+// Read the next frames samples of one channel, scaled to ADC readings.
+// Returns the number of samples read, less than frames at the end.
+//*****************************************************************************
+int pcm_read_frame(struct pcm_source* src, int channel, int16_t* frame, int frames);
+
+void pcm_close(struct pcm_source* src);
+
+#endif // PCM_SOURCE_H_
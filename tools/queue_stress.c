@@ -0,0 +1,164 @@
+//*****************************************************************************
+//
+// queue_stress.c - Check the frame queue against a simulated ADC
+//
+// A producer thread plays the ADC interrupt: it keeps two transfers armed
+// like the ping-pong uDMA, writes the frame number into every sample of the
+// oldest one at a fixed frame rate and completes it. The main thread is the
+// decoder loop and stalls at random, sometimes for many frames. Every frame
+// it gets must be whole, in order and carry its own number, and the gaps in
+// the sequence numbers must add up to the overrun count.
+//
+// Build (from this directory):
+//   cc -O2 -I.. -o queue_stress queue_stress.c ../frame_queue.c -lpthread
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "frame_queue.h"
+
+#define FRAME_SIZE 1024
+
+static struct frame_queue queue;
+static int16_t* storage;
+static uint32_t num_frames = 20000;
+static long period_ns = 50000;
+static volatile bool producer_done;
+
+static void sleep_ns(long ns)
+{
+    struct timespec ts;
+
+    ts.tv_sec = ns / 1000000000L;
+    ts.tv_nsec = ns % 1000000000L;
+    nanosleep(&ts, NULL);
+}
+
+static void* producer(void* arg)
+{
+    int16_t* armed[FRAME_QUEUE_MAX_ARMED];
+    uint32_t frame = 0;
+    int i = 0;
+
+    (void)arg;
+    armed[0] = frame_queue_arm(&queue);
+    armed[1] = frame_queue_arm(&queue);
+
+    for (frame = 0; frame < num_frames; frame++) {
+        sleep_ns(period_ns);
+
+        // The "DMA" fills the oldest transfer, then the interrupt runs
+        for (i = 0; i < FRAME_SIZE; i++)
+            armed[0][i] = (int16_t)frame;
+        frame_queue_complete(&queue);
+        armed[0] = armed[1];
+        armed[1] = frame_queue_arm(&queue);
+    }
+
+    producer_done = true;
+    return NULL;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "usage: queue_stress [-n frames] [-d depth] [-p period_us] [-s stall_percent] [-l max_stall_frames]\n"
+        "  defaults: 20000 frames, depth 4, 50us frames, 5%% of frames stall for up to 8 frames\n");
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    pthread_t thread;
+    const int16_t* frame;
+    uint32_t sequence, expected = 0, received = 0, gaps = 0, lost = 0, errors = 0;
+    int opt, depth = 4, stall_percent = 5, max_stall = 8, i = 0;
+
+    while ((opt = getopt(argc, argv, "n:d:p:s:l:h")) != -1) {
+        switch (opt) {
+        case 'n':
+            num_frames = strtoul(optarg, NULL, 0);
+            break;
+        case 'd':
+            depth = atoi(optarg);
+            break;
+        case 'p':
+            period_ns = atol(optarg) * 1000;
+            break;
+        case 's':
+            stall_percent = atoi(optarg);
+            break;
+        case 'l':
+            max_stall = atoi(optarg);
+            break;
+        default:
+            usage();
+        }
+    }
+
+    storage = calloc((depth + 1) * FRAME_SIZE, sizeof(int16_t));
+    if (!storage || frame_queue_init(&queue, storage, FRAME_SIZE, depth)) {
+        fprintf(stderr, "depth has to be a power of two from %d to %d\n", FRAME_QUEUE_MAX_ARMED + 1, FRAME_QUEUE_MAX_DEPTH);
+        return 2;
+    }
+
+    srand(1);
+    pthread_create(&thread, NULL, producer, NULL);
+
+    while (!producer_done || queue.head != queue.tail) {
+        frame = frame_queue_peek(&queue, &sequence);
+        if (!frame)
+            continue;
+
+        if (sequence < expected) {
+            printf("frame %u arrived after %u\n", sequence, expected - 1);
+            errors++;
+        } else if (sequence > expected) {
+            gaps++;
+            lost += sequence - expected;
+        }
+
+        // Decoding takes a while, now and then far longer than a frame
+        if (rand() % 100 < stall_percent)
+            sleep_ns(period_ns * (1 + rand() % max_stall));
+
+        // Checked after the stall, the producer must not have touched it
+        for (i = 0; i < FRAME_SIZE; i++) {
+            if (frame[i] != (int16_t)sequence) {
+                printf("frame %u overwritten at sample %d\n", sequence, i);
+                errors++;
+                break;
+            }
+        }
+
+        frame_queue_release(&queue);
+        expected = sequence + 1;
+        received++;
+    }
+    pthread_join(thread, NULL);
+
+    // Frames dropped after the last one received never show up as a gap
+    lost += queue.next_sequence - expected;
+    if (lost != queue.overruns) {
+        printf("%u frames missing but %u overruns counted\n", lost, queue.overruns);
+        errors++;
+    }
+    if (received + queue.overruns != num_frames) {
+        printf("%u received + %u dropped != %u produced\n", received, queue.overruns, num_frames);
+        errors++;
+    }
+
+    printf("%u frames, %u received, %u dropped in %u gaps, %u most waiting, %u errors\n",
+        num_frames, received, queue.overruns, gaps, queue.high_water, errors);
+
+    return errors ? 1 : 0;
+}
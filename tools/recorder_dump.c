@@ -0,0 +1,405 @@
+//*****************************************************************************
+//
+// recorder_dump.c - Turn a flight recorder dump into a WAV file
+//
+// Reads what the receiver sent over the UART after a 'd' command, console
+// text and all, picks out the recorder blocks and checks their CRCs. The
+// frames of the last complete dump are written to a WAV file that ultradec
+// replays sample for sample, and the decisions the receiver made on the
+// frames before it froze are listed to compare against. Frames dropped by
+// the receiver are left out of the WAV and pointed out.
+// -S checks the recorder and this reader against each other instead, on
+// random frames mixed with text, with some of the dumps damaged.
+//
+// Build (from this directory):
+//   cc -O2 -I.. -o recorder_dump recorder_dump.c pcm_sink.c ../recorder.c
+//      ../cobs.c ../packet.c
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "recorder.h"
+#include "packet.h"
+#include "cobs.h"
+#include "pcm_sink.h"
+
+#define MAX_FRAMES 255
+#define MAX_DECISIONS 255
+#define ALL_PARTS ((1u << RECORDER_PARTS) - 1)
+
+//*****************************************************************************
+// A dump as it is put back together, complete once its END block arrived
+// after every other block
+//*****************************************************************************
+struct dump {
+    bool started;
+    bool complete;
+    int blocks;
+    uint32_t sample_rate;
+    int frames;
+    int decisions;
+    int trigger;
+    uint32_t trigger_sequence;
+    int modulation;
+    int coding;
+    int packets;
+    uint32_t sequence[MAX_FRAMES];
+    uint32_t parts[MAX_FRAMES];
+    uint8_t packed[MAX_FRAMES][RECORDER_PACKED_SIZE];
+    struct recorder_decision decision[MAX_DECISIONS];
+    int decisions_received;
+};
+
+static const char* const trigger_names[] = { "running", "request", "sync failed", "packet rejected" };
+
+static uint64_t rng_state = 1;
+
+static uint32_t random32(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t)(rng_state >> 32);
+}
+
+static uint32_t get16(const uint8_t* in)
+{
+    return in[0] | (in[1] << 8);
+}
+
+static uint32_t get32(const uint8_t* in)
+{
+    return get16(in) | (get16(in + 2) << 16);
+}
+
+//*****************************************************************************
+// One block between zeros. Returns 1 when it completed a dump, -1 if it is
+// not a valid recorder block (console text, telemetry or damage).
+//*****************************************************************************
+static int add_block(struct dump* dump, const uint8_t* encoded, int length)
+{
+    uint8_t raw[COBS_MAX_BLOCK];
+    const uint8_t* body = raw + 3;
+    int size = cobs_decode(encoded, length, raw), count, i = 0;
+
+    if (size < 5 || raw[0] != RECORDER_MAGIC || raw[1] != RECORDER_VERSION
+        || crc16_update(0xFFFF, raw, size - 2) != ((raw[size - 2] << 8) | raw[size - 1]))
+        return -1;
+    size -= 5;
+
+    if (raw[2] == RECORDER_HEADER) {
+        if (size != 16 || get16(body + 4) != NUM_SAMPLES)
+            return -1;
+        memset(dump, 0, sizeof(*dump));
+        dump->started = true;
+        dump->sample_rate = get32(body);
+        dump->frames = body[6];
+        dump->decisions = body[7];
+        dump->trigger = body[8];
+        dump->trigger_sequence = get32(body + 9);
+        dump->modulation = body[13];
+        dump->coding = body[14];
+        dump->packets = body[15];
+    } else if (!dump->started) {
+        return 0;
+    } else if (raw[2] == RECORDER_FRAME) {
+        if (size != 6 + RECORDER_PART_SIZE || body[0] >= dump->frames || body[1] >= RECORDER_PARTS)
+            return -1;
+        dump->sequence[body[0]] = get32(body + 2);
+        dump->parts[body[0]] |= 1u << body[1];
+        memcpy(&dump->packed[body[0]][body[1] * RECORDER_PART_SIZE], body + 6, RECORDER_PART_SIZE);
+    } else if (raw[2] == RECORDER_DECISIONS_BLOCK) {
+        count = size / RECORDER_DECISION_SIZE;
+        if (size % RECORDER_DECISION_SIZE || dump->decisions_received + count > dump->decisions)
+            return -1;
+        for (i = 0; i < count; i++, body += RECORDER_DECISION_SIZE) {
+            dump->decision[dump->decisions_received].sequence = get32(body);
+            dump->decision[dump->decisions_received].bit_index = (uint16_t)get16(body + 4);
+            dump->decision[dump->decisions_received].snr_db = (int8_t)body[6];
+            dump->decision[dump->decisions_received].byte_sync = (int8_t)body[7];
+            dump->decision[dump->decisions_received].flags = body[8];
+            dump->decision[dump->decisions_received].events = body[9];
+            dump->decisions_received++;
+        }
+    } else if (raw[2] == RECORDER_END) {
+        if (size != 2)
+            return -1;
+        dump->started = false;
+        dump->complete = get16(body) == (uint32_t)dump->blocks && dump->decisions_received == dump->decisions;
+        for (i = 0; i < dump->frames; i++)
+            dump->complete = dump->complete && dump->parts[i] == ALL_PARTS;
+        return 1;
+    } else {
+        return -1;
+    }
+
+    dump->blocks++;
+    return 0;
+}
+
+//*****************************************************************************
+// Split a capture at the zeros. Text can run straight into a block, so the
+// block is the longest tail of the run before a zero that checks out.
+// Returns the number of complete dumps, the last of which is left in dump.
+//*****************************************************************************
+static int read_capture(FILE* file, struct dump* dump, struct dump* scratch, int* damaged)
+{
+    static uint8_t run[2 * (COBS_MAX_BLOCK + 1)];
+    int length = 0, dumps = 0, result = -1, byte, start;
+
+    while ((byte = getc(file)) != EOF) {
+        if (byte) {
+            if (length == (int)sizeof(run)) {
+                memmove(run, run + COBS_MAX_BLOCK + 1, COBS_MAX_BLOCK + 1);
+                length = COBS_MAX_BLOCK + 1;
+            }
+            run[length++] = (uint8_t)byte;
+            continue;
+        }
+
+        start = (length > COBS_MAX_BLOCK + 1) ? length - (COBS_MAX_BLOCK + 1) : 0;
+        for (result = -1; start < length && result < 0; start++)
+            result = add_block(scratch, run + start, length - start);
+        if (result == 1) {
+            if (scratch->complete) {
+                memcpy(dump, scratch, sizeof(*dump));
+                dumps++;
+            } else {
+                (*damaged)++;
+            }
+        }
+        length = 0;
+    }
+
+    return dumps;
+}
+
+static void print_decisions(const struct dump* dump)
+{
+    static const char* const events[] = { "lock", "char", "end", "sync failed", "retune", "packet", "rejected", "rate" };
+    const struct recorder_decision* decision;
+    int i = 0, e = 0;
+
+    printf("\n  frame      state      snr  sync   bit  events\n");
+    for (i = 0; i < dump->decisions; i++) {
+        decision = &dump->decision[i];
+        printf("  %-9u  %-9s  %3d  %4d  %4u ", decision->sequence,
+            (decision->flags & RECORDER_GATED) ? "gated" : (decision->flags & RECORDER_RECEIVING) ? "receiving" : "searching",
+            decision->snr_db, decision->byte_sync, decision->bit_index);
+        if (decision->flags & RECORDER_SKIPPED)
+            printf(" (after dropped frames)");
+        for (e = 0; e < 8; e++) {
+            if (decision->events & (1 << e))
+                printf(" %s", events[e]);
+        }
+        printf("\n");
+    }
+}
+
+static int write_wav(const struct dump* dump, const char* path)
+{
+    struct pcm_sink sink;
+    int16_t frame[NUM_SAMPLES];
+    int i = 0;
+
+    if (pcm_create(&sink, path, dump->sample_rate, 1))
+        return 1;
+    for (i = 0; i < dump->frames; i++) {
+        if (i && dump->sequence[i] != dump->sequence[i - 1] + 1)
+            fprintf(stderr, "%u frame(s) dropped by the receiver before frame %u are missing from the WAV\n",
+                dump->sequence[i] - dump->sequence[i - 1] - 1, dump->sequence[i]);
+        recorder_unpack(dump->packed[i], frame);
+        pcm_write_adc(&sink, frame, NUM_SAMPLES);
+    }
+    if (pcm_finish(&sink)) {
+        fprintf(stderr, "%s: write failed\n", path);
+        return 1;
+    }
+
+    return 0;
+}
+
+//*****************************************************************************
+// Record random frames with a fake decoder, dump the recorder into a file
+// with text around the blocks and read it back. Every third dump has one
+// block damaged and must not come back as complete.
+//*****************************************************************************
+static int self_test(int count)
+{
+    static struct recorder rec;
+    static struct decoder dec;
+    static struct dump dump, scratch;
+    static int16_t frames[RECORDER_FRAMES][NUM_SAMPLES];
+    int16_t unpacked[NUM_SAMPLES];
+    uint8_t block[COBS_ENCODED_SIZE(RECORDER_MAX_BLOCK)];
+    uint32_t sequence = 0, held, length;
+    int errors = 0, complete = 0, damaged = 0, bad = 0, n = 0, i = 0, f = 0, blocks, hit, found;
+    FILE* file;
+
+    memset(&dec, 0, sizeof(dec));
+    dec.sample_rate = 51200;
+    recorder_init(&rec);
+
+    for (n = 0; n < count; n++) {
+        file = tmpfile();
+        if (!file)
+            return 1;
+
+        recorder_arm(&rec);
+        held = 1 + random32() % (2 * RECORDER_DECISIONS);
+        for (f = 0; f < (int)held; f++) {
+            for (i = 0; i < NUM_SAMPLES; i++)
+                frames[f % RECORDER_FRAMES][i] = (int16_t)(random32() % 4096);
+            dec.transfer_status = random32() & 1;
+            dec.gated = random32() & 1;
+            dec.snr_db = (int)(random32() % 80) - 20;
+            dec.byte_sync = (enum SYNCHRONIZATION)(random32() % 3);
+            dec.bit_output_index = random32() % 400;
+            if (!(random32() % 4))
+                recorder_event(&rec, (enum DECODER_EVENT)(random32() % 8));
+            sequence += 1 + ((random32() % 16) ? 0 : random32() % 3);
+            recorder_frame(&rec, &dec, frames[f % RECORDER_FRAMES], sequence, 0);
+            if (rec.trigger != RECORDER_RUNNING)
+                break;
+        }
+        held = (rec.frame_count < RECORDER_FRAMES) ? rec.frame_count : RECORDER_FRAMES;
+
+        recorder_dump_start(&rec);
+        blocks = 0;
+        hit = (n % 3) ? -1 : (int)(random32() % (1 + held * RECORDER_PARTS + 2));
+        while ((length = recorder_dump_next(&rec, &dec, block)) > 0) {
+            // Text between the blocks, any bytes but zero
+            for (i = random32() % 40; i > 0; i--)
+                putc(1 + random32() % 255, file);
+            if (blocks++ == hit)
+                block[random32() % (length - 1)] ^= 1 + random32() % 255;
+            fwrite(block, 1, length, file);
+        }
+        rewind(file);
+        memset(&scratch, 0, sizeof(scratch));
+        bad = 0;
+        found = read_capture(file, &dump, &scratch, &bad);
+        fclose(file);
+
+        if (hit >= 0) {
+            damaged++;
+            if (found && errors++ < 10)
+                printf("dump %d came back complete with block %d damaged\n", n, hit);
+            continue;
+        }
+        if (found != 1) {
+            if (errors++ < 10)
+                printf("dump %d did not come back\n", n);
+            continue;
+        }
+        complete++;
+
+        if (dump.frames != (int)held || dump.trigger != (int)rec.trigger || dump.sample_rate != dec.sample_rate
+            || dump.decisions != (int)((rec.decision_count < RECORDER_DECISIONS) ? rec.decision_count : RECORDER_DECISIONS)) {
+            if (errors++ < 10)
+                printf("dump %d has the wrong header\n", n);
+            continue;
+        }
+        for (i = 0; i < dump.frames; i++) {
+            f = (rec.frame_count - held + i) % RECORDER_FRAMES;
+            recorder_unpack(dump.packed[i], unpacked);
+            if (dump.sequence[i] != rec.frame_sequence[f] || memcmp(unpacked, frames[(rec.frame_count - held + i) % RECORDER_FRAMES], sizeof(unpacked))) {
+                if (errors++ < 10)
+                    printf("dump %d frame %d came back wrong\n", n, i);
+            }
+        }
+        for (i = 0; i < dump.decisions; i++) {
+            if (memcmp(&dump.decision[i], &rec.decisions[(rec.decision_count - dump.decisions + i) % RECORDER_DECISIONS], sizeof(dump.decision[i]))) {
+                if (errors++ < 10)
+                    printf("dump %d decision %d came back wrong\n", n, i);
+            }
+        }
+    }
+
+    printf("%d dumps, %d read back whole, %d damaged and none of those accepted\n", count, complete, damaged);
+    printf("%d errors\n", errors);
+
+    return errors ? 1 : 0;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "usage: recorder_dump [-o file.wav] [capture]\n"
+        "       recorder_dump -S [-n dumps] [-s seed]\n"
+        "  -o  write the frames of the last complete dump to a WAV file\n"
+        "  -S  check that the recorder and this reader agree\n"
+        "  reads stdin if no capture is given or it is -\n");
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    static struct dump dump, scratch;
+    static const char* const modulations[] = { "ook", "mfsk", "dbpsk", "dqpsk", "ofdm" };
+    static const char* const codes[] = { "none", "hamming", "conv" };
+    const char* wav = NULL;
+    FILE* file = stdin;
+    int opt, count = 1000, dumps, damaged = 0;
+    bool test = false;
+
+    while ((opt = getopt(argc, argv, "o:Sn:s:h")) != -1) {
+        switch (opt) {
+        case 'o':
+            wav = optarg;
+            break;
+        case 'S':
+            test = true;
+            break;
+        case 'n':
+            count = atoi(optarg);
+            break;
+        case 's':
+            rng_state = strtoull(optarg, NULL, 0) | 1;
+            break;
+        default:
+            usage();
+        }
+    }
+    if (test)
+        return self_test(count);
+
+    if (optind < argc && strcmp(argv[optind], "-")) {
+        file = fopen(argv[optind], "rb");
+        if (!file) {
+            perror(argv[optind]);
+            return 1;
+        }
+    }
+    dumps = read_capture(file, &dump, &scratch, &damaged);
+    if (file != stdin)
+        fclose(file);
+
+    if (damaged)
+        fprintf(stderr, "%d dump(s) with missing or damaged blocks skipped\n", damaged);
+    if (!dumps) {
+        fprintf(stderr, "no complete recorder dump found\n");
+        return 1;
+    }
+
+    printf("%d dump(s), the last froze on %s at frame %u\n", dumps,
+        (dump.trigger < 4) ? trigger_names[dump.trigger] : "?", dump.trigger_sequence);
+    printf("%d frame(s) of %d samples at %u Hz, %d decisions\n", dump.frames, NUM_SAMPLES, dump.sample_rate, dump.decisions);
+    print_decisions(&dump);
+
+    if (!wav)
+        return 0;
+    if (write_wav(&dump, wav))
+        return 1;
+    printf("\nreplay with: ultradec -s -m %s -e %s%s %s\n", modulations[(dump.modulation < 5) ? dump.modulation : 0],
+        codes[(dump.coding < 3) ? dump.coding : 0], dump.packets ? " -p" : "", wav);
+
+    return 0;
+}
@@ -0,0 +1,400 @@
+//*****************************************************************************
+//
+// snr_sweep.c - Error rates of the fixed and adaptive detectors against SNR
+//
+// Synthesizes OOK transmissions (start byte on the sync carrier, text and
+// stop byte on the data carrier, FRAMES_PER_BIT frames per bit) in Gaussian
+// noise, with a second of noise between messages. SNR is the carrier power
+// over the noise power in one detector bin, which is what the decoder
+// reports, and is 27dB above the SNR over the whole 25.6kHz band. Gain
+// scales carrier and noise together, like moving the microphone gain would.
+// Every point is decoded twice from the same samples, once at the fixed
+// threshold and once relative to the noise floor, and for each the table
+// shows:
+//   ok      messages received exactly
+//   cer     characters wrong or missing, out of all characters sent
+//   false   sync failures plus messages that match nothing sent
+//   snr     mean SNR the decoder measured on its start sequences
+//   rej     with -P, packets the adaptive detector rejected for a bad header
+//           or CRC instead of passing them on
+// Build with -DFRAMES_PER_BIT=n to see how few frames per bit still work,
+// and add -e to send the text and stop byte with an error correcting code
+// (more channel bits per byte, so fewer frames per bit for the same time on
+// air). -P sends every message as a packet instead of text and a stop byte.
+//
+// Build (from this directory):
+//   cc -O2 -I.. -o snr_sweep snr_sweep.c ../decoder.c ../goertzel.c
+//      ../sliding_goertzel.c ../symbol_sync.c ../fft.c ../energy_gate.c
+//      ../noise_floor.c ../fec.c ../packet.c ../freq_plan.c ../diversity.c
+//      ../ofdm.c ../nco.c -lm
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include "decoder.h"
+
+#define SAMPLE_RATE 51200
+#define MESSAGE_LENGTH 12
+#define MAX_MESSAGES 200
+#define GAP_SAMPLES SAMPLE_RATE
+#define BASE_AMPLITUDE 40.0
+
+//*****************************************************************************
+// One transmitted message and where it is in the stream
+//*****************************************************************************
+struct sent {
+    char text[MESSAGE_LENGTH + 1];
+    uint32_t first_frame;
+    uint32_t last_frame;
+};
+
+//*****************************************************************************
+// Messages the decoder gave back
+//*****************************************************************************
+struct received {
+    char text[4 * MESSAGE_LENGTH + 1];
+    uint32_t lock_frame;
+    bool matched;
+};
+
+struct result {
+    int ok;
+    int char_errors;
+    int false_alarms;
+    int rejected;
+    int locks;
+    long snr_sum;
+};
+
+struct run {
+    struct decoder dec;
+    struct received messages[2 * MAX_MESSAGES];
+    int count;
+    int length;
+    uint32_t lock_frame;
+    int lock_snr;
+    int failures;
+    int rejected;
+    long snr_sum;
+};
+
+static struct sent sent[MAX_MESSAGES];
+static int num_messages = 20;
+static double clock_ppm = 0;
+static bool gating = true;
+static enum FEC_CODE coding = FEC_NONE;
+static bool packets = false;
+static uint64_t rng_state = 1;
+
+//*****************************************************************************
+// xorshift64 and Box-Muller, so every run sees the same noise
+//*****************************************************************************
+static double uniform(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return ((rng_state >> 11) + 0.5) / 9007199254740992.0;
+}
+
+static double gaussian(void)
+{
+    return sqrt(-2.0 * log(uniform())) * cos(2.0 * M_PI * uniform());
+}
+
+//*****************************************************************************
+// Append n samples of a carrier at amplitude (0 for noise only) to the
+// stream as 12 bit ADC readings
+//*****************************************************************************
+static void emit(int16_t* out, int* length, int n, double freq, double amplitude, double sigma, double* phase)
+{
+    double value;
+    int i = 0;
+
+    for (i = 0; i < n; i++) {
+        value = 2048.0 + amplitude * sin(*phase) + sigma * gaussian();
+        *phase += 2.0 * M_PI * freq / SAMPLE_RATE;
+        if (*phase > 2.0 * M_PI)
+            *phase -= 2.0 * M_PI;
+        value = floor(value + 0.5);
+        out[(*length)++] = (int16_t)(value < 0 ? 0 : value > 4095 ? 4095 : value);
+    }
+}
+
+//*****************************************************************************
+// The whole test stream for one point, returns its length in samples
+//*****************************************************************************
+static int synthesize(int16_t* out, double amplitude, double sigma)
+{
+    struct fec_encoder raw, enc;
+    double phase = 0, bit_length = (double)FRAMES_PER_BIT * NUM_SAMPLES * (1.0 + clock_ppm * 1e-6), clock = 0;
+    uint8_t bits[16], data[PACKET_MAX_SIZE + 1];
+    int length = 0, msg = 0, byte = 0, bit = 0, size, count, n;
+
+    fec_encoder_init(&raw, FEC_NONE);
+    for (msg = 0; msg < num_messages; msg++) {
+        emit(out, &length, GAP_SAMPLES, 0, 0, sigma, &phase);
+        sent[msg].first_frame = length / NUM_SAMPLES;
+
+        // Text and its stop byte, or a packet and a zero byte to end the code
+        if (packets) {
+            size = packet_build(data, 0, (uint8_t)msg, 0, (const uint8_t*)sent[msg].text, MESSAGE_LENGTH);
+        } else {
+            memcpy(data, sent[msg].text, MESSAGE_LENGTH);
+            size = MESSAGE_LENGTH;
+        }
+        data[size++] = 0;
+
+        // The start byte is never coded, the receiver has to find it first
+        fec_encoder_init(&enc, coding);
+        for (byte = -1; byte < size; byte++) {
+            if (byte < 0)
+                count = fec_encode_byte(&raw, 0xAA, bits);
+            else
+                count = fec_encode_byte(&enc, data[byte], bits);
+            for (bit = 0; bit < count; bit++) {
+                clock += bit_length;
+                n = (int)clock;
+                clock -= n;
+                emit(out, &length, n, (byte < 0) ? SYNC_TONE_FREQ : DATA_TONE_FREQ,
+                    bits[bit] ? amplitude : 0, sigma, &phase);
+            }
+        }
+        sent[msg].last_frame = length / NUM_SAMPLES;
+    }
+    emit(out, &length, GAP_SAMPLES, 0, 0, sigma, &phase);
+
+    return length;
+}
+
+static void on_event(void* ctx, enum DECODER_EVENT event, int value)
+{
+    struct run* run = ctx;
+    struct received* msg;
+
+    switch (event) {
+    case DECODER_LOCK:
+        run->lock_frame = run->dec.frames;
+        run->lock_snr = value;
+        run->length = 0;
+        break;
+    case DECODER_CHAR:
+        if (run->length < 4 * MESSAGE_LENGTH && run->count < 2 * MAX_MESSAGES)
+            run->messages[run->count].text[run->length++] = (char)value;
+        break;
+    case DECODER_END:
+        if (run->count < 2 * MAX_MESSAGES) {
+            msg = &run->messages[run->count++];
+            msg->text[run->length] = 0;
+            msg->lock_frame = run->lock_frame;
+            msg->matched = false;
+            run->snr_sum += run->lock_snr;
+        }
+        run->length = 0;
+        break;
+    case DECODER_PACKET:
+        if (run->count < 2 * MAX_MESSAGES) {
+            msg = &run->messages[run->count++];
+            memcpy(msg->text, run->dec.packet.payload, value < 4 * MESSAGE_LENGTH ? value : 4 * MESSAGE_LENGTH);
+            msg->text[value < 4 * MESSAGE_LENGTH ? value : 4 * MESSAGE_LENGTH] = 0;
+            msg->lock_frame = run->lock_frame;
+            msg->matched = false;
+            run->snr_sum += run->lock_snr;
+        }
+        break;
+    case DECODER_PACKET_REJECTED:
+        run->rejected++;
+        break;
+    case DECODER_SYNC_FAILED:
+        run->failures++;
+        run->length = 0;
+        break;
+    case DECODER_RETUNE:
+    case DECODER_RATE:
+        break;
+    }
+}
+
+//*****************************************************************************
+// Decode the stream and score it against what was sent
+//*****************************************************************************
+static void decode(struct run* run, const int16_t* stream, int length, bool adaptive, struct result* result)
+{
+    struct received* best;
+    int frame = 0, msg = 0, i = 0, errors, len;
+
+    memset(run, 0, sizeof(*run));
+    decoder_init(&run->dec, SAMPLE_RATE, OOK, on_event, run);
+    run->dec.adaptive_threshold = adaptive;
+    run->dec.energy_gating = gating;
+    run->dec.coding = coding;
+    run->dec.packets = packets;
+
+    for (frame = 0; frame + NUM_SAMPLES <= length; frame += NUM_SAMPLES)
+        decoder_process(&run->dec, stream + frame);
+
+    memset(result, 0, sizeof(*result));
+    for (msg = 0; msg < num_messages; msg++) {
+        best = NULL;
+        for (i = 0; i < run->count; i++) {
+            if (!run->messages[i].matched && run->messages[i].lock_frame + 1 >= sent[msg].first_frame
+                && run->messages[i].lock_frame <= sent[msg].last_frame) {
+                best = &run->messages[i];
+                break;
+            }
+        }
+
+        if (!best) {
+            result->char_errors += MESSAGE_LENGTH;
+            continue;
+        }
+        best->matched = true;
+
+        len = strlen(best->text);
+        errors = (len > MESSAGE_LENGTH) ? len - MESSAGE_LENGTH : MESSAGE_LENGTH - len;
+        for (i = 0; i < len && i < MESSAGE_LENGTH; i++)
+            errors += best->text[i] != sent[msg].text[i];
+        result->char_errors += errors;
+        if (!errors)
+            result->ok++;
+    }
+
+    result->false_alarms = run->failures;
+    for (i = 0; i < run->count; i++)
+        result->false_alarms += !run->messages[i].matched;
+    result->rejected = run->rejected;
+    result->locks = run->count;
+    result->snr_sum = run->snr_sum;
+}
+
+static void print_result(const struct result* result)
+{
+    printf(" | %3d/%-3d %5.1f%% %5d", result->ok, num_messages,
+        100.0 * result->char_errors / (num_messages * MESSAGE_LENGTH), result->false_alarms);
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "usage: snr_sweep [-n messages] [-l min_snr] [-h max_snr] [-s step] [-g gain,gain,...] [-p ppm] [-r seed]\n"
+        "                 [-e none|hamming|conv] [-P] [-G]\n"
+        "  defaults: 20 messages, 3 to 30dB in 3dB steps, gains 0.125,0.5,2,8, no clock error\n"
+        "  -e  error correcting code on the text and stop byte (default none)\n"
+        "  -P  send packets with a CRC instead of text ended by a zero byte\n"
+        "  -G  run the detectors on every frame instead of only when the energy gate opens\n");
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    static struct run run;
+    struct result fixed, adaptive;
+    double gains[16] = { 0.125, 0.5, 2, 8 };
+    double min_snr = 3, max_snr = 30, step = 3, snr, amplitude, sigma;
+    struct fec_encoder probe;
+    uint8_t probe_bits[16];
+    int16_t* stream;
+    char* token;
+    int opt, num_gains = 4, gain = 0, msg = 0, i = 0, length;
+
+    while ((opt = getopt(argc, argv, "n:l:h:s:g:p:r:e:PG")) != -1) {
+        switch (opt) {
+        case 'n':
+            num_messages = atoi(optarg);
+            break;
+        case 'l':
+            min_snr = atof(optarg);
+            break;
+        case 'h':
+            max_snr = atof(optarg);
+            break;
+        case 's':
+            step = atof(optarg);
+            break;
+        case 'g':
+            num_gains = 0;
+            for (token = strtok(optarg, ","); token && num_gains < 16; token = strtok(NULL, ","))
+                gains[num_gains++] = atof(token);
+            break;
+        case 'p':
+            clock_ppm = atof(optarg);
+            break;
+        case 'r':
+            rng_state = strtoull(optarg, NULL, 0) | 1;
+            break;
+        case 'e':
+            if (!strcmp(optarg, "hamming"))
+                coding = FEC_HAMMING;
+            else if (!strcmp(optarg, "conv"))
+                coding = FEC_CONVOLUTIONAL;
+            else if (strcmp(optarg, "none"))
+                usage();
+            break;
+        case 'P':
+            packets = true;
+            break;
+        case 'G':
+            gating = false;
+            break;
+        default:
+            usage();
+        }
+    }
+    if (num_messages < 1 || num_messages > MAX_MESSAGES || step <= 0 || !num_gains)
+        usage();
+
+    fec_encoder_init(&probe, coding);
+
+    // Random printable text, never the stop byte
+    for (msg = 0; msg < num_messages; msg++) {
+        for (i = 0; i < MESSAGE_LENGTH; i++)
+            sent[msg].text[i] = (char)(0x21 + (int)(uniform() * 94));
+        sent[msg].text[MESSAGE_LENGTH] = 0;
+    }
+
+    length = num_messages * (GAP_SAMPLES + (MESSAGE_LENGTH + 10) * 16 * (FRAMES_PER_BIT * NUM_SAMPLES + 1) * 2) + GAP_SAMPLES;
+    stream = malloc(length * sizeof(int16_t));
+    if (!stream) {
+        fprintf(stderr, "out of memory\n");
+        return 1;
+    }
+
+    printf("%d frames per bit, %d channel bits per byte, %d messages of %d characters per point\n",
+        FRAMES_PER_BIT, fec_encode_byte(&probe, 0, probe_bits), num_messages, MESSAGE_LENGTH);
+    printf(" gain   snr |   fixed: ok   cer  false |  adaptive: ok cer  false |   snr%s\n", packets ? " |  rej" : "");
+    for (gain = 0; gain < num_gains; gain++) {
+        for (snr = min_snr; snr <= max_snr + 1e-9; snr += step) {
+            // Carrier power in a bin is A^2 N^2 / 4, noise is sigma^2 N
+            amplitude = BASE_AMPLITUDE * gains[gain];
+            sigma = amplitude * sqrt(NUM_SAMPLES / (4.0 * pow(10.0, snr / 10.0)));
+
+            length = synthesize(stream, amplitude, sigma);
+            decode(&run, stream, length, false, &fixed);
+            decode(&run, stream, length, true, &adaptive);
+
+            printf("%5.3g %5.1f", gains[gain], snr);
+            print_result(&fixed);
+            print_result(&adaptive);
+            if (adaptive.locks)
+                printf(" | %5.1f", (double)adaptive.snr_sum / adaptive.locks);
+            else
+                printf(" |     -");
+            if (packets)
+                printf(" | %4d", adaptive.rejected);
+            printf("\n");
+            fflush(stdout);
+        }
+    }
+
+    free(stream);
+
+    return 0;
+}
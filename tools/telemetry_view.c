@@ -0,0 +1,409 @@
+//*****************************************************************************
+//
+// telemetry_view.c - Histograms and timelines from a telemetry capture
+//
+// Reads what a TELEMETRY=1 receiver sent over the UART (or ultradec -R
+// wrote), separates the binary frame records from the console text and
+// prints:
+//   - a timeline of everything that happened: start sequences found and
+//     lost, console text, dropped frames and text, records missing from the
+//     capture. With -t every frame is listed.
+//   - decoding time per frame for idle (gated), searching and receiving
+//     frames, as a histogram and against the time one frame takes to sample
+//   - the SNR of the frames received, as a histogram
+// -S checks that the encoder and the parser round trip instead, on random
+// records mixed with text, with some of the records damaged.
+//
+// Build (from this directory):
+//   cc -O2 -I.. -o telemetry_view telemetry_view.c ../telemetry.c
+//      ../packet.c ../noise_floor.c ../cobs.c -lm
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "telemetry.h"
+
+#define NUM_BUCKETS 24
+#define BAR_WIDTH 40
+#define LINE_SIZE 256
+#define CHUNK_SIZE 4096
+
+//*****************************************************************************
+// Decoding times of one kind of frame, bucket i counts times from 2^i to
+// 2^(i+1) microseconds
+//*****************************************************************************
+struct timing {
+    uint32_t frames;
+    double total_us;
+    double max_us;
+    uint32_t over_budget;
+    uint32_t buckets[NUM_BUCKETS];
+};
+
+enum FRAME_KIND {
+    KIND_GATED,
+    KIND_SEARCHING,
+    KIND_RECEIVING,
+    NUM_KINDS
+};
+
+static const char* const kind_names[NUM_KINDS] = { "gated", "searching", "receiving" };
+static struct timing timings[NUM_KINDS];
+
+static uint32_t snr_buckets[64];
+static double clock_hz = 80000000.0;
+static double frame_us = 1e6 * NUM_SAMPLES / 51200.0;
+static bool full_timeline = false;
+
+static uint64_t rng_state = 1;
+
+static uint32_t random32(void)
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return (uint32_t)(rng_state >> 32);
+}
+
+static void print_bar(uint32_t count, uint32_t most)
+{
+    int len = most ? (int)((uint64_t)count * BAR_WIDTH / most) : 0, i = 0;
+
+    if (count && !len)
+        len = 1;
+    for (i = 0; i < len; i++)
+        putchar('#');
+}
+
+//*****************************************************************************
+// Timeline of one record, against the one before it
+//*****************************************************************************
+static void show_record(const struct telemetry_record* rec, const struct telemetry_record* last, bool have_last, double us)
+{
+    double t = (double)(rec->sequence + 1) * frame_us / 1e6;
+
+    if (have_last && rec->sequence != last->sequence + 1 && rec->sequence - last->sequence - 1 != rec->dropped)
+        printf("[%10.3f] %u record(s) missing from the capture\n", t, rec->sequence - last->sequence - 1 - rec->dropped);
+    if (rec->flags & TELEMETRY_OVERRUN)
+        printf("[%10.3f] %u frame(s) dropped by the receiver\n", t, rec->dropped);
+    if (rec->flags & TELEMETRY_TEXT_DROPPED)
+        printf("[%10.3f] console text dropped\n", t);
+
+    if (full_timeline) {
+        printf("[%10.3f] #%-8u %-9s sync %9u data %9u floor %7.1f snr %3d sync %2d bit %4u %8.1f us\n",
+            t, rec->sequence, (rec->flags & TELEMETRY_GATED) ? "gated" : (rec->flags & TELEMETRY_RECEIVING) ? "receiving" : "searching",
+            rec->sync_power, rec->data_power, rec->noise / 256.0, rec->snr_db, rec->byte_sync, rec->bit_index, us);
+    } else if (!have_last || (rec->flags & TELEMETRY_RECEIVING) != (last->flags & TELEMETRY_RECEIVING)) {
+        if (rec->flags & TELEMETRY_RECEIVING)
+            printf("[%10.3f] start sequence found, %d dB\n", t, rec->snr_db);
+        else if (have_last)
+            printf("[%10.3f] back to searching after %u bits\n", t, last->bit_index + 1u);
+    }
+}
+
+static void account(const struct telemetry_record* rec, double us)
+{
+    struct timing* timing;
+    int bucket = 0;
+
+    if (rec->flags & TELEMETRY_GATED)
+        timing = &timings[KIND_GATED];
+    else if (rec->flags & TELEMETRY_RECEIVING)
+        timing = &timings[KIND_RECEIVING];
+    else
+        timing = &timings[KIND_SEARCHING];
+
+    timing->frames++;
+    timing->total_us += us;
+    if (us > timing->max_us)
+        timing->max_us = us;
+    if (us > frame_us)
+        timing->over_budget++;
+    for (bucket = 0; bucket < NUM_BUCKETS - 1 && us >= (double)(2u << bucket); bucket++)
+        ;
+    timing->buckets[bucket]++;
+
+    if (rec->flags & TELEMETRY_RECEIVING)
+        snr_buckets[(rec->snr_db < 0) ? 0 : (rec->snr_db > 63) ? 63 : rec->snr_db]++;
+}
+
+static void print_statistics(const struct telemetry_parser* parser, uint32_t missing, uint32_t dropped)
+{
+    uint32_t most;
+    int kind = 0, i = 0, first, last;
+
+    printf("\n%u records, %u damaged, %u missing from the capture, %u frames dropped by the receiver\n",
+        parser->records, parser->errors, missing, dropped);
+
+    printf("\ndecoding time per frame (%.0f us to sample one)\n", frame_us);
+    for (kind = 0; kind < NUM_KINDS; kind++) {
+        if (!timings[kind].frames)
+            continue;
+        printf("%-9s %8u frames, mean %8.1f us (%5.1f%%), max %8.1f us, %u over budget\n",
+            kind_names[kind], timings[kind].frames, timings[kind].total_us / timings[kind].frames,
+            100.0 * timings[kind].total_us / timings[kind].frames / frame_us, timings[kind].max_us, timings[kind].over_budget);
+    }
+
+    for (kind = 0; kind < NUM_KINDS; kind++) {
+        if (!timings[kind].frames)
+            continue;
+        most = 0;
+        first = NUM_BUCKETS;
+        last = 0;
+        for (i = 0; i < NUM_BUCKETS; i++) {
+            if (timings[kind].buckets[i]) {
+                most = (timings[kind].buckets[i] > most) ? timings[kind].buckets[i] : most;
+                first = (i < first) ? i : first;
+                last = i;
+            }
+        }
+        printf("\n%s\n", kind_names[kind]);
+        for (i = first; i <= last; i++) {
+            printf("  %7u-%-7u us %8u ", i ? 1u << i : 0, 2u << i, timings[kind].buckets[i]);
+            print_bar(timings[kind].buckets[i], most);
+            printf("\n");
+        }
+    }
+
+    most = 0;
+    for (i = 0; i < 64; i++)
+        most = (snr_buckets[i] > most) ? snr_buckets[i] : most;
+    if (!most)
+        return;
+    printf("\nSNR of received frames\n");
+    for (i = 0; i < 64; i++) {
+        if (!snr_buckets[i])
+            continue;
+        printf("  %2d%s dB %8u ", i, (i == 63) ? "+" : " ", snr_buckets[i]);
+        print_bar(snr_buckets[i], most);
+        printf("\n");
+    }
+}
+
+//*****************************************************************************
+// Records compared field by field, the padding at the end of the struct is
+// never written
+//*****************************************************************************
+static bool same_record(const struct telemetry_record* a, const struct telemetry_record* b)
+{
+    return a->sequence == b->sequence && a->cycles == b->cycles && a->sync_power == b->sync_power
+        && a->data_power == b->data_power && a->noise == b->noise && a->snr_db == b->snr_db
+        && a->byte_sync == b->byte_sync && a->flags == b->flags && a->dropped == b->dropped
+        && a->bit_index == b->bit_index;
+}
+
+//*****************************************************************************
+// Random records and text through the encoder and the parser, every third
+// record with one byte changed. The text and the intact records must come out
+// as they went in. A damaged record may only come out if the byte changed was
+// a COBS code, which moves zeros around and so changes more than one byte the
+// CRC sees; those are counted.
+//*****************************************************************************
+static int self_test(int count, long* undetected_code)
+{
+    static char sent_text[1 << 22], got_text[1 << 22];
+    struct telemetry_parser parser;
+    struct telemetry_record rec, out, *sent;
+    uint8_t encoded[TELEMETRY_ENCODED_SIZE], rest[TELEMETRY_COBS_SIZE], byte;
+    int sent_len = 0, got_len = 0, good = 0, next = 0, text, errors = 0, n = 0, i = 0, hit, len;
+    bool damaged, code_hit;
+
+    sent = calloc(count, sizeof(*sent));
+    if (!sent)
+        return 1;
+    telemetry_parser_init(&parser);
+
+    for (n = 0; n < count; n++) {
+        // Some console text first, any bytes but zero
+        len = (random32() % 4) ? 0 : random32() % 80;
+        for (i = 0; i < len && sent_len < (int)sizeof(sent_text); i++) {
+            sent_text[sent_len] = (char)(1 + random32() % 255);
+            telemetry_parser_push(&parser, (uint8_t)sent_text[sent_len++], &out, &text);
+            if (text >= 0)
+                got_text[got_len++] = (char)text;
+        }
+
+        rec.sequence = n;
+        rec.cycles = random32() >> (random32() % 32);
+        rec.sync_power = random32() >> (random32() % 32);
+        rec.data_power = (random32() & 1) ? random32() : 0;
+        rec.noise = random32() % 100000;
+        rec.snr_db = (int8_t)random32();
+        rec.byte_sync = (int8_t)(random32() % 5) - 1;
+        rec.flags = (uint8_t)random32() & 0x1F;
+        rec.dropped = (random32() % 8) ? 0 : (uint8_t)random32();
+        rec.bit_index = (uint16_t)random32();
+        telemetry_encode(&rec, encoded);
+
+        // Never into a zero, that would split the record and drop text with it
+        damaged = !(n % 3);
+        code_hit = false;
+        if (damaged) {
+            hit = random32() % TELEMETRY_COBS_SIZE;
+            for (i = 0; i < hit; i += encoded[i])
+                ;
+            code_hit = (i == hit);
+            do {
+                byte = (uint8_t)(1 + random32() % 255);
+            } while (byte == encoded[hit]);
+            encoded[hit] = byte;
+        } else {
+            sent[good++] = rec;
+        }
+
+        for (i = 0; i < TELEMETRY_ENCODED_SIZE; i++) {
+            if (telemetry_parser_push(&parser, encoded[i], &out, &text)) {
+                if (damaged && code_hit) {
+                    (*undetected_code)++;
+                } else if (damaged || next >= good || !same_record(&out, &sent[next++])) {
+                    if (errors++ < 10)
+                        printf("record %d came out wrong\n", n);
+                }
+            }
+            if (text >= 0)
+                got_text[got_len++] = (char)text;
+        }
+    }
+    len = telemetry_parser_flush(&parser, rest);
+    memcpy(got_text + got_len, rest, len);
+    got_len += len;
+
+    if (next != good) {
+        printf("%d of %d intact records came out\n", next, good);
+        errors++;
+    }
+    if (got_len != sent_len || memcmp(got_text, sent_text, sent_len)) {
+        printf("text came out as %d bytes, %d went in\n", got_len, sent_len);
+        errors++;
+    }
+
+    printf("%d records, %d damaged and %ld of those accepted after a COBS code changed\n",
+        count, count - good, *undetected_code);
+    printf("%d bytes of text, parser counted %u records and %u errors\n", sent_len, parser.records, parser.errors);
+    printf("%d errors\n", errors);
+    free(sent);
+
+    return errors ? 1 : 0;
+}
+
+//*****************************************************************************
+// Console text is printed a line at a time, at the time of the last record
+//*****************************************************************************
+static void show_text(char* line, int* length, int byte, double t)
+{
+    if (byte == '\r')
+        return;
+    if (byte != '\n' && *length < LINE_SIZE - 1) {
+        line[(*length)++] = (char)byte;
+        return;
+    }
+
+    line[*length] = '\0';
+    if (*length)
+        printf("[%10.3f] %s\n", t, line);
+    *length = 0;
+    if (byte != '\n')
+        line[(*length)++] = (char)byte;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "usage: telemetry_view [-f clock_hz] [-r rate] [-t] [file]\n"
+        "       telemetry_view -S [-n records] [-s seed]\n"
+        "  -f  clock the cycle counts were taken with (default 80000000, 1e9 for ultradec -R)\n"
+        "  -r  sampling rate, for the time one frame takes (default 51200)\n"
+        "  -t  list every frame, not only what changed\n"
+        "  -S  check that records round trip through the encoder and the parser\n"
+        "  reads stdin if no file is given or file is -\n");
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    static struct telemetry_parser parser;
+    struct telemetry_record rec, last;
+    uint8_t chunk[CHUNK_SIZE], rest[TELEMETRY_COBS_SIZE];
+    char line[LINE_SIZE];
+    FILE* file = stdin;
+    double us, t = 0.0;
+    long undetected_code = 0;
+    uint32_t missing = 0, dropped = 0;
+    size_t got, i = 0;
+    int opt, count = 1000000, length = 0, text, n = 0;
+    bool test = false, have_last = false;
+
+    while ((opt = getopt(argc, argv, "f:r:tSn:s:h")) != -1) {
+        switch (opt) {
+        case 'f':
+            clock_hz = atof(optarg);
+            break;
+        case 'r':
+            frame_us = 1e6 * NUM_SAMPLES / atof(optarg);
+            break;
+        case 't':
+            full_timeline = true;
+            break;
+        case 'S':
+            test = true;
+            break;
+        case 'n':
+            count = atoi(optarg);
+            break;
+        case 's':
+            rng_state = strtoull(optarg, NULL, 0) | 1;
+            break;
+        default:
+            usage();
+        }
+    }
+    if (clock_hz <= 0 || frame_us <= 0 || count <= 0)
+        usage();
+    if (test)
+        return self_test(count, &undetected_code);
+
+    if (optind < argc && strcmp(argv[optind], "-")) {
+        file = fopen(argv[optind], "rb");
+        if (!file) {
+            perror(argv[optind]);
+            return 1;
+        }
+    }
+
+    memset(&last, 0, sizeof(last));
+    telemetry_parser_init(&parser);
+    while ((got = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        for (i = 0; i < got; i++) {
+            if (telemetry_parser_push(&parser, chunk[i], &rec, &text)) {
+                us = 1e6 * rec.cycles / clock_hz;
+                t = (double)(rec.sequence + 1) * frame_us / 1e6;
+                show_record(&rec, &last, have_last, us);
+                account(&rec, us);
+                if (have_last && rec.sequence - last.sequence - 1 > rec.dropped)
+                    missing += rec.sequence - last.sequence - 1 - rec.dropped;
+                dropped += rec.dropped;
+                last = rec;
+                have_last = true;
+            }
+            if (text >= 0)
+                show_text(line, &length, text, t);
+        }
+    }
+    n = telemetry_parser_flush(&parser, rest);
+    for (i = 0; i < (size_t)n; i++)
+        show_text(line, &length, rest[i], t);
+    show_text(line, &length, '\n', t);
+    if (file != stdin)
+        fclose(file);
+
+    print_statistics(&parser, missing, dropped);
+
+    return 0;
+}
@@ -0,0 +1,458 @@
+//*****************************************************************************
+//
+// ultrabatch.c - Decode archives of recordings on every core
+//
+// Every file (or every channel of every file with -a) is one task. Tasks are
+// spread over per-thread deques; a thread works through its own deque from
+// the back and steals from the front of the others when it runs dry, so a
+// few long recordings don't leave the other cores idle. One JSON object per
+// task is written to stdout as it finishes, followed by a summary object with
+// the aggregate throughput.
+//
+// Build (from this directory):
+//   cc -O2 -I.. -o ultrabatch ultrabatch.c pcm_source.c ../decoder.c
+//      ../goertzel.c ../sliding_goertzel.c ../symbol_sync.c ../fft.c
+//      ../energy_gate.c ../noise_floor.c ../fec.c ../packet.c
+//      ../freq_plan.c ../diversity.c ../ofdm.c ../nco.c -lm -lpthread
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "decoder.h"
+#include "pcm_source.h"
+
+#define MAX_THREADS 256
+
+//*****************************************************************************
+// One recording channel to decode and what came out of it. Messages are kept
+// as a ready made JSON array body so printing needs no further work.
+//*****************************************************************************
+struct task {
+    const char* path;
+    int channel;
+    struct decoder* dec;
+    char* json;
+    size_t json_len, json_size;
+    double lock_time;
+    bool in_message;
+    unsigned long messages;
+    unsigned long failures;
+    unsigned long retunes;
+    unsigned long rejected;
+    uint64_t samples;
+    double audio;
+    int error;
+};
+
+//*****************************************************************************
+// Deque of task indexes owned by one thread
+//*****************************************************************************
+struct worker {
+    pthread_t thread;
+    pthread_mutex_t lock;
+    int* tasks;
+    int head, tail;
+    unsigned long stolen;
+};
+
+static struct task* tasks;
+static int num_tasks;
+static int num_files;                   // Files the tasks came from
+static struct worker workers[MAX_THREADS];
+static int num_workers;
+static enum MODULATION modulation = OOK;
+static enum FEC_CODE coding = FEC_NONE;
+static bool packets = false;
+static enum SAMPLE_FORMAT format = FORMAT_S16;
+static uint32_t sample_rate = 51200;
+static pthread_mutex_t output_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void json_append(struct task* task, const char* text, size_t len)
+{
+    if (task->json_len + len + 1 > task->json_size) {
+        task->json_size = (task->json_len + len + 1) * 2;
+        task->json = realloc(task->json, task->json_size);
+        if (!task->json) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    memcpy(task->json + task->json_len, text, len);
+    task->json_len += len;
+    task->json[task->json_len] = 0;
+}
+
+static void json_string(FILE* out, const char* text)
+{
+    fputc('"', out);
+    for (; *text; text++) {
+        if (*text == '"' || *text == '\\')
+            fprintf(out, "\\%c", *text);
+        else if ((unsigned char)*text < 0x20)
+            fprintf(out, "\\u%04x", *text);
+        else
+            fputc(*text, out);
+    }
+    fputc('"', out);
+}
+
+static double task_time(struct task* task)
+{
+    return (double)task->dec->frames * NUM_SAMPLES / task->dec->sample_rate;
+}
+
+static void close_message(struct task* task, bool complete)
+{
+    if (!task->in_message)
+        return;
+    if (complete)
+        json_append(task, "\"}", 2);
+    else
+        json_append(task, "\",\"incomplete\":true}", 20);
+    task->in_message = false;
+    task->messages++;
+}
+
+static void on_event(void* ctx, enum DECODER_EVENT event, int value)
+{
+    struct task* task = ctx;
+    char buf[64];
+    int len, i = 0;
+
+    switch (event) {
+    case DECODER_LOCK:
+        close_message(task, false);
+        task->lock_time = task_time(task);
+        break;
+    case DECODER_CHAR:
+        if (!task->in_message) {
+            len = snprintf(buf, sizeof(buf), "%s{\"t\":%.3f,\"text\":\"", task->messages ? "," : "", task->lock_time);
+            json_append(task, buf, len);
+            task->in_message = true;
+        }
+        if (value == '"' || value == '\\')
+            len = snprintf(buf, sizeof(buf), "\\%c", value);
+        else if (value < 0x20 || value >= 0x7f)
+            len = snprintf(buf, sizeof(buf), "\\u%04x", value);
+        else
+            len = snprintf(buf, sizeof(buf), "%c", value);
+        json_append(task, buf, len);
+        break;
+    case DECODER_END:
+        close_message(task, true);
+        break;
+    case DECODER_SYNC_FAILED:
+        task->failures++;
+        break;
+    case DECODER_RETUNE:
+        task->retunes++;
+        break;
+    case DECODER_RATE:
+        break;
+    case DECODER_PACKET:
+        // Packets may carry anything, so the payload goes out in hex
+        len = snprintf(buf, sizeof(buf), "%s{\"t\":%.3f,\"seq\":%u,\"hex\":\"", task->messages ? "," : "",
+            task->lock_time, task->dec->packet.sequence);
+        json_append(task, buf, len);
+        for (i = 0; i < value; i++) {
+            len = snprintf(buf, sizeof(buf), "%02x", task->dec->packet.payload[i]);
+            json_append(task, buf, len);
+        }
+        json_append(task, "\"}", 2);
+        task->messages++;
+        break;
+    case DECODER_PACKET_REJECTED:
+        task->rejected++;
+        break;
+    }
+}
+
+static void run_task(struct task* task)
+{
+    struct pcm_source src;
+    struct decoder dec;
+    int16_t frame[NUM_SAMPLES];
+
+    if (pcm_open(&src, task->path, format, sample_rate)) {
+        task->error = 1;
+        return;
+    }
+
+    task->dec = &dec;
+    if (task->channel >= src.channels || decoder_init(&dec, src.sample_rate, modulation, on_event, task)) {
+        task->error = 1;
+        pcm_close(&src);
+        return;
+    }
+    dec.coding = coding;
+    dec.packets = packets;
+
+    while (pcm_read_frame(&src, task->channel, frame, NUM_SAMPLES) == NUM_SAMPLES)
+        decoder_process(&dec, frame);
+
+    // A message cut off by the end of the recording still gets reported
+    close_message(task, false);
+
+    task->samples = (uint64_t)dec.frames * NUM_SAMPLES;
+    task->audio = task_time(task);
+    pcm_close(&src);
+}
+
+static void print_task(struct task* task)
+{
+    pthread_mutex_lock(&output_lock);
+    fputs("{\"file\":", stdout);
+    json_string(stdout, task->path);
+    printf(",\"channel\":%d", task->channel);
+    if (task->error) {
+        fputs(",\"error\":true}\n", stdout);
+    } else {
+        printf(",\"samples\":%llu,\"audio_s\":%.3f,\"sync_failures\":%lu,",
+            (unsigned long long)task->samples, task->audio, task->failures);
+        if (packets)
+            printf("\"rejected_packets\":%lu,", task->rejected);
+        printf("\"messages\":[%s]}\n", task->json ? task->json : "");
+    }
+    fflush(stdout);
+    pthread_mutex_unlock(&output_lock);
+
+    free(task->json);
+    task->json = NULL;
+}
+
+//*****************************************************************************
+// Take from the back of our own deque, otherwise the front of someone else's
+//*****************************************************************************
+static int next_task(struct worker* self)
+{
+    struct worker* victim;
+    int index = -1, i = 0;
+
+    pthread_mutex_lock(&self->lock);
+    if (self->tail > self->head)
+        index = self->tasks[--self->tail];
+    pthread_mutex_unlock(&self->lock);
+    if (index >= 0)
+        return index;
+
+    for (i = 1; i < num_workers && index < 0; i++) {
+        victim = &workers[(self - workers + i) % num_workers];
+        pthread_mutex_lock(&victim->lock);
+        if (victim->tail > victim->head)
+            index = victim->tasks[victim->head++];
+        pthread_mutex_unlock(&victim->lock);
+    }
+    if (index >= 0)
+        self->stolen++;
+
+    return index;
+}
+
+static void* worker_main(void* arg)
+{
+    struct worker* self = arg;
+    int index;
+
+    while ((index = next_task(self)) >= 0) {
+        run_task(&tasks[index]);
+        print_task(&tasks[index]);
+    }
+
+    return NULL;
+}
+
+static void add_task(const char* path, int channel)
+{
+    static int allocated = 0;
+
+    if (num_tasks == allocated) {
+        allocated = allocated ? allocated * 2 : 256;
+        tasks = realloc(tasks, allocated * sizeof(*tasks));
+        if (!tasks) {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    memset(&tasks[num_tasks], 0, sizeof(*tasks));
+    tasks[num_tasks].path = path;
+    tasks[num_tasks].channel = channel;
+    num_tasks++;
+}
+
+//*****************************************************************************
+// Queue one file, or one task per channel when all channels are wanted
+//*****************************************************************************
+static void add_file(const char* path, bool all_channels, int channel)
+{
+    struct pcm_source src;
+    int channels = 1, i = 0;
+
+    // stdin can only be read once, so it is never split by channel
+    if (all_channels && strcmp(path, "-")) {
+        if (pcm_open(&src, path, format, sample_rate))
+            return;
+        channels = src.channels;
+        pcm_close(&src);
+        for (i = 0; i < channels; i++)
+            add_task(path, i);
+    } else {
+        add_task(path, channel);
+    }
+    num_files++;
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "usage: ultrabatch [-j threads] [-a | -c channel] [-m ook|mfsk|dbpsk|dqpsk|ofdm] [-e code] [-p]\n"
+        "                  [-f s16|adc] [-r rate] [-l list] [file...]\n"
+        "  -j  worker threads (default: number of cores)\n"
+        "  -a  decode every channel of every file as its own task\n"
+        "  -c  channel to decode (default 0)\n"
+        "  -l  read file names, one per line, from list (- for stdin)\n"
+        "  -m, -e, -p, -f, -r as for ultradec\n");
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    struct timespec start, end;
+    bool all_channels = false;
+    const char* list = NULL;
+    char line[4096];
+    FILE* fp;
+    double wall, audio = 0;
+    uint64_t samples = 0;
+    unsigned long messages = 0, failures = 0, errors = 0, stolen = 0;
+    int opt, channel = 0, per_worker, i = 0, j = 0;
+    size_t len;
+
+    num_workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+    while ((opt = getopt(argc, argv, "j:ac:m:e:pf:r:l:h")) != -1) {
+        switch (opt) {
+        case 'j':
+            num_workers = atoi(optarg);
+            break;
+        case 'a':
+            all_channels = true;
+            break;
+        case 'c':
+            channel = atoi(optarg);
+            break;
+        case 'm':
+            if (!strcmp(optarg, "mfsk"))
+                modulation = MFSK;
+            else if (!strcmp(optarg, "dbpsk"))
+                modulation = DBPSK;
+            else if (!strcmp(optarg, "dqpsk"))
+                modulation = DQPSK;
+            else if (!strcmp(optarg, "ofdm"))
+                modulation = OFDM;
+            else if (strcmp(optarg, "ook"))
+                usage();
+            break;
+        case 'e':
+            if (!strcmp(optarg, "hamming"))
+                coding = FEC_HAMMING;
+            else if (!strcmp(optarg, "conv"))
+                coding = FEC_CONVOLUTIONAL;
+            else if (strcmp(optarg, "none"))
+                usage();
+            break;
+        case 'p':
+            packets = true;
+            break;
+        case 'f':
+            if (!strcmp(optarg, "adc"))
+                format = FORMAT_ADC;
+            else if (strcmp(optarg, "s16"))
+                usage();
+            break;
+        case 'r':
+            sample_rate = strtoul(optarg, NULL, 0);
+            break;
+        case 'l':
+            list = optarg;
+            break;
+        default:
+            usage();
+        }
+    }
+    if (num_workers < 1)
+        num_workers = 1;
+    if (num_workers > MAX_THREADS)
+        num_workers = MAX_THREADS;
+
+    for (i = optind; i < argc; i++)
+        add_file(argv[i], all_channels, channel);
+
+    if (list) {
+        fp = strcmp(list, "-") ? fopen(list, "r") : stdin;
+        if (!fp) {
+            perror(list);
+            return 1;
+        }
+        while (fgets(line, sizeof(line), fp)) {
+            len = strcspn(line, "\r\n");
+            line[len] = 0;
+            if (len)
+                add_file(strdup(line), all_channels, channel);
+        }
+        if (fp != stdin)
+            fclose(fp);
+    }
+
+    if (!num_tasks)
+        usage();
+    if (num_workers > num_tasks)
+        num_workers = num_tasks;
+
+    // Deal the tasks out round robin, stealing evens out the rest
+    per_worker = (num_tasks + num_workers - 1) / num_workers;
+    for (i = 0; i < num_workers; i++) {
+        pthread_mutex_init(&workers[i].lock, NULL);
+        workers[i].tasks = malloc(per_worker * sizeof(int));
+        workers[i].head = workers[i].tail = 0;
+    }
+    for (i = 0; i < num_tasks; i++) {
+        j = i % num_workers;
+        workers[j].tasks[workers[j].tail++] = i;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for (i = 0; i < num_workers; i++)
+        pthread_create(&workers[i].thread, NULL, worker_main, &workers[i]);
+    for (i = 0; i < num_workers; i++) {
+        pthread_join(workers[i].thread, NULL);
+        stolen += workers[i].stolen;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    wall = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    for (i = 0; i < num_tasks; i++) {
+        samples += tasks[i].samples;
+        audio += tasks[i].audio;
+        messages += tasks[i].messages;
+        failures += tasks[i].failures;
+        errors += tasks[i].error;
+    }
+
+    printf("{\"summary\":{\"files\":%d,\"tasks\":%d,\"errors\":%lu,\"threads\":%d,\"stolen\":%lu,\"messages\":%lu,"
+        "\"sync_failures\":%lu,\"samples\":%llu,\"audio_s\":%.3f,\"wall_s\":%.3f,"
+        "\"samples_per_s\":%.0f,\"files_per_s\":%.2f,\"tasks_per_s\":%.2f,\"real_time_factor\":%.1f}}\n",
+        num_files, num_tasks, errors, num_workers, stolen, messages, failures, (unsigned long long)samples,
+        audio, wall, wall > 0 ? samples / wall : 0.0, wall > 0 ? num_files / wall : 0.0,
+        wall > 0 ? num_tasks / wall : 0.0, wall > 0 ? audio / wall : 0.0);
+
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,299 @@
+//*****************************************************************************
+//
+// ultradec.c - Decode recordings on a PC with the receiver's decoder engine
+//
+// Reads a WAV file or raw 16 bit samples from a file (memory mapped) or from
+// stdin and prints each decoded message with the time its start sequence was
+// found. Memory use does not depend on the length of the recording.
+// -R writes a telemetry record for every frame like a TELEMETRY=1 receiver
+// does, with the time in nanoseconds: telemetry_view -f 1e9 reads it.
+//
+// Build (from this directory):
+//   cc -O2 -I.. -o ultradec ultradec.c pcm_source.c ../decoder.c
+//      ../goertzel.c ../sliding_goertzel.c ../symbol_sync.c ../fft.c
+//      ../energy_gate.c ../noise_floor.c ../fec.c ../packet.c
+//      ../telemetry.c ../cobs.c ../freq_plan.c ../diversity.c
+//      ../ofdm.c ../nco.c -lm
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "decoder.h"
+#include "telemetry.h"
+#include "pcm_source.h"
+
+#define MAX_MESSAGE 4096
+
+//*****************************************************************************
+// Message being collected between the start sequence and the stop byte
+//*****************************************************************************
+struct message {
+    struct decoder* dec;
+    double lock_time;
+    int lock_snr;
+    bool show_snr;
+    char text[MAX_MESSAGE + 1];
+    int length;
+    unsigned long messages;
+    unsigned long failures;
+};
+
+static double now_seconds(struct decoder* dec)
+{
+    return (double)dec->frames * NUM_SAMPLES / dec->sample_rate;
+}
+
+static void print_message(struct message* msg, const char* note)
+{
+    msg->text[msg->length] = 0;
+    if (msg->show_snr)
+        printf("[%10.3f] (%d dB) %s%s\n", msg->lock_time, msg->lock_snr, msg->text, note);
+    else
+        printf("[%10.3f] %s%s\n", msg->lock_time, msg->text, note);
+    fflush(stdout);
+    msg->length = 0;
+}
+
+//*****************************************************************************
+// Payload of a packet as text, or in hex if it is not all printable
+//*****************************************************************************
+static void print_packet(struct message* msg, int length)
+{
+    const uint8_t* payload = msg->dec->packet.payload;
+    bool text = true;
+    int i = 0;
+
+    for (i = 0; i < length; i++)
+        text = text && payload[i] >= 0x20 && payload[i] < 0x7f;
+
+    if (msg->show_snr)
+        printf("[%10.3f] (%d dB) #%u ", msg->lock_time, msg->lock_snr, msg->dec->packet.sequence);
+    else
+        printf("[%10.3f] #%u ", msg->lock_time, msg->dec->packet.sequence);
+    for (i = 0; i < length; i++)
+        printf(text ? "%c" : "%02x", payload[i]);
+    printf("\n");
+    fflush(stdout);
+    msg->length = 0;
+}
+
+static void on_event(void* ctx, enum DECODER_EVENT event, int value)
+{
+    struct message* msg = ctx;
+
+    switch (event) {
+    case DECODER_LOCK:
+        msg->lock_time = now_seconds(msg->dec);
+        msg->lock_snr = value;
+        msg->length = 0;
+        break;
+    case DECODER_CHAR:
+        if (msg->length == MAX_MESSAGE)
+            print_message(msg, " (continued)");
+        msg->text[msg->length++] = (value >= 0x20 && value < 0x7f) ? value : '.';
+        break;
+    case DECODER_END:
+        print_message(msg, "");
+        msg->messages++;
+        break;
+    case DECODER_SYNC_FAILED:
+        printf("[%10.3f] Synchronization Failed\n", now_seconds(msg->dec));
+        msg->length = 0;
+        msg->failures++;
+        break;
+    case DECODER_RETUNE:
+        printf("[%10.3f] Carrier found at %d Hz\n", now_seconds(msg->dec), value);
+        break;
+    case DECODER_RATE:
+        printf("[%10.3f] Switched to rate profile %d\n", now_seconds(msg->dec), value);
+        break;
+    case DECODER_PACKET:
+        print_packet(msg, value);
+        msg->messages++;
+        break;
+    case DECODER_PACKET_REJECTED:
+        printf("[%10.3f] Packet rejected (%s)\n", now_seconds(msg->dec),
+            (value == PACKET_BAD_CRC) ? "bad CRC" : (value == PACKET_BAD_SYNC) ? "no sync word" : "bad header");
+        msg->length = 0;
+        break;
+    }
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+//*****************************************************************************
+// Decode a frame and write its telemetry record
+//*****************************************************************************
+static void process_recorded(struct decoder* dec, const int16_t* frame, FILE* record)
+{
+    struct telemetry_record rec;
+    uint8_t encoded[TELEMETRY_ENCODED_SIZE];
+    uint64_t started = now_ns(), spent;
+
+    decoder_process(dec, frame);
+    spent = now_ns() - started;
+
+    telemetry_capture(&rec, dec);
+    rec.sequence = dec->frames - 1;
+    rec.cycles = (spent > 0xFFFFFFFFu) ? 0xFFFFFFFFu : (uint32_t)spent;
+    rec.dropped = 0;
+    fwrite(encoded, 1, telemetry_encode(&rec, encoded), record);
+}
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "usage: ultradec [-m ook|mfsk|dbpsk|dqpsk|ofdm] [-e none|hamming|conv] [-p] [-f s16|adc] [-r rate] [-c channel] [-G] [-T] [-s] [-R record] [file]\n"
+        "  -m  modulation after the start sequence (default ook)\n"
+        "  -e  error correcting code on OOK data (default none)\n"
+        "  -p  data is packets with a CRC instead of text ended by a zero byte\n"
+        "  -f  raw sample format, s16 audio or 12 bit adc readings (default s16)\n"
+        "  -r  sampling rate of raw input (default 51200, WAV files carry their own)\n"
+        "  -c  channel to decode from multichannel input (default 0)\n"
+        "  -G  run the detectors on every frame instead of only when the energy gate opens\n"
+        "  -T  detect carriers at a fixed level instead of relative to the noise floor\n"
+        "  -s  show the SNR of each start sequence\n"
+        "  -R  write a telemetry record of every frame to a file, for telemetry_view -f 1e9\n"
+        "  reads stdin if no file is given or file is -\n");
+    exit(2);
+}
+
+int main(int argc, char** argv)
+{
+    struct pcm_source src;
+    struct decoder dec;
+    struct message msg;
+    enum MODULATION modulation = OOK;
+    enum FEC_CODE coding = FEC_NONE;
+    enum SAMPLE_FORMAT format = FORMAT_S16;
+    uint32_t sample_rate = 51200;
+    int16_t frame[NUM_SAMPLES];
+    const char* path = NULL;
+    FILE* record = NULL;
+    clock_t started;
+    double cpu, audio;
+    int opt, channel = 0;
+    bool gating = true, adaptive = true, packets = false;
+
+    memset(&msg, 0, sizeof(msg));
+
+    while ((opt = getopt(argc, argv, "m:e:pf:r:c:GTsR:h")) != -1) {
+        switch (opt) {
+        case 'm':
+            if (!strcmp(optarg, "mfsk"))
+                modulation = MFSK;
+            else if (!strcmp(optarg, "dbpsk"))
+                modulation = DBPSK;
+            else if (!strcmp(optarg, "dqpsk"))
+                modulation = DQPSK;
+            else if (!strcmp(optarg, "ofdm"))
+                modulation = OFDM;
+            else if (strcmp(optarg, "ook"))
+                usage();
+            break;
+        case 'e':
+            if (!strcmp(optarg, "hamming"))
+                coding = FEC_HAMMING;
+            else if (!strcmp(optarg, "conv"))
+                coding = FEC_CONVOLUTIONAL;
+            else if (strcmp(optarg, "none"))
+                usage();
+            break;
+        case 'p':
+            packets = true;
+            break;
+        case 'f':
+            if (!strcmp(optarg, "adc"))
+                format = FORMAT_ADC;
+            else if (strcmp(optarg, "s16"))
+                usage();
+            break;
+        case 'r':
+            sample_rate = strtoul(optarg, NULL, 0);
+            break;
+        case 'c':
+            channel = atoi(optarg);
+            break;
+        case 'G':
+            gating = false;
+            break;
+        case 'T':
+            adaptive = false;
+            break;
+        case 's':
+            msg.show_snr = true;
+            break;
+        case 'R':
+            record = fopen(optarg, "wb");
+            if (!record) {
+                perror(optarg);
+                return 1;
+            }
+            break;
+        default:
+            usage();
+        }
+    }
+    if (optind < argc)
+        path = argv[optind];
+
+    if (pcm_open(&src, path, format, sample_rate))
+        return 1;
+    if (channel < 0 || channel >= src.channels) {
+        fprintf(stderr, "input has %d channel(s)\n", src.channels);
+        return 1;
+    }
+
+    msg.dec = &dec;
+    if (decoder_init(&dec, src.sample_rate, modulation, on_event, &msg)) {
+        fprintf(stderr, "carriers are not on a %d point bin at %u Hz\n", NUM_SAMPLES, src.sample_rate);
+        return 1;
+    }
+    dec.energy_gating = gating;
+    dec.adaptive_threshold = adaptive;
+    dec.coding = coding;
+    dec.packets = packets;
+
+    started = clock();
+    while (pcm_read_frame(&src, channel, frame, NUM_SAMPLES) == NUM_SAMPLES) {
+        if (record)
+            process_recorded(&dec, frame, record);
+        else
+            decoder_process(&dec, frame);
+    }
+
+    if (dec.transfer_status && msg.length)
+        print_message(&msg, " (incomplete)");
+
+    cpu = (double)(clock() - started) / CLOCKS_PER_SEC;
+    audio = now_seconds(&dec);
+    fprintf(stderr, "%lu message(s), %lu sync failure(s), %.1f s of audio in %.2f s (%.0fx real time)\n",
+        msg.messages, msg.failures, audio, cpu, cpu > 0 ? audio / cpu : 0.0);
+    if (packets)
+        fprintf(stderr, "%u packet(s) rejected: %u without sync word, %u bad header, %u bad CRC\n",
+            dec.packet.sync_errors + dec.packet.header_errors + dec.packet.crc_errors,
+            dec.packet.sync_errors, dec.packet.header_errors, dec.packet.crc_errors);
+    if (gating && dec.gate.frames)
+        fprintf(stderr, "energy gate open for %.1f%% of %u idle frames\n",
+            100.0 * dec.gate.open_frames / dec.gate.frames, dec.gate.frames);
+
+    pcm_close(&src);
+    if (record)
+        fclose(record);
+
+    return 0;
+}
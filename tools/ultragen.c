@@ -0,0 +1,607 @@
+//*****************************************************************************
+//
+// ultragen.c - Write transmissions for the receiver to a WAV file
+//
+// Runs the reference transmitter (transmitter.c) over each message given on
+// the command line, or each line of stdin, with gap seconds of silence
+// before, between and after them, rounded up so every message starts on a
+// receiver frame. The output is a 16 bit mono WAV file, or stdout for a
+// sound card:
+//   ./ultragen "hello" | aplay
+// Timing and tones are exact, so the files are deterministic test vectors
+// for ultradec and the benchmarks. -S sends random messages in every mode
+// through the decoder and checks they all come back, also switching to every
+// rate profile and back on every other message, checks the oscillator
+// against sin() and the phase steps the complex Goertzel reads from it, and
+// feeds OFDM symbols straight into the demodulator.
+//
+// Build (from this directory):
+//   cc -O2 -I.. -o ultragen ultragen.c pcm_sink.c ../transmitter.c ../nco.c
+//      ../decoder.c ../goertzel.c ../sliding_goertzel.c ../symbol_sync.c
+//      ../fft.c ../energy_gate.c ../noise_floor.c ../fec.c ../packet.c
+//      ../freq_plan.c ../diversity.c ../ofdm.c -lm
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+#include "goertzel.h"
+#include "transmitter.h"
+#include "pcm_sink.h"
+
+#define BLOCK_SIZE 4096
+#define MAX_LINE 1024
+#define TEST_MESSAGES 12
+#define TEST_LENGTH 40
+
+static const char* const modulation_names[] = { "ook", "mfsk", "dbpsk", "dqpsk", "ofdm" };
+static const char* const code_names[] = { "none", "hamming", "conv" };
+
+static bool packets;
+static double gap_seconds = 1.0;
+static uint32_t sequence;
+static int32_t clock_ppm;
+static int profile;
+
+static void usage(void)
+{
+    fprintf(stderr,
+        "usage: ultragen [-m ook|mfsk|dbpsk|dqpsk|ofdm] [-e none|hamming|conv] [-R profile] [-p] [-r rate] [-a amplitude] [-g gap] [-o file] [-S] [message...]\n"
+        "  -m  modulation after the start sequence (default ook)\n"
+        "  -e  error correcting code on OOK data (default none)\n"
+        "  -R  announce rate profile 1-15 in the start sequence and send with it, see decoder.h\n"
+        "  -p  send each message as a packet with a CRC instead of text ended by a zero byte\n"
+        "  -r  sample rate of the output (default 51200)\n"
+        "  -a  peak level of the tones, 0 to 1 of full scale (default 0.125)\n"
+        "  -g  seconds of silence around the messages (default 1)\n"
+        "  -o  WAV file to write (default stdout)\n"
+        "  -S  self-test: decode random messages in every mode and check the oscillator\n"
+        "  reads one message per line from stdin if none are given\n");
+    exit(2);
+}
+
+//*****************************************************************************
+// Silence, in blocks
+//*****************************************************************************
+static int write_silence(struct pcm_sink* sink, uint32_t samples)
+{
+    int16_t block[BLOCK_SIZE] = { 0 };
+    int count;
+
+    while (samples) {
+        count = (samples < BLOCK_SIZE) ? samples : BLOCK_SIZE;
+        if (pcm_write(sink, block, count) != count)
+            return -1;
+        samples -= count;
+    }
+
+    return 0;
+}
+
+//*****************************************************************************
+// Silence of at least gap seconds after written samples, long enough for the
+// next message to start its first bit on a frame boundary of a receiver that
+// started with the file. OOK and DPSK do not need it, MFSK symbols are read
+// on those frames.
+//*****************************************************************************
+static uint32_t gap_samples(uint32_t written, uint32_t sample_rate)
+{
+    uint64_t end = written + TX_LEAD_SAMPLES + (uint64_t)(gap_seconds * sample_rate);
+    uint64_t frame = (uint64_t)NUM_SAMPLES * sample_rate;
+    uint64_t frames = (end * PLAN_SAMPLE_RATE + frame - 1) / frame;
+
+    return (uint32_t)(frames * frame / PLAN_SAMPLE_RATE - TX_LEAD_SAMPLES - written);
+}
+
+//*****************************************************************************
+// One message and the gap after it
+//*****************************************************************************
+static int send(struct transmitter* tx, struct pcm_sink* sink, const char* text, int length)
+{
+    int16_t block[BLOCK_SIZE];
+    int count;
+
+    if (packets)
+        count = transmitter_send_packet(tx, 0, (uint8_t)sequence++, 0, (const uint8_t*)text, length);
+    else
+        count = transmitter_send_text(tx, text, length);
+    if (count < 0) {
+        fprintf(stderr, "message too long: %.20s...\n", text);
+        return -1;
+    }
+
+    while ((count = transmitter_generate(tx, block, BLOCK_SIZE)) > 0) {
+        if (pcm_write(sink, block, count) != count)
+            return -1;
+    }
+
+    return write_silence(sink, gap_samples(sink->frames, tx->sample_rate));
+}
+
+//*****************************************************************************
+// Self-test
+//*****************************************************************************
+static uint32_t random_state = 1;
+
+static uint32_t random32(void)
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+struct loopback {
+    struct decoder dec;
+    char text[TX_MAX_MESSAGE];
+    int length;
+    char received[TEST_MESSAGES][TX_MAX_MESSAGE];
+    int count;
+    int failures;
+    int switches;
+};
+
+static void on_event(void* ctx, enum DECODER_EVENT event, int value)
+{
+    struct loopback* lb = ctx;
+
+    switch (event) {
+    case DECODER_LOCK:
+        lb->length = 0;
+        break;
+    case DECODER_CHAR:
+        if (lb->length < TX_MAX_MESSAGE - 1)
+            lb->text[lb->length++] = (char)value;
+        break;
+    case DECODER_END:
+        lb->text[lb->length] = 0;
+        if (lb->count < TEST_MESSAGES)
+            strcpy(lb->received[lb->count], lb->text);
+        lb->count++;
+        break;
+    case DECODER_PACKET:
+        if (lb->count < TEST_MESSAGES) {
+            memcpy(lb->received[lb->count], lb->dec.packet.payload, value);
+            lb->received[lb->count][value] = 0;
+        }
+        lb->count++;
+        break;
+    case DECODER_SYNC_FAILED:
+    case DECODER_PACKET_REJECTED:
+        lb->failures++;
+        break;
+    case DECODER_RATE:
+        lb->switches++;
+        break;
+    case DECODER_RETUNE:
+        break;
+    }
+}
+
+//*****************************************************************************
+// Send random messages with random gaps in one mode and decode them. With a
+// profile set every other message announces it, the receiver has to switch
+// to it and back. Returns the number of messages that did not come back
+// exactly.
+//*****************************************************************************
+static int loopback_test(enum MODULATION modulation, enum FEC_CODE coding)
+{
+    static char sent[TEST_MESSAGES][TEST_LENGTH + 1];
+    static struct loopback lb;
+    struct transmitter tx;
+    int16_t samples[NUM_SAMPLES], frame[NUM_SAMPLES];
+    int msg = 0, length, gap, fill = 0, count, i, errors = 0, switched = 0;
+
+    memset(&lb, 0, sizeof(lb));
+    transmitter_init(&tx, PLAN_SAMPLE_RATE, modulation, coding);
+    tx.clock_ppm = clock_ppm;
+    decoder_init(&lb.dec, PLAN_SAMPLE_RATE, modulation, on_event, &lb);
+    lb.dec.coding = coding;
+    lb.dec.packets = packets;
+
+    for (msg = 0; msg <= TEST_MESSAGES; msg++) {
+        if (profile && msg < TEST_MESSAGES && !transmitter_set_profile(&tx, (msg & 1) ? RATE_DEFAULT : profile))
+            switched += !(msg & 1);
+
+        // Gaps of a second or so that leave OOK and DPSK messages anywhere
+        // in a frame. MFSK symbols are read on the receiver's frames, so
+        // those messages start on one.
+        gap = PLAN_SAMPLE_RATE / 2 + random32() % PLAN_SAMPLE_RATE;
+        if (tx.modulation == MFSK)
+            gap += NUM_SAMPLES - (gap + fill + TX_LEAD_SAMPLES) % NUM_SAMPLES;
+        if (msg < TEST_MESSAGES) {
+            length = 1 + random32() % TEST_LENGTH;
+            for (i = 0; i < length; i++)
+                sent[msg][i] = (char)(' ' + random32() % 95);
+            sent[msg][length] = 0;
+            if (packets)
+                transmitter_send_packet(&tx, 0, (uint8_t)msg, 0, (const uint8_t*)sent[msg], length);
+            else
+                transmitter_send_text(&tx, sent[msg], length);
+        }
+
+        do {
+            if (gap) {
+                count = (gap < NUM_SAMPLES - fill) ? gap : NUM_SAMPLES - fill;
+                memset(samples + fill, 0, count * sizeof(int16_t));
+                gap -= count;
+            } else {
+                count = transmitter_generate(&tx, samples + fill, NUM_SAMPLES - fill);
+            }
+            fill += count;
+            if (fill == NUM_SAMPLES) {
+                for (i = 0; i < NUM_SAMPLES; i++)
+                    frame[i] = (int16_t)((samples[i] >> 4) + 2048 + (int)(random32() % 5) - 2);
+                decoder_process(&lb.dec, frame);
+                fill = 0;
+            }
+        } while (gap || transmitter_busy(&tx));
+    }
+
+    for (msg = 0; msg < TEST_MESSAGES; msg++) {
+        if (msg >= lb.count || strcmp(sent[msg], lb.received[msg]))
+            errors++;
+    }
+
+    if (profile) {
+        printf("  %-5s %-7s profile %-2d %2d sent, %2d received, %d switch(es), %d failure(s)",
+            modulation_names[tx.modulation], code_names[tx.coding], profile, TEST_MESSAGES, lb.count, lb.switches, lb.failures);
+        if (tx.modulation == OOK)
+            printf(", %d frame(s) a bit", tx.frames_per_bit);
+    } else {
+        printf("  %-5s %-7s %-6s %+4d ppm %2d sent, %2d received, %d failure(s)", modulation_names[modulation],
+            code_names[coding], packets ? "packet" : "text", clock_ppm, TEST_MESSAGES, lb.count, lb.failures);
+    }
+    printf("%s\n", (errors || lb.count != TEST_MESSAGES || lb.failures || lb.switches != switched) ? "  FAILED" : "");
+
+    return errors + lb.failures + abs(lb.count - TEST_MESSAGES) + abs(lb.switches - switched);
+}
+
+//*****************************************************************************
+// The oscillator against sin(), and every sample at full level against the
+// phase the steps of the tones so far add up to, which a tone change or a
+// gap in the keying must not disturb
+//*****************************************************************************
+static int oscillator_test(void)
+{
+    struct transmitter tx;
+    enum MODULATION modulation;
+    double error, worst = 0;
+    uint32_t phase = 0;
+    int16_t sample;
+    int i = 0, failed = 0;
+
+    for (i = 0; i < 1000000; i++) {
+        phase = random32();
+        error = fabs(nco_sin(phase) - 32767.0 * sin(2.0 * M_PI * phase / 4294967296.0));
+        if (error > worst)
+            worst = error;
+    }
+    printf("  nco_sin error at most %.2f LSB of Q15\n", worst);
+    if (worst > 2.0)
+        failed++;
+
+    worst = 0;
+    for (modulation = OOK; modulation <= MFSK; modulation++) {
+        transmitter_init(&tx, PLAN_SAMPLE_RATE, modulation, FEC_NONE);
+        tx.amplitude = 32767;
+        transmitter_send_text(&tx, "phase", 5);
+        phase = 0;
+        while (transmitter_generate(&tx, &sample, 1)) {
+            if (tx.keyed && !tx.ramp) {
+                error = fabs(sample - 32767.0 * sin(2.0 * M_PI * phase / 4294967296.0));
+                if (error > worst)
+                    worst = error;
+            }
+            phase += tx.nco.step;
+        }
+    }
+    printf("  keyed samples at most %.2f LSB from a continuous phase\n", worst);
+    if (worst > 4.0)
+        failed++;
+
+    return failed;
+}
+
+//*****************************************************************************
+// Phase continuous frames of a tone that turns by a random DPSK step at the
+// start of each, on every bin from 15 kHz to 25 kHz with 2 or 4 steps. The
+// steps goertzel_complex() reads from one frame to the next, and the sliding
+// detector from its windows at the frame ends (updated in two pieces, as the
+// decoder does), have to be the ones sent and the turns close to exact.
+//*****************************************************************************
+static double turn_error(int32_t re, int32_t im, int32_t last_re, int32_t last_im, uint32_t step, uint32_t steps)
+{
+    double turn = atan2((double)im * last_re - (double)re * last_im, (double)re * last_re + (double)im * last_im);
+
+    return fabs(remainder(turn - 2.0 * M_PI * step / steps, 2.0 * M_PI)) * 180.0 / M_PI;
+}
+
+static int phase_test(void)
+{
+    struct sliding_goertzel sg;
+    struct nco nco;
+    int16_t tone[NUM_SAMPLES], frame[NUM_SAMPLES];
+    int32_t re = 0, im = 0, last_re = 0, last_im = 0;
+    int32_t slide_re = 0, slide_im = 0, last_slide_re = 0, last_slide_im = 0;
+    int32_t trace[HOPS_PER_FRAME];
+    uint32_t freq, steps, step = 0;
+    double error, worst = 0, worst_slide = 0;
+    int f = 0, i = 0, split = 0, wrong = 0, trials = 0;
+
+    for (freq = 15000; freq <= 25000; freq += PLAN_SAMPLE_RATE / NUM_SAMPLES) {
+        steps = ((freq / 50) % 2) ? 2 : 4;
+        nco_init(&nco);
+        nco.phase = random32();
+        nco_set_freq(&nco, freq, PLAN_SAMPLE_RATE);
+        sliding_goertzel_init(&sg, freq, PLAN_SAMPLE_RATE, HOP_SIZE, HOPS_PER_FRAME);
+
+        for (f = 0; f < 32; f++) {
+            step = random32() % steps;
+            nco.phase += step * (uint32_t)(0x100000000ull / steps);
+            nco_generate(&nco, tone, NUM_SAMPLES, 16384);
+            for (i = 0; i < NUM_SAMPLES; i++)
+                frame[i] = (int16_t)((tone[i] >> 4) + 2048 + (int)(random32() % 5) - 2);
+
+            goertzel_complex(frame, NUM_SAMPLES, goertzel_coeff(freq, PLAN_SAMPLE_RATE),
+                (int)floor(sin(2.0 * M_PI * freq / PLAN_SAMPLE_RATE) * (1 << 14) + 0.5), &re, &im);
+            split = (1 + random32() % HOPS_PER_FRAME) * HOP_SIZE;
+            sliding_goertzel_update(&sg, frame, split, trace);
+            sliding_goertzel_update(&sg, frame + split, NUM_SAMPLES - split, trace);
+            sliding_goertzel_phasor(&sg, &slide_re, &slide_im);
+
+            if (f) {
+                error = turn_error(re, im, last_re, last_im, step, steps);
+                if (error > worst)
+                    worst = error;
+                error = turn_error(slide_re, slide_im, last_slide_re, last_slide_im, step, steps);
+                if (error > worst_slide)
+                    worst_slide = error;
+                if ((uint32_t)goertzel_nearest_phase((int64_t)re * last_re + (int64_t)im * last_im,
+                    (int64_t)im * last_re - (int64_t)re * last_im, steps) != step)
+                    wrong++;
+                if ((uint32_t)goertzel_nearest_phase((int64_t)slide_re * last_slide_re + (int64_t)slide_im * last_slide_im,
+                    (int64_t)slide_im * last_slide_re - (int64_t)slide_re * last_slide_im, steps) != step)
+                    wrong++;
+                trials += 2;
+            }
+            last_re = re;
+            last_im = im;
+            last_slide_re = slide_re;
+            last_slide_im = slide_im;
+        }
+    }
+
+    printf("  DPSK steps: %d of %d read wrong, turns at most %.2f (block) and %.2f (sliding) degrees off\n",
+        wrong, trials, worst, worst_slide);
+
+    return (wrong || worst > 1.0 || worst_slide > 1.0) ? 1 : 0;
+}
+
+//*****************************************************************************
+// OFDM symbols of the transmitter straight into the demodulator, with the
+// window moved from its place by up to all of the guard either way and 1 LSB
+// of noise. Each window has to give back the symbols that went into it.
+//*****************************************************************************
+static int ofdm_test(void)
+{
+    static int16_t samples[64 * NUM_SAMPLES];
+    static int16_t frame[2 * NUM_SAMPLES], spectrum[2 * NUM_SAMPLES];
+    uint8_t sent[OFDM_NUM_DATA], received[OFDM_NUM_DATA], scrambler;
+    char text[TEST_LENGTH + 1];
+    struct transmitter tx;
+    clock_t started;
+    double cpu;
+    int first = TX_LEAD_SAMPLES + 8 * FRAMES_PER_BIT * NUM_SAMPLES;
+    int shift, symbols, symbol, start, bit, i, d, failed = 0, windows = 0, wrong;
+
+    printf("  OFDM symbols wrong with the window moved by:");
+    for (shift = -OFDM_GUARD / 2; shift <= OFDM_GUARD / 2; shift += OFDM_GUARD / 8) {
+        for (i = 0; i < TEST_LENGTH; i++)
+            text[i] = (char)(' ' + random32() % 95);
+        transmitter_init(&tx, PLAN_SAMPLE_RATE, OFDM, FEC_NONE);
+        transmitter_send_text(&tx, text, TEST_LENGTH);
+        memset(samples, 0, sizeof(samples));
+        transmitter_generate(&tx, samples, sizeof(samples) / sizeof(samples[0]));
+        symbols = ((TEST_LENGTH + 1) * 8 + OFDM_BITS_PER_SYMBOL - 1) / OFDM_BITS_PER_SYMBOL;
+
+        wrong = 0;
+        scrambler = OFDM_DATA_SEED;
+        bit = 0;
+        for (symbol = 0; symbol < symbols; symbol++) {
+            start = first + symbol * OFDM_SYMBOL_SAMPLES + OFDM_WINDOW_OFFSET + shift;
+            for (i = 0; i < NUM_SAMPLES; i++)
+                frame[i] = (int16_t)((samples[start + i] >> 4) + 2048 + (int)(random32() % 3) - 1);
+            ofdm_load(frame, 0, frame, 0, spectrum);
+            fft_radix4(spectrum, NUM_SAMPLES);
+            ofdm_demodulate(spectrum, PLAN_BIN(OFDM_BASE_FREQ), received);
+
+            for (d = 0; d < OFDM_NUM_DATA; d++, bit += OFDM_BITS_PER_CARRIER) {
+                sent[d] = (uint8_t)ofdm_scramble(&scrambler, OFDM_BITS_PER_CARRIER);
+                if (bit < TEST_LENGTH * 8)
+                    sent[d] ^= ((uint8_t)text[bit / 8] >> (6 - bit % 8)) & 3;
+                if (sent[d] != received[d])
+                    wrong++;
+            }
+            windows++;
+        }
+        printf(" %+d:%d", shift, wrong);
+        if (wrong && abs(shift) <= OFDM_GUARD / 4)
+            failed++;
+    }
+    printf("\n");
+
+    started = clock();
+    for (i = 0; i < 1000; i++) {
+        ofdm_load(frame, NUM_SAMPLES / 2, frame, 64, spectrum);
+        fft_radix4(spectrum, NUM_SAMPLES);
+        ofdm_demodulate(spectrum, PLAN_BIN(OFDM_BASE_FREQ), received);
+    }
+    cpu = (double)(clock() - started) / CLOCKS_PER_SEC;
+    printf("  OFDM: %d windows, %d bits a symbol, %.1f us to demodulate one\n", windows, OFDM_BITS_PER_SYMBOL, cpu * 1000.0);
+
+    return failed;
+}
+
+static int self_test(void)
+{
+    clock_t started;
+    int16_t samples[BLOCK_SIZE];
+    struct transmitter tx;
+    double cpu, audio = 0;
+    int failed = 0, round = 0, count;
+    enum MODULATION modulation;
+    enum FEC_CODE coding;
+
+    failed += oscillator_test();
+    failed += phase_test();
+    failed += ofdm_test();
+    for (round = 0; round < 2; round++) {
+        packets = round;
+        for (coding = FEC_NONE; coding <= FEC_CONVOLUTIONAL; coding++)
+            failed += loopback_test(OOK, coding);
+        for (modulation = MFSK; modulation <= OFDM; modulation++)
+            failed += loopback_test(modulation, FEC_NONE);
+    }
+
+    // A transmitter clock that is off turns the DPSK carrier a little every
+    // frame, up to 50 degrees at 350ppm, and moves the OFDM windows a little
+    // every symbol
+    packets = false;
+    for (clock_ppm = -350; clock_ppm <= 350; clock_ppm += 700) {
+        failed += loopback_test(DBPSK, FEC_NONE);
+        failed += loopback_test(DQPSK, FEC_NONE);
+        failed += loopback_test(OFDM, FEC_NONE);
+    }
+    clock_ppm = 0;
+
+    // Every profile from and back to the robust default
+    for (profile = 1; profile < RATE_NUM_PROFILES; profile++) {
+        if (rate_profiles[profile].frames_per_bit)
+            failed += loopback_test(OOK, FEC_NONE);
+    }
+    profile = 0;
+
+    // How much faster than real time the transmitter runs
+    transmitter_init(&tx, PLAN_SAMPLE_RATE, MFSK, FEC_NONE);
+    started = clock();
+    for (round = 0; round < 200; round++) {
+        transmitter_send_text(&tx, "The quick brown fox jumps over the lazy dog", 43);
+        while ((count = transmitter_generate(&tx, samples, BLOCK_SIZE)) > 0)
+            audio += (double)count / PLAN_SAMPLE_RATE;
+    }
+    cpu = (double)(clock() - started) / CLOCKS_PER_SEC;
+    printf("  %.0f s of audio in %.2f s (%.0fx real time)\n", audio, cpu, cpu > 0 ? audio / cpu : 0.0);
+
+    printf("%s\n", failed ? "self-test FAILED" : "self-test passed");
+    return failed ? 1 : 0;
+}
+
+int main(int argc, char** argv)
+{
+    struct transmitter tx;
+    struct pcm_sink sink;
+    enum MODULATION modulation = OOK;
+    enum FEC_CODE coding = FEC_NONE;
+    uint32_t sample_rate = PLAN_SAMPLE_RATE;
+    const char* path = NULL;
+    char line[MAX_LINE];
+    double amplitude = 0.125;
+    clock_t started;
+    double cpu, audio;
+    int opt, i = 0, length, messages = 0;
+
+    while ((opt = getopt(argc, argv, "m:e:R:pr:a:g:o:Sh")) != -1) {
+        switch (opt) {
+        case 'm':
+            for (i = 0; i < 5 && strcmp(optarg, modulation_names[i]); i++)
+                ;
+            if (i == 5)
+                usage();
+            modulation = (enum MODULATION)i;
+            break;
+        case 'e':
+            if (!strcmp(optarg, "hamming"))
+                coding = FEC_HAMMING;
+            else if (!strcmp(optarg, "conv"))
+                coding = FEC_CONVOLUTIONAL;
+            else if (strcmp(optarg, "none"))
+                usage();
+            break;
+        case 'R':
+            profile = atoi(optarg);
+            break;
+        case 'p':
+            packets = true;
+            break;
+        case 'r':
+            sample_rate = strtoul(optarg, NULL, 0);
+            break;
+        case 'a':
+            amplitude = atof(optarg);
+            if (amplitude <= 0 || amplitude > 1)
+                usage();
+            break;
+        case 'g':
+            gap_seconds = atof(optarg);
+            if (gap_seconds < 0)
+                usage();
+            break;
+        case 'o':
+            path = optarg;
+            break;
+        case 'S':
+            return self_test();
+        default:
+            usage();
+        }
+    }
+
+    if (transmitter_init(&tx, sample_rate, modulation, coding)) {
+        fprintf(stderr, "tones are not below Nyquist at %u Hz\n", sample_rate);
+        return 1;
+    }
+    if (transmitter_set_profile(&tx, profile)) {
+        fprintf(stderr, "rate profile %d is not assigned or not below Nyquist at %u Hz\n", profile, sample_rate);
+        return 1;
+    }
+    tx.amplitude = (int)(amplitude * 32767 + 0.5);
+
+    if (pcm_create(&sink, path, sample_rate, 1))
+        return 1;
+
+    started = clock();
+    if (write_silence(&sink, gap_samples(0, sample_rate)))
+        return 1;
+    if (optind < argc) {
+        for (i = optind; i < argc; i++, messages++) {
+            if (send(&tx, &sink, argv[i], strlen(argv[i])))
+                return 1;
+        }
+    } else {
+        while (fgets(line, sizeof(line), stdin)) {
+            length = strcspn(line, "\r\n");
+            if (send(&tx, &sink, line, length))
+                return 1;
+            messages++;
+        }
+    }
+    cpu = (double)(clock() - started) / CLOCKS_PER_SEC;
+    audio = (double)sink.frames / sample_rate;
+
+    if (pcm_finish(&sink))
+        return 1;
+
+    fprintf(stderr, "%d message(s), %.1f s of audio in %.2f s (%.0fx real time)\n",
+        messages, audio, cpu, cpu > 0 ? audio / cpu : 0.0);
+
+    return 0;
+}
@@ -0,0 +1,395 @@
+//*****************************************************************************
+//
+// transmitter.c - Reference transmitter for the receiver's protocol
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "goertzel.h"
+#include "transmitter.h"
+
+//*****************************************************************************
+// True if every tone of the modulation is below Nyquist
+//*****************************************************************************
+static bool below_nyquist(uint32_t sample_rate, enum MODULATION modulation)
+{
+    uint32_t highest = (SYNC_TONE_FREQ > DATA_TONE_FREQ) ? SYNC_TONE_FREQ : DATA_TONE_FREQ;
+
+    if (modulation == MFSK && MFSK_BASE_FREQ + (MFSK_NUM_TONES - 1) * MFSK_TONE_SPACING > highest)
+        highest = MFSK_BASE_FREQ + (MFSK_NUM_TONES - 1) * MFSK_TONE_SPACING;
+    if (modulation == OFDM && OFDM_BASE_FREQ + (OFDM_NUM_BINS - 1) * OFDM_BIN_WIDTH > highest)
+        highest = OFDM_BASE_FREQ + (OFDM_NUM_BINS - 1) * OFDM_BIN_WIDTH;
+
+    return 2 * highest < sample_rate;
+}
+
+int transmitter_init(struct transmitter* tx, uint32_t sample_rate, enum MODULATION modulation, enum FEC_CODE coding)
+{
+    if (!below_nyquist(sample_rate, modulation))
+        return -1;
+
+    memset(tx, 0, sizeof(*tx));
+    tx->sample_rate = sample_rate;
+    tx->modulation = modulation;
+    tx->coding = (modulation == OOK) ? coding : FEC_NONE;
+    tx->default_modulation = tx->modulation;
+    tx->default_coding = tx->coding;
+    tx->frames_per_bit = FRAMES_PER_BIT;
+    tx->amplitude = TX_DEFAULT_AMPLITUDE;
+    tx->start_bit = 8;
+    nco_init(&tx->nco);
+    nco_init(&tx->descriptor_nco);
+
+    return 0;
+}
+
+bool transmitter_busy(const struct transmitter* tx)
+{
+    return tx->samples_left || tx->next_ready || tx->start_bit < 8 || tx->bit < tx->bit_count || tx->byte < tx->size;
+}
+
+int transmitter_set_profile(struct transmitter* tx, int profile)
+{
+    const struct rate_profile* rate;
+
+    if (profile < 0 || profile >= RATE_NUM_PROFILES || transmitter_busy(tx))
+        return -1;
+
+    if (profile == RATE_DEFAULT) {
+        tx->modulation = tx->default_modulation;
+        tx->coding = tx->default_coding;
+        tx->frames_per_bit = FRAMES_PER_BIT;
+    } else {
+        rate = &rate_profiles[profile];
+        if (!rate->frames_per_bit || !below_nyquist(tx->sample_rate, rate->modulation))
+            return -1;
+        tx->modulation = rate->modulation;
+        tx->coding = rate->coding;
+        tx->frames_per_bit = rate->frames_per_bit;
+    }
+    tx->profile = profile;
+
+    return 0;
+}
+
+//*****************************************************************************
+// Phase step of a tone, moved by the frequency offset and the clock error
+//*****************************************************************************
+static uint32_t tone_step(struct transmitter* tx, uint32_t freq)
+{
+    struct nco nco;
+
+    nco_set_freq(&nco, (uint32_t)((int32_t)freq + tx->freq_offset), tx->sample_rate);
+    return nco.step + (int32_t)((int64_t)nco.step * tx->clock_ppm / 1000000);
+}
+
+//*****************************************************************************
+// Point the oscillator at a tone. Frequency 0 starts the OFDM subcarriers on
+// the next symbol instead, wound back from their phases by the window offset.
+//*****************************************************************************
+static void set_tone(struct transmitter* tx, uint32_t freq)
+{
+    uint32_t lead = (uint32_t)((uint64_t)OFDM_WINDOW_OFFSET * tx->sample_rate / PLAN_SAMPLE_RATE);
+    int k = 0;
+
+    tx->freq = freq;
+    if (freq) {
+        tx->nco.step = tone_step(tx, freq);
+        return;
+    }
+
+    for (k = 0; k < OFDM_NUM_BINS; k++)
+        tx->carrier_phase[k] = ((uint32_t)tx->next_turns[k] << 30) - tx->carrier_step[k] * lead;
+}
+
+//*****************************************************************************
+// Write n samples of the OFDM subcarriers, each at amplitude divided by
+// sqrt(OFDM_NUM_BINS)
+//*****************************************************************************
+static void ofdm_generate(struct transmitter* tx, int16_t* out, int n, int amplitude)
+{
+    int32_t level = (int32_t)(((int64_t)amplitude << 8) / goertzel_isqrt(OFDM_NUM_BINS << 16));
+    int32_t sum, value;
+    int i = 0, k = 0;
+
+    for (i = 0; i < n; i++) {
+        sum = 0;
+        for (k = 0; k < OFDM_NUM_BINS; k++) {
+            sum += nco_sin(tx->carrier_phase[k]);
+            tx->carrier_phase[k] += tx->carrier_step[k];
+        }
+        value = (int32_t)(((int64_t)sum * level) >> 15);
+        out[i] = (int16_t)((value > 32767) ? 32767 : ((value < -32767) ? -32767 : value));
+    }
+}
+
+static int queue(struct transmitter* tx, int size)
+{
+    int k = 0;
+
+    tx->size = size;
+    tx->byte = 0;
+    tx->start_bit = 0;
+    tx->bit_count = 0;
+    tx->bit = 0;
+    tx->reference = 0;
+    tx->scrambler = OFDM_DATA_SEED;
+    fec_encoder_init(&tx->encoder, tx->coding);
+    for (k = 0; k < OFDM_NUM_BINS; k++)
+        tx->carrier_step[k] = tone_step(tx, OFDM_BASE_FREQ + k * OFDM_BIN_WIDTH);
+
+    tx->descriptor_code = fec_hamming_codeword(tx->profile);
+    tx->descriptor = false;
+    tx->descriptor_ramp = 0;
+    tx->descriptor_nco.step = tone_step(tx, DATA_TONE_FREQ);
+
+    // Silence until the ramp up of the first bit is half way
+    tx->keyed = false;
+    tx->samples_left = TX_LEAD_SAMPLES;
+    set_tone(tx, SYNC_TONE_FREQ);
+
+    return 0;
+}
+
+int transmitter_send_text(struct transmitter* tx, const char* text, int length)
+{
+    if (transmitter_busy(tx) || length >= TX_MAX_MESSAGE || memchr(text, 0, length))
+        return -1;
+
+    memcpy(tx->data, text, length);
+    tx->data[length] = 0;
+
+    return queue(tx, length + 1);
+}
+
+int transmitter_send_packet(struct transmitter* tx, uint8_t flags, uint8_t sequence, uint8_t rate,
+    const uint8_t* payload, int length)
+{
+    int size;
+
+    if (transmitter_busy(tx) || length > PACKET_MAX_PAYLOAD)
+        return -1;
+
+    size = packet_build(tx->data, flags, sequence, rate, payload, length);
+    tx->data[size] = 0;
+
+    return queue(tx, size + 1);
+}
+
+//*****************************************************************************
+// Next channel bit of the message after the start byte, -1 at its end
+//*****************************************************************************
+static int next_bit(struct transmitter* tx)
+{
+    if (tx->bit == tx->bit_count) {
+        if (tx->byte >= tx->size)
+            return -1;
+        tx->bit_count = fec_encode_byte(&tx->encoder, tx->data[tx->byte++], tx->bits);
+        tx->bit = 0;
+    }
+
+    return tx->bits[tx->bit++];
+}
+
+//*****************************************************************************
+// Next bits bits of the message as one MFSK or DPSK symbol, the last one is
+// padded with zero bits. -1 at the end of the message.
+//*****************************************************************************
+static int next_symbol(struct transmitter* tx, int bits)
+{
+    int symbol = 0, bit = 0, i = 0;
+
+    for (i = 0; i < bits; i++) {
+        bit = next_bit(tx);
+        if (bit < 0 && !i)
+            return -1;
+        symbol = (symbol << 1) | (bit > 0);
+    }
+
+    return symbol;
+}
+
+//*****************************************************************************
+// Samples in nominal samples at the receiver's rate, as the transmitter clock
+// counts them. The fraction of a sample left over goes into the next symbol.
+//*****************************************************************************
+static int symbol_samples(struct transmitter* tx, int nominal)
+{
+    uint64_t per_sample = (uint64_t)PLAN_SAMPLE_RATE * (1000000 + tx->clock_ppm);
+    uint64_t total = (uint64_t)nominal * tx->sample_rate * 1000000 + tx->clock;
+
+    tx->clock = total % per_sample;
+    return (int)(total / per_sample);
+}
+
+//*****************************************************************************
+// A message that ends on a tone (MFSK always does) ramps down after it
+//*****************************************************************************
+static int end_message(struct transmitter* tx)
+{
+    if (!tx->keyed)
+        return -1;
+
+    tx->next_keyed = false;
+    tx->next_freq = tx->freq;
+    tx->next_samples = TX_LEAD_SAMPLES;
+    tx->next_ready = true;
+    return 0;
+}
+
+//*****************************************************************************
+// Set up the symbol after the current one. Returns -1 once the message is
+// over.
+//*****************************************************************************
+static int load_next(struct transmitter* tx)
+{
+    uint8_t symbols[OFDM_NUM_DATA];
+    int symbol = 0, bit = 0, bits = 0, i = 0;
+
+    tx->next_turn = 0;
+    tx->next_descriptor = false;
+    if (tx->start_bit < 8) {
+        if (tx->start_bit < RATE_DESCRIPTOR_BITS)
+            tx->next_descriptor = (tx->descriptor_code >> (RATE_DESCRIPTOR_BITS - 1 - tx->start_bit)) & 1;
+        tx->next_keyed = (TX_START_BYTE >> (7 - tx->start_bit++)) & 1;
+        tx->next_freq = SYNC_TONE_FREQ;
+        tx->next_samples = symbol_samples(tx, FRAMES_PER_BIT * NUM_SAMPLES);
+    } else if (tx->modulation == MFSK) {
+        symbol = next_symbol(tx, MFSK_BITS_PER_SYMBOL);
+        if (symbol < 0)
+            return end_message(tx);
+        tx->next_keyed = true;
+        tx->next_freq = MFSK_BASE_FREQ + symbol * MFSK_TONE_SPACING;
+        tx->next_samples = symbol_samples(tx, NUM_SAMPLES);
+    } else if (tx->modulation == DBPSK || tx->modulation == DQPSK) {
+        // The reference frames hold the phase, then every symbol turns it
+        bits = (tx->modulation == DQPSK) ? DQPSK_BITS_PER_SYMBOL : DBPSK_BITS_PER_SYMBOL;
+        if (tx->reference < DPSK_REFERENCE_FRAMES) {
+            tx->reference++;
+        } else {
+            symbol = next_symbol(tx, bits);
+            if (symbol < 0)
+                return end_message(tx);
+            tx->next_turn = (uint32_t)DPSK_GRAY(symbol) << (32 - bits);
+        }
+        tx->next_keyed = true;
+        tx->next_freq = DATA_TONE_FREQ;
+        tx->next_samples = symbol_samples(tx, NUM_SAMPLES);
+    } else if (tx->modulation == OFDM) {
+        // The last symbol is padded out with zero symbols
+        for (i = 0; i < OFDM_NUM_DATA; i++) {
+            symbol = next_symbol(tx, OFDM_BITS_PER_CARRIER);
+            if (symbol < 0 && !i)
+                return end_message(tx);
+            symbols[i] = (uint8_t)(((symbol < 0) ? 0 : symbol) ^ ofdm_scramble(&tx->scrambler, OFDM_BITS_PER_CARRIER));
+        }
+        ofdm_map(symbols, tx->next_turns);
+        tx->next_keyed = true;
+        tx->next_freq = 0;
+        tx->next_samples = symbol_samples(tx, OFDM_SYMBOL_SAMPLES);
+    } else {
+        bit = next_bit(tx);
+        if (bit < 0)
+            return end_message(tx);
+        tx->next_keyed = bit;
+        tx->next_freq = DATA_TONE_FREQ;
+        tx->next_samples = symbol_samples(tx, tx->frames_per_bit * NUM_SAMPLES);
+    }
+
+    tx->next_ready = true;
+    return 0;
+}
+
+//*****************************************************************************
+// Level of the next sample of a ramp with ramp samples to go, (1 - cos(pi t))
+// / 2 of the amplitude going up
+//*****************************************************************************
+static int ramp_level(struct transmitter* tx, int* ramp, bool up)
+{
+    uint32_t t = (uint32_t)(TX_RAMP_SAMPLES - (*ramp)--) * (0x80000000u / TX_RAMP_SAMPLES);
+    int32_t rise = (32768 - nco_sin(t + 0x40000000u)) >> 1;
+
+    return (int)((tx->amplitude * (up ? rise : 32768 - rise)) >> 15);
+}
+
+//*****************************************************************************
+// Add n samples of the descriptor to out. Its ramp runs on from the last
+// call, up if the next start bit is keyed.
+//*****************************************************************************
+static void add_descriptor(struct transmitter* tx, int16_t* out, int n)
+{
+    int32_t level, value;
+    int i = 0;
+
+    for (i = 0; i < n; i++) {
+        if (tx->descriptor_ramp)
+            level = ramp_level(tx, &tx->descriptor_ramp, tx->next_descriptor);
+        else
+            level = tx->descriptor ? tx->amplitude : 0;
+        value = out[i] + ((level * nco_sin(tx->descriptor_nco.phase)) >> 15);
+        tx->descriptor_nco.phase += tx->descriptor_nco.step;
+        out[i] = (int16_t)((value > 32767) ? 32767 : ((value < -32767) ? -32767 : value));
+    }
+}
+
+static void generate(struct transmitter* tx, int16_t* out, int n, int amplitude)
+{
+    if (tx->freq)
+        nco_generate(&tx->nco, out, n, amplitude);
+    else
+        ofdm_generate(tx, out, n, amplitude);
+}
+
+int transmitter_generate(struct transmitter* tx, int16_t* out, int n)
+{
+    int written = 0, count;
+
+    while (written < n) {
+        // Half a ramp before the boundary, see what comes next
+        if (!tx->next_ready && tx->samples_left <= TX_LEAD_SAMPLES && !load_next(tx)) {
+            if (tx->next_keyed != tx->keyed) {
+                tx->ramp = TX_RAMP_SAMPLES;
+                tx->ramp_up = tx->next_keyed;
+            }
+            if (tx->next_descriptor != tx->descriptor)
+                tx->descriptor_ramp = TX_RAMP_SAMPLES;
+        }
+
+        if (!tx->samples_left) {
+            if (!tx->next_ready)
+                break;
+            tx->keyed = tx->next_keyed;
+            tx->descriptor = tx->next_descriptor;
+            tx->samples_left = tx->next_samples;
+            tx->next_ready = false;
+            tx->nco.phase += tx->next_turn;
+
+            // The subcarriers run on through the ramp down after an OFDM message
+            if (tx->next_freq || tx->next_keyed)
+                set_tone(tx, tx->next_freq);
+            continue;
+        }
+
+        if (tx->ramp) {
+            count = 1;
+            generate(tx, out + written, count, ramp_level(tx, &tx->ramp, tx->ramp_up));
+        } else {
+            count = tx->samples_left;
+            if (!tx->next_ready && count > TX_LEAD_SAMPLES)
+                count -= TX_LEAD_SAMPLES;
+            if (count > n - written)
+                count = n - written;
+            generate(tx, out + written, count, tx->keyed ? tx->amplitude : 0);
+        }
+        if (tx->descriptor || tx->descriptor_ramp)
+            add_descriptor(tx, out + written, count);
+        tx->samples_left -= count;
+        written += count;
+    }
+
+    return written;
+}
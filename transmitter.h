@@ -0,0 +1,146 @@
+//*****************************************************************************
+//
+// transmitter.h - Reference transmitter for the receiver's protocol
+//
+// Github @devanshvaid - Devansh Vaid
+//
+//*****************************************************************************
+
+#ifndef TRANSMITTER_H_
+#define TRANSMITTER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "decoder.h"
+#include "nco.h"
+#include "ofdm.h"
+
+//*****************************************************************************
+// A transmission is what decoder.c expects: the start byte on the sync
+// carrier, on for a 1 and off for a 0, then the message on the data carrier
+// coded with the FEC code (OOK), as MFSK_BITS_PER_SYMBOL bit symbols of one
+// frame each (MFSK), as phase steps of the data carrier of one frame each
+// after DPSK_REFERENCE_FRAMES frames of it (DBPSK and DQPSK), or as scrambled
+// OFDM symbols of OFDM_BITS_PER_SYMBOL bits (OFDM). Only OOK is coded. Bits
+// are FRAMES_PER_BIT frames long (OOK data bits as long as the profile has
+// them) and go out MSB first. Text ends with a zero
+// byte, a packet is followed by one so a convolutional code gets past its
+// last bit.
+//
+// Every tone comes from one phase accumulator, so it never jumps in phase
+// other than by the step of a DPSK symbol, which is made at once at the start
+// of its frame. OFDM subcarriers have an accumulator each, set at the start
+// of every symbol so they reach their mapped phases where the receiver puts
+// its window. Together they carry the power of one tone of amplitude, their
+// rare peaks beyond 16 bits are clipped. Symbol lengths are counted in exact fractions of a sample, so
+// a transmission at any sample rate takes as long as at PLAN_SAMPLE_RATE with
+// no drift. OOK keying ramps up and down over TX_RAMP_SAMPLES with a raised
+// cosine centred on the edge, a hard edge splatters into the sync bin as a
+// false start sequence. A message therefore starts TX_LEAD_SAMPLES before
+// its first bit, with the first half of the ramp up.
+//
+// A profile other than RATE_DEFAULT is announced by keying the data carrier
+// along with the first start bits, from an accumulator of its own with the
+// same ramps. The message after the start byte then takes the modulation,
+// code and OOK bit length of the profile.
+//
+// The default amplitude is 256 counts on the 12 bit ADC once recorded at
+// full scale, below the 600 goertzel_bank16() can take.
+//*****************************************************************************
+#define TX_START_BYTE 0xAA
+#define TX_MAX_MESSAGE (PACKET_MAX_SIZE + 1)
+#define TX_DEFAULT_AMPLITUDE 4096
+#define TX_RAMP_SAMPLES 256
+#define TX_LEAD_SAMPLES (TX_RAMP_SAMPLES / 2)
+
+struct transmitter {
+    uint32_t sample_rate;
+    enum MODULATION modulation;
+    enum FEC_CODE coding;
+    int amplitude;                      // Peak of a tone, up to 32767
+    int32_t clock_ppm;                  // Error of the transmitter clock, scales tones and timing
+    int32_t freq_offset;                // Hz added to every tone
+    struct nco nco;
+
+    // Rate profile announced, see transmitter_set_profile()
+    int profile;
+    int frames_per_bit;                 // Of OOK data bits, the start byte has FRAMES_PER_BIT
+    enum MODULATION default_modulation;
+    enum FEC_CODE default_coding;
+
+    // Message being sent, start_bit counts the start byte off first
+    uint8_t data[TX_MAX_MESSAGE];
+    int size;
+    int byte;
+    int start_bit;
+    struct fec_encoder encoder;
+    uint8_t bits[16];                   // Channel bits of the current byte
+    int bit_count;
+    int bit;
+    int reference;                      // DPSK reference frames sent
+
+    // Symbol being sent, and the one after it, which is set up
+    // TX_LEAD_SAMPLES before the boundary so a ramp can start
+    bool keyed;
+    uint32_t freq;
+    int samples_left;
+    bool next_ready;
+    bool next_keyed;
+    uint32_t next_freq;
+    int next_samples;
+    uint32_t next_turn;                 // Phase step at the start of the next symbol, 2^32 a turn
+    int ramp;                           // Samples of the ramp still to go
+    bool ramp_up;
+    uint64_t clock;                     // Fraction of a sample carried over
+
+    // Descriptor on the data carrier during the start byte, keyed like the
+    // symbols with its own ramp
+    uint8_t descriptor_code;            // Hamming codeword of the profile
+    bool descriptor;
+    bool next_descriptor;
+    int descriptor_ramp;
+    struct nco descriptor_nco;
+
+    // OFDM symbols are sent as a tone of frequency 0, the subcarriers
+    uint8_t scrambler;
+    uint8_t next_turns[OFDM_NUM_BINS];  // Quarter turns of the next symbol
+    uint32_t carrier_phase[OFDM_NUM_BINS];
+    uint32_t carrier_step[OFDM_NUM_BINS];
+};
+
+//*****************************************************************************
+// Set up a transmitter writing samples at sample_rate. Returns -1 if a tone
+// of the modulation is not below Nyquist at that rate. amplitude, clock_ppm
+// and freq_offset can be changed before a message is queued.
+//*****************************************************************************
+int transmitter_init(struct transmitter* tx, uint32_t sample_rate, enum MODULATION modulation, enum FEC_CODE coding);
+
+//*****************************************************************************
+// Announce profile (one of rate_profiles) in the start sequence of the
+// messages queued from now on and send them with its modulation, code and
+// frames per bit. RATE_DEFAULT announces nothing and goes back to what
+// transmitter_init() was given. Returns -1 while a message is being sent,
+// for a profile that is not assigned or one with a tone above Nyquist.
+//*****************************************************************************
+int transmitter_set_profile(struct transmitter* tx, int profile);
+
+//*****************************************************************************
+// Queue text (without its stop byte, which is added) or a packet. Returns -1
+// if a message is still being sent or this one is too long.
+//*****************************************************************************
+int transmitter_send_text(struct transmitter* tx, const char* text, int length);
+int transmitter_send_packet(struct transmitter* tx, uint8_t flags, uint8_t sequence, uint8_t rate,
+    const uint8_t* payload, int length);
+
+//*****************************************************************************
+// True while a queued message has samples left
+//*****************************************************************************
+bool transmitter_busy(const struct transmitter* tx);
+
+//*****************************************************************************
+// Write up to n signed 16 bit samples of the message into out. Returns the
+// number written, fewer than n once the message is over.
+//*****************************************************************************
+int transmitter_generate(struct transmitter* tx, int16_t* out, int n);
+
+#endif // TRANSMITTER_H_